@@ -0,0 +1,43 @@
+# PGO training run (the cjyaml_pgo_train target): parse every YAML file of the corpus with the instrumented
+# cjyaml_bench, which drives the grow, pre-sized and context parse paths. Clang writes .profraw files that are
+# merged into PROFILE_DIR/cjyaml.profdata here; GCC reads its .gcda files from PROFILE_DIR directly.
+#
+#   cmake -DBENCH=<cjyaml_bench> -DCORPUS=<dir> -DPROFILE_DIR=<dir> [-DPROFDATA=<llvm-profdata>] [-DITERATIONS=<n>]
+#         -P PgoTrain.cmake
+
+if (NOT BENCH OR NOT CORPUS OR NOT PROFILE_DIR)
+    message(FATAL_ERROR "PgoTrain.cmake needs -DBENCH, -DCORPUS and -DPROFILE_DIR")
+endif()
+if (NOT ITERATIONS)
+    set(ITERATIONS 200)
+endif()
+
+file(GLOB corpus ${CORPUS}/*.yaml ${CORPUS}/*.yml)
+if (NOT corpus)
+    message(FATAL_ERROR "no YAML files in ${CORPUS}")
+endif()
+
+# counters of an earlier training run would be added to this one
+file(GLOB stale ${PROFILE_DIR}/*.gcda ${PROFILE_DIR}/*.profraw ${PROFILE_DIR}/cjyaml.profdata)
+if (stale)
+    file(REMOVE ${stale})
+endif()
+file(MAKE_DIRECTORY ${PROFILE_DIR})
+
+foreach (yaml ${corpus})
+    execute_process(COMMAND ${BENCH} ${yaml} ${ITERATIONS} RESULT_VARIABLE rc OUTPUT_QUIET)
+    if (NOT rc EQUAL 0)
+        message(FATAL_ERROR "training run failed on ${yaml} (${rc})")
+    endif()
+endforeach()
+
+if (PROFDATA)
+    file(GLOB raw ${PROFILE_DIR}/*.profraw)
+    execute_process(COMMAND ${PROFDATA} merge -o ${PROFILE_DIR}/cjyaml.profdata ${raw} RESULT_VARIABLE rc)
+    if (NOT rc EQUAL 0)
+        message(FATAL_ERROR "llvm-profdata merge failed (${rc})")
+    endif()
+endif()
+
+list(LENGTH corpus count)
+message(STATUS "PGO profile: ${count} corpus files x ${ITERATIONS} iterations -> ${PROFILE_DIR}")
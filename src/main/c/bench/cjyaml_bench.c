@@ -0,0 +1,93 @@
+/*
+ Parse benchmark: parses a YAML file N times with and without capacity pre-sizing, and with a reused
+ cjyaml_context, and reports the time per parse, the number of allocation calls and the bytes allocated by the
+ builder (for the last parse).
+
+   cjyaml_bench <file.yaml> [iterations]
+*/
+#include "CJYaml.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static unsigned char *read_file(const char *path, size_t *out_size) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    unsigned char *data = NULL;
+    size_t size = 0;
+    if (fseek(f, 0, SEEK_END) == 0) {
+        const long end = ftell(f);
+        if (end > 0 && fseek(f, 0, SEEK_SET) == 0) {
+            data = malloc((size_t)end);
+            size = data ? fread(data, 1, (size_t)end, f) : 0;
+        }
+    }
+    fclose(f);
+    *out_size = size;
+    return data;
+}
+
+static int run(const char *label, cjyaml_context *ctx, const unsigned char *data, const size_t size, const int iterations,
+               const uint32_t flags) {
+    cjyaml_parse_stats stats;
+    cjyaml_parse_options options;
+    memset(&options, 0, sizeof(options));
+    options.flags = flags;
+    options.stats = &stats;
+
+    size_t blob_size = 0;
+    const double start = now_seconds();
+    for (int i = 0; i < iterations; ++i) {
+        unsigned char *blob = NULL;
+        const int status = cjyaml_context_parse_buffer(ctx, data, size, &options, &blob, &blob_size);
+        if (status != CJYAML_OK) {
+            fprintf(stderr, "%s: parse failed (%d)\n", label, status);
+            return 1;
+        }
+        cjyaml_free_blob(blob);
+    }
+    const double per_parse = (now_seconds() - start) / iterations;
+
+    printf("%-10s %10.3f ms/parse %8.1f MB/s %10zu allocs %12zu bytes %12zu blob\n", label, per_parse * 1e3,
+           (double)size / per_parse / 1e6, stats.allocations, stats.bytes, blob_size);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <file.yaml> [iterations]\n", argv[0]);
+        return 2;
+    }
+    const int iterations = argc > 2 ? atoi(argv[2]) : 20;
+    size_t size = 0;
+    unsigned char *data = read_file(argv[1], &size);
+    if (!data || size == 0) {
+        fprintf(stderr, "cannot read %s\n", argv[1]);
+        free(data);
+        return 1;
+    }
+
+    cjyaml_capacity c;
+    cjyaml_estimate_capacity(data, size, &c);
+    printf("%s: %zu bytes, estimate %zu nodes %zu pairs %zu indices %zu strings %zu string bytes\n", argv[1], size,
+           c.nodes, c.pairs, c.indices, c.strings, c.string_bytes);
+
+    const int n = iterations > 0 ? iterations : 1;
+    int rc = run("grow", NULL, data, size, n, CJYAML_PARSE_NO_PRESIZE);
+    if (rc == 0) rc = run("presize", NULL, data, size, n, 0);
+    if (rc == 0) {
+        cjyaml_context *ctx = cjyaml_context_new();
+        rc = ctx ? run("context", ctx, data, size, n, 0) : 1;
+        cjyaml_context_free(ctx);
+    }
+    free(data);
+    return rc;
+}
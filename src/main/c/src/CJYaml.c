@@ -1,14 +1,21 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE // strtod_l
+#endif
+
 #include "CJYaml.h"
 
 #include <assert.h>
-#include <ctype.h>
+#include <errno.h>
 #include <limits.h>
+#include <math.h>
 #include <stdint.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <setjmp.h>
+#include <locale.h>
 
 
 #if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
@@ -21,8 +28,37 @@
     #define _CRT_SECURE_NO_WARNINGS
 #endif
 
-/* xxhash prototype - ensure xxhash library/header is available in build */
+// CJYAML_NO_SIMD builds the scalar fallbacks only (the native tests run them against the SSE2 paths)
+#if !defined(CJYAML_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    #include <emmintrin.h>
+    #define CJ_HAVE_SSE2 1
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #endif
+#endif
+
+#if defined(__APPLE__) || defined(__FreeBSD__)
+    #include <xlocale.h>
+#endif
+
+#if !defined(_WIN32)
+    #include <pthread.h>
+    #ifdef PATH_MAX
+        #define CJ_PATH_MAX PATH_MAX
+    #else
+        #define CJ_PATH_MAX 4096
+    #endif
+#else
+    #define CJ_PATH_MAX _MAX_PATH
+#endif
+
+MYLIB_API void *mapFile(const char *path, size_t *out_size);
+MYLIB_API int unmapFile(void *addr, size_t size);
+
+/* xxhash prototypes - ensure xxhash library/header is available in build */
 extern uint64_t XXH64(const void* input, size_t length, uint64_t seed);
+typedef struct { uint64_t low64; uint64_t high64; } XXH128_hash_t; // same layout as in xxhash.h
+extern XXH128_hash_t XXH3_128bits(const void* input, size_t length);
 
 /* -------------------------
     Parser
@@ -58,12 +94,151 @@ static void nodes_init(NodeVec *v) {
     v->cap = 0;
 }
 
+/* -------------------------
+   Allocation
+   -------------------------
+   Growth paths never terminate the process. While a parse runs, its thread has a BuildScope naming the builder
+   being filled: every allocation is charged to that builder's memory budget (max_bytes), and an allocation that
+   fails or would exceed the budget records a sticky status in the builder and unwinds to the scope's entry point
+   (longjmp). Everything the parse owns hangs off the builder or the parser state, so the entry point frees it and
+   returns the status. Outside a parse (walker, blob writer, JNI helpers) the helpers simply return NULL / false.
+   Memory comes from the builder's cjyaml_allocator inside a parse and from malloc outside one; cj_release frees
+   through the same rule, so a block must be released in the kind of scope it was allocated in (builder tables
+   are freed explicitly through bb->alloc).
+*/
+#if defined(_MSC_VER)
+    #define CJ_THREAD_LOCAL __declspec(thread)
+#else
+    #define CJ_THREAD_LOCAL _Thread_local
+#endif
+
+typedef struct BuildScope {
+    jmp_buf env;
+    BlobBuilder *bb;           // charged for allocations; receives the error status
+    struct BuildScope *outer;  // scope of an enclosing parse on this thread (nested !include)
+} BuildScope;
+
+static CJ_THREAD_LOCAL BuildScope *build_scope = NULL;
+
+static void *cj_default_malloc(void *user, const size_t size) {
+    (void)user;
+    return malloc(size);
+}
+
+static void *cj_default_realloc(void *user, void *ptr, const size_t old_size, const size_t new_size) {
+    (void)user;
+    (void)old_size;
+    return realloc(ptr, new_size);
+}
+
+static void cj_default_free(void *user, void *ptr) {
+    (void)user;
+    free(ptr);
+}
+
+static const cjyaml_allocator cj_default_allocator = { cj_default_malloc, cj_default_realloc, cj_default_free, NULL };
+
+// allocator of the running parse (malloc outside one)
+static const cjyaml_allocator *cj_current_allocator(void) {
+    return build_scope ? &build_scope->bb->alloc : &cj_default_allocator;
+}
+
+static void cj_free_with(const cjyaml_allocator *a, void *ptr) {
+    if (ptr) a->free_fn(a->user, ptr);
+}
+
+// free a block from cj_realloc / cj_calloc
+static void cj_release(void *ptr) {
+    cj_free_with(cj_current_allocator(), ptr);
+}
+
+static void build_fail(const int status) {
+    BuildScope *scope = build_scope;
+    if (!scope) return; // no parse running: the caller sees the NULL / false
+    if (scope->bb->status == CJYAML_OK) scope->bb->status = status;
+    longjmp(scope->env, 1);
+}
+
+// the byte count of a parse with !include files is shared by the include workers
+#if defined(_MSC_VER)
+    #define cj_atomic_add(p, n) ((size_t)InterlockedExchangeAddSizeT((p), (n)) + (n))
+    #define cj_atomic_load(p) ((size_t)InterlockedExchangeAddSizeT((p), 0))
+#else
+    #define cj_atomic_add(p, n) __atomic_add_fetch((p), (n), __ATOMIC_RELAXED)
+    #define cj_atomic_load(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#endif
+
+// bytes charged to the parse bb belongs to so far
+static size_t budget_used(const BlobBuilder *bb) {
+    return bb->parse_bytes ? cj_atomic_load(bb->parse_bytes) : bb->bytes;
+}
+
+// charge extra bytes to bb's parse; false if they do not fit max_bytes (nothing is charged then)
+static bool budget_charge(BlobBuilder *bb, const size_t extra) {
+    if (bb->max_bytes && extra > bb->max_bytes) return false;
+    if (!bb->parse_bytes) {
+        if (bb->max_bytes && bb->bytes > bb->max_bytes - extra) return false;
+    } else if (cj_atomic_add(bb->parse_bytes, extra) > bb->max_bytes && bb->max_bytes) {
+        cj_atomic_add(bb->parse_bytes, (size_t)0 - extra);
+        return false;
+    }
+    bb->bytes += extra;
+    return true;
+}
+
+// realloc from old_bytes to new_bytes, charged to the running parse
+static void *cj_realloc(void *ptr, const size_t old_bytes, const size_t new_bytes) {
+    BlobBuilder *bb = build_scope ? build_scope->bb : NULL;
+    const size_t extra = new_bytes > old_bytes ? new_bytes - old_bytes : 0;
+    if (bb && !budget_charge(bb, extra)) {
+        build_fail(CJYAML_ELIMIT);
+    }
+    const cjyaml_allocator *a = cj_current_allocator();
+    void *p = ptr ? a->realloc_fn(a->user, ptr, old_bytes, new_bytes) : a->malloc_fn(a->user, new_bytes);
+    if (!p) {
+        build_fail(CJYAML_ENOMEM);
+        return NULL;
+    }
+    if (bb) bb->allocs++;
+    return p;
+}
+
+static void *cj_calloc(const size_t count, const size_t elem_size) {
+    if (elem_size && count > SIZE_MAX / elem_size) {
+        build_fail(CJYAML_ENOMEM);
+        return NULL;
+    }
+    void *p = cj_realloc(NULL, 0, count * elem_size);
+    if (p) memset(p, 0, count * elem_size);
+    return p;
+}
+
+/*
+ Run fn(arg) as a parse into bb: allocation failures inside it unwind back here.
+ Returns false (bb->status says why) if it did not complete. State that fn's allocations hang off must live
+ outside this frame (the caller's), since locals of the setjmp frame are indeterminate after the longjmp.
+*/
+static bool build_guarded(BlobBuilder *bb, void (*fn)(void *), void *arg) {
+    BuildScope scope;
+    scope.bb = bb;
+    scope.outer = build_scope;
+    build_scope = &scope;
+    if (setjmp(scope.env)) {
+        build_scope = scope.outer;
+        return false;
+    }
+    fn(arg);
+    build_scope = scope.outer;
+    return bb->status == CJYAML_OK;
+}
+
 // Helper to grow a dynamic array if needed
 // - data_ptr: pointer to the array pointer (e.g., &vec->data)
 // - count: current number of elements
 // - cap_ptr: pointer to the current capacity
 // - elem_size: size of one element in bytes
-static void grow_array_if_needed(void **data_ptr, const size_t count, size_t *cap_ptr, const size_t elem_size) {
+// Returns false if the array could not grow (only outside a parse; inside one the failure unwinds).
+static bool grow_array_if_needed(void **data_ptr, const size_t count, size_t *cap_ptr, const size_t elem_size) {
     if (count == *cap_ptr) {
         size_t new_capacity;
         if (*cap_ptr < 1024) {
@@ -73,29 +248,37 @@ static void grow_array_if_needed(void **data_ptr, const size_t count, size_t *ca
         } else {
             new_capacity = *cap_ptr + (*cap_ptr / 5);
         }
-        void *data_tmp = realloc(*data_ptr, new_capacity * elem_size);
+        if (new_capacity > SIZE_MAX / elem_size) {
+            build_fail(CJYAML_ENOMEM);
+            return false;
+        }
+        void *data_tmp = cj_realloc(*data_ptr, *cap_ptr * elem_size, new_capacity * elem_size);
         if (!data_tmp) {
-            exit(EXIT_FAILURE);
+            return false;
         }
         *data_ptr = data_tmp;
         *cap_ptr = new_capacity;
     }
+    return true;
 }
 
 
-static void nodes_push(NodeVec *vec, const NodeEntry node) {
-    grow_array_if_needed((void**)&vec->data, vec->count, &vec->cap, sizeof(NodeEntry));
+static bool nodes_push(NodeVec *vec, const NodeEntry node) {
+    if (!grow_array_if_needed((void**)&vec->data, vec->count, &vec->cap, sizeof(NodeEntry))) return false;
     vec->data[vec->count++] = node;
+    return true;
 }
 
-static void pairs_push(PairVec *vec, const PairEntry pair) {
-    grow_array_if_needed((void**)&vec->data, vec->count, &vec->cap, sizeof(PairEntry));
+static bool pairs_push(PairVec *vec, const PairEntry pair) {
+    if (!grow_array_if_needed((void**)&vec->data, vec->count, &vec->cap, sizeof(PairEntry))) return false;
     vec->data[vec->count++] = pair;
+    return true;
 }
 
-static void index_push(IndexVec *vec, const uint32_t value) {
-    grow_array_if_needed((void**)&vec->data, vec->count, &vec->cap, sizeof(uint32_t));
+static bool index_push(IndexVec *vec, const uint32_t value) {
+    if (!grow_array_if_needed((void**)&vec->data, vec->count, &vec->cap, sizeof(uint32_t))) return false;
     vec->data[vec->count++] = value;
+    return true;
 }
 
 
@@ -116,142 +299,344 @@ static void index_init(IndexVec *v) {
 
 
 
-static void strings_init(StringVec *v) { v->data = NULL; v->lens = NULL; v->count = 0; v->cap = 0; }
+/* -------------------------
+   String arena
+   -------------------------*/
+
+static void strings_init(StringArena *sa) {
+    sa->data = NULL;
+    sa->size = 0;
+    sa->cap = 0;
+    sa->slots = NULL;
+    sa->slot_count = 0;
+    sa->slot_cap = 0;
+}
 
+static void strings_free(StringArena *sa, const cjyaml_allocator *a) {
+    cj_free_with(a, sa->data);
+    cj_free_with(a, sa->slots);
+    strings_init(sa);
+}
 
+static uint64_t strings_hash(const char *s, const size_t len) {
+    const uint64_t h = XXH64(s, len, 0);
+    return h ? h : 1; // 0 marks an empty slot
+}
 
-static void strings_push(StringVec *vec, const char *str, const size_t len) {
-    /* Ensure capacity for both arrays at once */
-    if (vec->count == vec->cap) {
-        size_t new_capacity;
-        if (vec->cap < 1024) {
-            new_capacity = vec->cap ? (vec->cap * 2) : 16;
-        } else if (vec->cap < 10000) {
-            new_capacity = vec->cap + (vec->cap / 2);
-        } else {
-            new_capacity = vec->cap + (vec->cap / 5);
+// make room for `extra` bytes after the committed strings and return the arena base (may move)
+static char *strings_reserve(StringArena *sa, const size_t extra) {
+    if (extra > sa->cap - sa->size) {
+        size_t new_capacity = sa->cap ? sa->cap : 256;
+        while (extra > new_capacity - sa->size) {
+            new_capacity += new_capacity / 2;
         }
-
-        /* Realloc both arrays; do them separately but based on same new_capacity.
-           If one fails, free the other and abort (fail fast). */
-        char **data_tmp = realloc(vec->data, new_capacity * sizeof(char *));
+        char *data_tmp = cj_realloc(sa->data, sa->cap, new_capacity);
         if (!data_tmp) {
-            exit(EXIT_FAILURE);
+            return NULL;
         }
-        vec->data = data_tmp;
+        sa->data = data_tmp;
+        sa->cap = new_capacity;
+    }
+    return sa->data;
+}
 
-        size_t *lens_tmp = realloc(vec->lens, new_capacity * sizeof(size_t));
-        if (!lens_tmp) {
-            /* try to revert data allocation to keep consistent state (best-effort) */
-            /* (we already replaced vec->data; to be safe exit) */
-            exit(EXIT_FAILURE);
-        }
-        vec->lens = lens_tmp;
+// rehash into a table of new_capacity slots (a power of two larger than the current one)
+static void strings_resize_slots(StringArena *sa, const size_t new_capacity) {
+    StringSlot *slots = cj_calloc(new_capacity, sizeof(StringSlot));
+    if (!slots) {
+        return;
+    }
+    for (size_t i = 0; i < sa->slot_cap; ++i) {
+        if (!sa->slots[i].hash) continue;
+        size_t j = (size_t)sa->slots[i].hash & (new_capacity - 1);
+        while (slots[j].hash) j = (j + 1) & (new_capacity - 1);
+        slots[j] = sa->slots[i];
+    }
+    cj_release(sa->slots);
+    sa->slots = slots;
+    sa->slot_cap = new_capacity;
+}
+
+static void strings_grow_slots(StringArena *sa) {
+    strings_resize_slots(sa, sa->slot_cap ? sa->slot_cap * 2 : 64);
+}
 
-        vec->cap = new_capacity;
+// look up `s` (which may live in the arena tail); returns its slot (empty if not present)
+static StringSlot *strings_lookup(StringArena *sa, const char *s, const size_t len, const uint64_t h) {
+    if ((sa->slot_count + 1) * 2 > sa->slot_cap) strings_grow_slots(sa);
+    size_t i = (size_t)h & (sa->slot_cap - 1);
+    for (;;) {
+        StringSlot *slot = &sa->slots[i];
+        if (!slot->hash) return slot;
+        if (slot->hash == h && slot->len == len && memcmp(sa->data + slot->offset, s, len) == 0) return slot;
+        i = (i + 1) & (sa->slot_cap - 1);
     }
+}
 
-    /* Allocate and store string copy */
-    char *copy = malloc(len ? len + 1 : 1);
-    if (!copy) {
-        exit(EXIT_FAILURE);
+// commit the `len` bytes written at the arena tail (data + size); returns their offset, or the offset of an
+// identical string already in the arena, in which case the tail is simply dropped
+static uint64_t strings_commit_tail(StringArena *sa, const size_t len) {
+    strings_reserve(sa, len ? len : 1); // data must exist even for the empty string
+    const char *tail = sa->data + sa->size;
+    const uint64_t h = strings_hash(tail, len);
+    StringSlot *slot = strings_lookup(sa, tail, len, h);
+    if (!slot->hash) {
+        slot->hash = h;
+        slot->offset = sa->size;
+        slot->len = len;
+        sa->slot_count++;
+        sa->size += len;
     }
-    if (len) memcpy(copy, str, len);
-    copy[len] = '\0';
+    return slot->offset;
+}
 
-    vec->data[vec->count] = copy;
-    vec->lens[vec->count] = len;
-    vec->count++;
+// intern a string that lives outside the arena; returns its offset in the string table
+static uint64_t strings_intern(StringArena *sa, const char *s, const size_t len) {
+    strings_reserve(sa, len ? len : 1);
+    const uint64_t h = strings_hash(s, len);
+    StringSlot *slot = strings_lookup(sa, s, len, h);
+    if (!slot->hash) {
+        if (len) memcpy(sa->data + sa->size, s, len);
+        slot->hash = h;
+        slot->offset = sa->size;
+        slot->len = len;
+        sa->slot_count++;
+        sa->size += len;
+    }
+    return slot->offset;
 }
 
 
+static void hash_init(HashVec *v) {
+    v->data = NULL;
+    v->count = 0;
+    v->cap = 0;
+}
+
 
+static void values_init(ValueVec *v) {
+    v->data = NULL;
+    v->count = 0;
+    v->cap = 0;
+}
 
+static bool values_push(ValueVec *vec, const ScalarValue value) {
+    if (!grow_array_if_needed((void**)&vec->data, vec->count, &vec->cap, sizeof(ScalarValue))) return false;
+    vec->data[vec->count++] = value;
+    return true;
+}
 
-static void hash_init(HashVec *v) {
+static void tags_init(TagVec *v) {
     v->data = NULL;
     v->count = 0;
     v->cap = 0;
+    v->slots = NULL;
+    v->slot_cap = 0;
 }
-static void hash_push(HashVec *v, const HashEntry h) {
-    if (v->count == v->cap) {
-        const size_t nc = v->cap ? v->cap * 2 : 16;
-        HashEntry* data_tmp = realloc(v->data, nc * sizeof(HashEntry));
-        if (!data_tmp) {
-            exit(EXIT_FAILURE);
-        }
-        v->data = data_tmp;
-        v->cap = nc;
-    }
-    v->data[v->count++] = h;
+
+static void tags_free(TagVec *v, const cjyaml_allocator *a) {
+    cj_free_with(a, v->data);
+    cj_free_with(a, v->slots);
+    tags_init(v);
 }
 
+// slot of the tag whose text starts at name_offset (the arena deduplicates, so the offset identifies the text)
+static uint16_t *tags_slot(const TagVec *v, const uint64_t name_offset) {
+    size_t i = (size_t)(name_offset * 0x9E3779B97F4A7C15ULL >> 32) & (v->slot_cap - 1);
+    while (v->slots[i] && v->data[v->slots[i] - 1].name_offset != name_offset) i = (i + 1) & (v->slot_cap - 1);
+    return &v->slots[i];
+}
 
-// Find string in StringVec (linear scan) -> return offset into string table (to be computed later).
-// We store dedup keys as the string bytes themselves; for offset we compute cumulative sizes later.
-static ssize_t strings_find(const StringVec *v, const char *s, const size_t len) {
-    for (size_t i=0;i<v->count;i++){
-        if (v->lens[i] == len && memcmp(v->data[i], s, len)==0) return (ssize_t)i;
+/*
+ Drop the tags interned after the first count. They were inserted after every tag kept (a rehash reinserts in
+ index order too), so no kept tag probes past their slots and clearing them keeps the table consistent.
+*/
+static void tags_truncate(TagVec *v, const size_t count) {
+    if (v->count <= count) return;
+    for (size_t i = 0; i < v->slot_cap; ++i) {
+        if (v->slots[i] > count) v->slots[i] = 0;
     }
-    return SIZE_MAX;
+    v->count = count;
 }
 
+
 static void builder_init(BlobBuilder *bb) {
     nodes_init(&bb->nodes);
     pairs_init(&bb->pairs);
     index_init(&bb->indices);
     strings_init(&bb->strings);
+    values_init(&bb->values);
+    tags_init(&bb->tags);
+    bb->bytes = 0;
+    bb->max_bytes = 0;
+    bb->parse_bytes = NULL;
+    bb->allocs = 0;
+    bb->presize = 1;
+    bb->status = CJYAML_OK;
+    bb->alloc = cj_default_allocator;
 }
 
+// free the tables (through bb->alloc) and leave bb empty; the allocator is kept
 static void builder_free(BlobBuilder *bb) {
-    if (bb->nodes.data) {
-        free(bb->nodes.data);
-        bb->nodes.data = NULL;
-    }
-    if (bb->pairs.data) {
-        free(bb->pairs.data);
-        bb->pairs.data = NULL;
-    }
-    if (bb->indices.data) {
-        free(bb->indices.data);
-        bb->indices.data = NULL;
-    }
-    if (bb->strings.data) {
-        for (size_t i=0;i<bb->strings.count;i++) {
-            free(bb->strings.data[i]);
-            bb->strings.data[i] = NULL;
-        }
-        free(bb->strings.data);
-        bb->strings.data = NULL;
+    const cjyaml_allocator a = bb->alloc;
+    cj_free_with(&a, bb->nodes.data);
+    cj_free_with(&a, bb->pairs.data);
+    cj_free_with(&a, bb->indices.data);
+    strings_free(&bb->strings, &a);
+    tags_free(&bb->tags, &a);
+    cj_free_with(&a, bb->values.data);
+    builder_init(bb);
+    bb->alloc = a;
+}
+
+// empty bb for the next parse, keeping every table's capacity (the hash slots are cleared, not freed)
+static void builder_reset(BlobBuilder *bb) {
+    bb->nodes.count = 0;
+    bb->pairs.count = 0;
+    bb->indices.count = 0;
+    bb->values.count = 0;
+    bb->strings.size = 0;
+    if (bb->strings.slot_count) memset(bb->strings.slots, 0, bb->strings.slot_cap * sizeof(StringSlot));
+    bb->strings.slot_count = 0;
+    if (bb->tags.count) memset(bb->tags.slots, 0, bb->tags.slot_cap * sizeof(uint16_t));
+    bb->tags.count = 0;
+    bb->bytes = 0;
+    bb->max_bytes = 0;
+    bb->parse_bytes = NULL;
+    bb->allocs = 0;
+    bb->presize = 1;
+    bb->status = CJYAML_OK;
+}
+
+/* -------------------------
+   Capacity pre-sizing
+   -------------------------
+   A pre-scan counts the structural characters of the input and the tables are reserved from it once, so a
+   large document does not walk every table through its whole growth sequence (and copy it each time).
+   The counts over-estimate plain block YAML only slightly; an under-estimate just falls back to growth.
+*/
+
+// grow an array to hold at least `want` elements (never shrinks)
+static void reserve_array(void **data_ptr, size_t *cap_ptr, const size_t want, const size_t elem_size) {
+    if (want <= *cap_ptr) return;
+    if (want > SIZE_MAX / elem_size) {
+        build_fail(CJYAML_ENOMEM);
+        return;
     }
-    if (bb->strings.lens) {
-        free(bb->strings.lens);
-        bb->strings.lens = NULL;
+    void *data_tmp = cj_realloc(*data_ptr, *cap_ptr * elem_size, want * elem_size);
+    if (!data_tmp) return;
+    *data_ptr = data_tmp;
+    *cap_ptr = want;
+}
+
+// slot table size that keeps `strings` entries at load factor <= 1/2
+static size_t strings_slot_capacity(const size_t strings) {
+    size_t cap = 64;
+    while (cap < SIZE_MAX / 4 && cap < (strings + 1) * 2) cap *= 2;
+    return cap;
+}
+
+static void builder_reserve(BlobBuilder *bb, const cjyaml_capacity *c) {
+    reserve_array((void**)&bb->nodes.data, &bb->nodes.cap, c->nodes, sizeof(NodeEntry));
+    reserve_array((void**)&bb->pairs.data, &bb->pairs.cap, c->pairs, sizeof(PairEntry));
+    reserve_array((void**)&bb->indices.data, &bb->indices.cap, c->indices, sizeof(uint32_t));
+    reserve_array((void**)&bb->strings.data, &bb->strings.cap, c->string_bytes, 1);
+    const size_t slots = strings_slot_capacity(c->strings);
+    if (c->strings && slots > bb->strings.slot_cap) strings_resize_slots(&bb->strings, slots);
+}
+
+static void estimate_capacity(const unsigned char *d, const size_t size, cjyaml_capacity *out) {
+    size_t lines = 1, colons = 0, dashes = 0, commas = 0, opens = 0;
+    for (size_t i = 0; i < size; ++i) {
+        switch (d[i]) {
+            case '\n': ++lines; break;
+            case ':': colons += i + 1 == size || d[i + 1] == ' ' || d[i + 1] == '\n' || d[i + 1] == '\r'; break;
+            case '-': dashes += i + 1 == size || d[i + 1] == ' ' || d[i + 1] == '\n' || d[i + 1] == '\r'; break;
+            case ',': ++commas; break;
+            case '[': case '{': ++opens; break;
+            default: break;
+        }
     }
+    // every pair has a key and a value node, every sequence / flow entry one node; +2 for root and document.
+    // The +16 slack matches the first growth step, so small documents do not reallocate right away.
+    const size_t items = dashes + commas + opens;
+    out->pairs = colons + 16;
+    out->indices = items + 16;
+    out->nodes = 2 * colons + items + 2 + 16;
+    out->strings = out->nodes / 2 < lines ? out->nodes / 2 : lines; // keys repeat, and most lines hold one value
+    out->string_bytes = size / 2 + 64;
 }
 
-static uint64_t builder_add_string(BlobBuilder *bb, const char *s, const size_t len) {
-    const size_t idx = strings_find(&bb->strings, s, len);
-    if (idx != SIZE_MAX) return idx;  // found, return existing index
-    strings_push(&bb->strings, s, len);
-    return (bb->strings.count - 1);
+// bytes builder_reserve would allocate on top of what bb already holds
+static size_t capacity_bytes(const BlobBuilder *bb, const cjyaml_capacity *c) {
+    size_t total = 0;
+    if (c->nodes > bb->nodes.cap) total += (c->nodes - bb->nodes.cap) * sizeof(NodeEntry);
+    if (c->pairs > bb->pairs.cap) total += (c->pairs - bb->pairs.cap) * sizeof(PairEntry);
+    if (c->indices > bb->indices.cap) total += (c->indices - bb->indices.cap) * sizeof(uint32_t);
+    if (c->string_bytes > bb->strings.cap) total += c->string_bytes - bb->strings.cap;
+    const size_t slots = strings_slot_capacity(c->strings);
+    if (c->strings && slots > bb->strings.slot_cap) total += slots * sizeof(StringSlot);
+    return total;
 }
 
+// reserve bb for parsing data, unless the estimate alone would not fit the memory budget
+static void builder_presize(BlobBuilder *bb, const unsigned char *data, const size_t size) {
+    cjyaml_capacity c;
+    estimate_capacity(data, size, &c);
+    if (bb->max_bytes) {
+        const size_t need = capacity_bytes(bb, &c);
+        if (need > bb->max_bytes || budget_used(bb) > bb->max_bytes - need) return;
+    }
+    builder_reserve(bb, &c);
+}
 
-// add scalar node; but NodeEntry->a/b must be offset/len in string table.
-// We'll temporarily store a = index of string in bb->strings; b = length. Later we convert a to absolute offset.
-static uint32_t builder_add_scalar(BlobBuilder *bb, const char *s, const size_t len, const uint8_t style_flags, const uint16_t tag_index) {
-    const uint64_t str_index = builder_add_string(bb, s, len);
+// add scalar node for a string already in the arena: a = offset in the string table, b = length
+static uint32_t builder_add_scalar_at(BlobBuilder *bb, const uint64_t offset, const size_t len, const uint8_t style_flags, const uint16_t tag_index) {
     NodeEntry n;
     n.node_type = SCALAR;
     n.style_flags = style_flags;
     n.tag_index = tag_index;
-    n.a = str_index; // temporarily store string index
+    n.a = offset;
     n.b = len;
     nodes_push(&bb->nodes, n);
     return (uint32_t)(bb->nodes.count - 1);
 }
 
+// add scalar node, interning its text in the string arena
+static uint32_t builder_add_scalar(BlobBuilder *bb, const char *s, const size_t len, const uint8_t style_flags, const uint16_t tag_index) {
+    return builder_add_scalar_at(bb, strings_intern(&bb->strings, s, len), len, style_flags, tag_index);
+}
+
+// intern an explicit tag; returns its 1-based tag_index, or 0 once CJYAML_MAX_TAGS distinct tags exist
+static uint16_t builder_intern_tag(BlobBuilder *bb, const char *s, const size_t len) {
+    TagVec *v = &bb->tags;
+    const uint64_t name_offset = strings_intern(&bb->strings, s, len);
+    if ((v->count + 1) * 2 > v->slot_cap) {
+        const size_t new_capacity = v->slot_cap ? v->slot_cap * 2 : 16;
+        uint16_t *slots = cj_calloc(new_capacity, sizeof(uint16_t));
+        if (!slots) {
+            return 0;
+        }
+        cj_release(v->slots);
+        v->slots = slots;
+        v->slot_cap = new_capacity;
+        for (size_t i = 0; i < v->count; ++i) *tags_slot(v, v->data[i].name_offset) = (uint16_t)(i + 1);
+    }
+    uint16_t *slot = tags_slot(v, name_offset);
+    if (*slot) return *slot;
+    if (v->count >= CJYAML_MAX_TAGS) return 0;
+
+    if (!grow_array_if_needed((void**)&v->data, v->count, &v->cap, sizeof(TagEntry))) return 0;
+    TagEntry t;
+    t.name_offset = name_offset;
+    t.name_len = (uint32_t)len;
+    t.node_count = 0;
+    t.first_node = 0;
+    v->data[v->count++] = t;
+    *slot = (uint16_t)v->count;
+    return *slot;
+}
+
 // append pair (key_node_index, value_node_index)
 static uint32_t builder_append_pair(BlobBuilder *bb, const uint32_t key_idx, const uint32_t val_idx) {
     PairEntry p;
@@ -276,6 +661,62 @@ static uint32_t builder_add_sequence(BlobBuilder *bb, const uint32_t *elements,
 }
 
 
+// add mapping node: a=first_pair_index (pairs must already be contiguous in the pair table), b=pair_count
+static uint32_t builder_add_mapping(BlobBuilder *bb, const uint64_t first_pair, const size_t pair_count, const uint8_t style_flags) {
+    NodeEntry n;
+    n.node_type = MAPPING;
+    n.style_flags = style_flags;
+    n.tag_index = 0;
+    n.a = first_pair;
+    n.b = pair_count;
+    nodes_push(&bb->nodes, n);
+    return (uint32_t)(bb->nodes.count - 1);
+}
+
+
+#define CJYAML_MAX_ALIAS_HOPS 64
+
+static uint32_t builder_resolve_alias(const BlobBuilder *bb, uint32_t node) {
+    for (int hops = 0; hops <= CJYAML_MAX_ALIAS_HOPS && node < bb->nodes.count && bb->nodes.data[node].node_type == ALIAS; ++hops) {
+        node = (uint32_t)bb->nodes.data[node].a;
+    }
+    return node;
+}
+
+// a merge value must be a mapping or a sequence of mappings (each possibly behind an alias)
+static bool builder_is_mergeable(const BlobBuilder *bb, const uint32_t value) {
+    const uint32_t v = builder_resolve_alias(bb, value);
+    if (v >= bb->nodes.count) return false;
+    const NodeEntry *n = &bb->nodes.data[v];
+    if (n->node_type == MAPPING) return true;
+    if (n->node_type != SEQUENCE) return false;
+    for (uint64_t i = 0; i < n->b; ++i) {
+        const uint32_t item = builder_resolve_alias(bb, bb->indices.data[n->a + i]);
+        if (item >= bb->nodes.count || bb->nodes.data[item].node_type != MAPPING) return false;
+    }
+    return n->b > 0;
+}
+
+/*
+ Turn the '<<' pair at position merge_at of the mapping's range [first, first+count) into its merge link: the
+ pair is rotated to the front (the others keep their order) and MAPPING_MERGE is returned. Returns 0 and leaves
+ the pairs alone when there is no merge key (SIZE_MAX) or its value cannot be merged (then it is a normal pair).
+*/
+static uint8_t builder_place_merge(BlobBuilder *bb, const uint64_t first, const size_t count, const size_t merge_at) {
+    if (merge_at >= count) return 0;
+    PairEntry *pairs = bb->pairs.data + first;
+    const PairEntry merge = pairs[merge_at];
+    if (!builder_is_mergeable(bb, merge.value_node_index)) return 0;
+    memmove(pairs + 1, pairs, merge_at * sizeof(PairEntry));
+    pairs[0] = merge;
+    return MAPPING_MERGE;
+}
+
+static bool is_merge_key(const unsigned char *s, const size_t len) {
+    return len == 2 && s[0] == '<' && s[1] == '<';
+}
+
+
 // comparator (file-scope) used by qsort
 static int cmp_hashentry(const void *pa, const void *pb) {
     const HashEntry *a = (const HashEntry*)pa;
@@ -287,50 +728,103 @@ static int cmp_hashentry(const void *pa, const void *pb) {
     return 0;
 }
 
-// Build blob in-memory (returns malloc'd buffer) — replace the file-writing section with this.
-// Caller must free(*out_buf) when done.
-static unsigned char *builder_build_to_memory(const BlobBuilder *bb, size_t *out_size, const uint32_t magic, const uint16_t version, const uint32_t flags, const int include_hash_index) {
-    if (!out_size) return NULL;
-    *out_size = 0;
+/*
+ Blobs carry a copy of their allocator in a prefix in front of the header, so cjyaml_free_blob can hand each
+ blob back to the allocator that made it. The prefix keeps the blob 16-byte aligned.
+*/
+typedef struct {
+    cjyaml_allocator alloc;
+    size_t size; // blob bytes after the prefix
+} BlobPrefix;
+
+#define CJ_BLOB_PREFIX ((sizeof(BlobPrefix) + 15) & ~(size_t)15)
+
+static unsigned char *blob_alloc(const cjyaml_allocator *a, const size_t size) {
+    unsigned char *base = a->malloc_fn(a->user, CJ_BLOB_PREFIX + size);
+    if (!base) return NULL;
+    BlobPrefix prefix;
+    prefix.alloc = *a;
+    prefix.size = size;
+    memcpy(base, &prefix, sizeof(prefix));
+    return base + CJ_BLOB_PREFIX;
+}
 
-    // Build string table
-    size_t string_table_size = 0;
-    for (size_t i = 0; i < bb->strings.count; ++i) string_table_size += bb->strings.lens[i];
-
-    uint8_t *string_table = NULL;
-    uint64_t *string_offsets = NULL;
-    if (string_table_size) {
-        string_table = (uint8_t*)malloc(string_table_size);
-        if (!string_table) return NULL;
-        string_offsets = (uint64_t*)malloc(bb->strings.count * sizeof(uint64_t));
-        if (!string_offsets) { free(string_table); return NULL; }
-
-        size_t cursor = 0;
-        for (size_t i = 0; i < bb->strings.count; ++i) {
-            string_offsets[i] = cursor;
-            memcpy(string_table + cursor, bb->strings.data[i], bb->strings.lens[i]);
-            cursor += bb->strings.lens[i];
-        }
-        if (cursor != string_table_size) { free(string_table); free(string_offsets); return NULL; }
-    }
+/* -------------------------
+   Blob sections and checksums
+   ------------------------- */
+static bool table_fits(const uint64_t offset, const uint64_t count, const uint64_t elem_size, const size_t blob_size) {
+    return offset <= blob_size && count <= (blob_size - offset) / elem_size;
+}
 
-    // Convert scalar node string indices -> absolute offsets
-    for (size_t i = 0; i < bb->nodes.count; ++i) {
-        NodeEntry *n = &bb->nodes.data[i];
-        if (n->node_type == 0) {
-            const uint64_t str_index = n->a;
-            if (str_index >= bb->strings.count) {
-                n->a = 0; n->b = 0;
-            } else {
-                if (!string_offsets) { free(string_table); free(string_offsets); return NULL; }
-                n->a = string_offsets[str_index];
+/*
+ Byte range of a section (CJYAML_SECTION_*); false if it does not lie inside the blob. Absent sections are
+ empty. The tag section is the tag entries plus the tag node list, i.e. everything up to the string table.
+*/
+static bool blob_section_span(const HeaderBlob *h, const size_t blob_size, const int section, uint64_t *off, uint64_t *len) {
+    uint64_t o = 0, count = 0, elem = 1;
+    switch (section) {
+        case CJYAML_SECTION_HEADER:  count = sizeof(HeaderBlob); break;
+        case CJYAML_SECTION_NODES:   o = h->node_table_offset;   count = h->node_count;      elem = sizeof(NodeEntry); break;
+        case CJYAML_SECTION_PAIRS:   o = h->pair_table_offset;   count = h->pair_count;      elem = sizeof(PairEntry); break;
+        case CJYAML_SECTION_INDEX:   o = h->index_table_offset;  count = h->index_count;     elem = sizeof(uint32_t); break;
+        case CJYAML_SECTION_HASH:    o = h->hash_index_offset;   count = h->hash_index_size; elem = sizeof(HashEntry); break;
+        case CJYAML_SECTION_VALUES:  o = h->value_table_offset;  count = h->value_count;     elem = sizeof(uint64_t); break;
+        case CJYAML_SECTION_TAGS:
+            if (h->tag_count) {
+                o = h->tag_table_offset;
+                if (h->string_table_offset < o) return false;
+                count = h->string_table_offset - o;
             }
-        }
+            break;
+        case CJYAML_SECTION_STRINGS: o = h->string_table_offset; count = h->string_table_size; break;
+        default: return false;
+    }
+    if (count == 0) o = 0;
+    if (!table_fits(o, count, elem, blob_size)) return false;
+    *off = o;
+    *len = count * elem;
+    return true;
+}
+
+// Offset of the checksum table; false if the blob has none or it does not fit.
+static bool blob_checksum_offset(const HeaderBlob *h, const size_t blob_size, uint64_t *off) {
+    if (!(h->flags & CJYAML_FLAG_CHECKSUM) || !table_fits(h->string_table_offset, h->string_table_size, 1, blob_size)) return false;
+    *off = h->string_table_offset + h->string_table_size;
+    return table_fits(*off, CJYAML_SECTION_COUNT, sizeof(ChecksumEntry), blob_size);
+}
+
+// XXH3-128 of every section (one sequential pass each); false if a section does not fit the blob.
+static bool blob_section_digests(const unsigned char *blob, const size_t blob_size, const HeaderBlob *h, ChecksumEntry out[CJYAML_SECTION_COUNT]) {
+    for (int i = 0; i < CJYAML_SECTION_COUNT; ++i) {
+        uint64_t off, len;
+        if (!blob_section_span(h, blob_size, i, &off, &len)) return false;
+        const XXH128_hash_t d = XXH3_128bits(blob + off, (size_t)len);
+        out[i].low64 = d.low64;
+        out[i].high64 = d.high64;
     }
+    return true;
+}
+
+// Build blob in-memory (allocated through bb->alloc with a BlobPrefix).
+// Caller must release it with cjyaml_free_blob() when done.
+static unsigned char *builder_build_to_memory(const BlobBuilder *bb, size_t *out_size, const uint32_t magic, const uint16_t version, const uint32_t flags, const int include_hash_index) {
+    if (!out_size) return NULL;
+    *out_size = 0;
+
+    // The string arena already is the string table (deduplicated, scalar offsets final)
+    const uint8_t *string_table = (const uint8_t *)bb->strings.data;
+    const size_t string_table_size = bb->strings.size;
 
     // Build hash entries
+    const cjyaml_allocator *a = &bb->alloc;
     HashVec hvec;
     hash_init(&hvec);
+    if (include_hash_index && bb->pairs.count) {
+        // at most one entry per pair: allocate once
+        hvec.data = a->malloc_fn(a->user, bb->pairs.count * sizeof(HashEntry));
+        if (!hvec.data) return NULL;
+        hvec.cap = bb->pairs.count;
+    }
     if (include_hash_index) {
         for (uint32_t i = 0; i < bb->pairs.count; ++i) {
             const PairEntry *p = &bb->pairs.data[i];
@@ -343,38 +837,75 @@ static unsigned char *builder_build_to_memory(const BlobBuilder *bb, size_t *out
             if (!string_table) continue;
             const uint64_t h = fnv1a64(string_table + off, len);
             HashEntry he; he.key_hash = h; he.pair_index = i; he.reserved = 0;
-            hash_push(&hvec, he);
+            hvec.data[hvec.count++] = he;
         }
         if (hvec.count > 0) qsort(hvec.data, hvec.count, sizeof(HashEntry), cmp_hashentry);
     }
 
+    // Tag table: count the nodes of each tag, then lay the tag node list out grouped by tag
+    const size_t tag_count = bb->tags.count;
+    TagEntry *tag_entries = NULL;
+    uint32_t *tag_nodes = NULL;
+    size_t tagged = 0;
+    if (tag_count) {
+        tag_entries = a->malloc_fn(a->user, tag_count * sizeof(TagEntry));
+        if (!tag_entries) { cj_free_with(a, hvec.data); return NULL; }
+        memcpy(tag_entries, bb->tags.data, tag_count * sizeof(TagEntry));
+        for (size_t i = 0; i < tag_count; ++i) tag_entries[i].node_count = 0;
+        for (size_t i = 0; i < bb->nodes.count; ++i) {
+            const uint16_t t = bb->nodes.data[i].tag_index;
+            if (t && t <= tag_count) { tag_entries[t - 1].node_count++; tagged++; }
+        }
+        uint64_t first = 0;
+        for (size_t i = 0; i < tag_count; ++i) {
+            tag_entries[i].first_node = first;
+            first += tag_entries[i].node_count;
+        }
+        tag_nodes = a->malloc_fn(a->user, (tagged ? tagged : 1) * sizeof(uint32_t));
+        if (!tag_nodes) { cj_free_with(a, tag_entries); cj_free_with(a, hvec.data); return NULL; }
+        for (size_t i = 0; i < tag_count; ++i) tag_entries[i].node_count = 0; // reused as fill cursor
+        for (size_t i = 0; i < bb->nodes.count; ++i) {
+            const uint16_t t = bb->nodes.data[i].tag_index;
+            if (t && t <= tag_count) {
+                TagEntry *te = &tag_entries[t - 1];
+                tag_nodes[te->first_node + te->node_count++] = (uint32_t)i;
+            }
+        }
+    }
+
     // compute sizes/offsets
     const size_t header_size = sizeof(HeaderBlob);
     const size_t node_table_size = bb->nodes.count * sizeof(NodeEntry);
     const size_t pair_table_size = bb->pairs.count * sizeof(PairEntry);
     const size_t index_table_size = bb->indices.count * sizeof(uint32_t);
     const size_t hash_index_size = include_hash_index ? (hvec.count * sizeof(HashEntry)) : 0;
+    const size_t value_count = bb->values.count ? bb->nodes.count : 0;
+    const size_t value_table_size = value_count * sizeof(uint64_t);
+    const size_t tag_table_size = tag_count * sizeof(TagEntry) + tagged * sizeof(uint32_t);
     const size_t st_size = string_table_size;
+    const size_t checksum_size = (flags & CJYAML_FLAG_CHECKSUM) ? CJYAML_SECTION_COUNT * sizeof(ChecksumEntry) : 0;
 
     const uint64_t node_table_offset = header_size;
     const uint64_t pair_table_offset = node_table_offset + node_table_size;
     const uint64_t index_table_offset = pair_table_offset + pair_table_size;
     const uint64_t hash_index_offset = index_table_offset + index_table_size;
-    const uint64_t string_table_offset = hash_index_offset + hash_index_size;
-
-    if (string_table_offset > SIZE_MAX - st_size) {
-        free(string_table);
-        free(string_offsets);
-        if (hvec.data) free(hvec.data);
+    const uint64_t value_table_offset = hash_index_offset + hash_index_size;
+    const uint64_t tag_table_offset = value_table_offset + value_table_size;
+    const uint64_t string_table_offset = tag_table_offset + tag_table_size;
+
+    if (string_table_offset > SIZE_MAX - st_size - checksum_size - CJ_BLOB_PREFIX) {
+        cj_free_with(a, tag_entries);
+        cj_free_with(a, tag_nodes);
+        cj_free_with(a, hvec.data);
         return NULL;
     }
-    const size_t total_size = (string_table_offset + st_size);
+    const size_t total_size = (string_table_offset + st_size + checksum_size);
 
-    unsigned char *buf = malloc(total_size);
+    unsigned char *buf = blob_alloc(a, total_size);
     if (!buf) {
-        free(string_table);
-        free(string_offsets);
-        if (hvec.data) free(hvec.data);
+        cj_free_with(a, tag_entries);
+        cj_free_with(a, tag_nodes);
+        cj_free_with(a, hvec.data);
         return NULL;
     }
     memset(buf, 0, total_size);
@@ -394,6 +925,10 @@ static unsigned char *builder_build_to_memory(const BlobBuilder *bb, size_t *out
     write_u64_le(buf, off + 0, include_hash_index ? hvec.count : 0);         off += 8;
     write_u64_le(buf, off + 0, string_table_offset);    off += 8;
     write_u64_le(buf, off + 0, st_size);                off += 8;
+    write_u64_le(buf, off + 0, value_count ? value_table_offset : 0); off += 8;
+    write_u64_le(buf, off + 0, value_count);            off += 8;
+    write_u64_le(buf, off + 0, tag_count ? tag_table_offset : 0); off += 8;
+    write_u64_le(buf, off + 0, tag_count);              off += 8;
     assert(off == sizeof(HeaderBlob));
 
     // copy node table
@@ -420,19 +955,70 @@ static unsigned char *builder_build_to_memory(const BlobBuilder *bb, size_t *out
         memcpy(buf + dst, &hvec.data[i], sizeof(HashEntry));
         dst += sizeof(HashEntry);
     }
+    // scatter typed scalar values into the dense value table (buf is zeroed, other slots stay 0)
+    if (value_count) {
+        for (size_t i = 0; i < bb->values.count; ++i) {
+            const ScalarValue *v = &bb->values.data[i];
+            write_u64_le(buf, (size_t)value_table_offset + (size_t)v->node_index * sizeof(uint64_t), v->bits);
+        }
+    }
+    // copy tag table and tag node list
+    if (tag_count) {
+        dst = (size_t)tag_table_offset;
+        memcpy(buf + dst, tag_entries, tag_count * sizeof(TagEntry));
+        dst += tag_count * sizeof(TagEntry);
+        for (size_t i = 0; i < tagged; ++i) {
+            write_u32_le(buf, dst, tag_nodes[i]);
+            dst += sizeof(uint32_t);
+        }
+    }
     // copy string table
     if (st_size) memcpy(buf + string_table_offset, string_table, st_size);
+    // checksum table over the finished sections (the header digest includes the flag)
+    if (checksum_size) {
+        HeaderBlob h;
+        ChecksumEntry digest[CJYAML_SECTION_COUNT];
+        memcpy(&h, buf, sizeof(h));
+        blob_section_digests(buf, total_size, &h, digest);
+        dst = (size_t)string_table_offset + st_size;
+        for (int i = 0; i < CJYAML_SECTION_COUNT; ++i) {
+            write_u64_le(buf, dst, digest[i].low64);
+            write_u64_le(buf, dst + 8, digest[i].high64);
+            dst += sizeof(ChecksumEntry);
+        }
+    }
 
     // cleanup temporary allocations used during build
-    free(string_table);
-    free(string_offsets);
-    if (hvec.data) free(hvec.data);
+    cj_free_with(a, tag_entries);
+    cj_free_with(a, tag_nodes);
+    cj_free_with(a, hvec.data);
 
     *out_size = total_size;
     return buf;
 }
 
 
+/*
+ Character classes for the scanner. A lookup table instead of <ctype.h>: no locale dependency, no call per
+ byte, and whitespace is exactly YAML's s-white (space, tab) - form feed and vertical tab are content.
+*/
+#define CJ_WS    0x01 // ' ', '\t'
+#define CJ_EOL   0x02 // '\n', '\r'
+#define CJ_DIGIT 0x04 // '0'..'9'
+#define CJ_FLOW  0x08 // flow indicators ',', '[', ']', '{', '}'
+#define CJ_PLAIN_STOP 0x10 // ':' and '#' - may end a plain scalar depending on context
+
+static const uint8_t cj_char_class[256] = {
+    [' '] = CJ_WS, ['\t'] = CJ_WS,
+    ['\n'] = CJ_EOL, ['\r'] = CJ_EOL,
+    ['0'] = CJ_DIGIT, ['1'] = CJ_DIGIT, ['2'] = CJ_DIGIT, ['3'] = CJ_DIGIT, ['4'] = CJ_DIGIT,
+    ['5'] = CJ_DIGIT, ['6'] = CJ_DIGIT, ['7'] = CJ_DIGIT, ['8'] = CJ_DIGIT, ['9'] = CJ_DIGIT,
+    [','] = CJ_FLOW, ['['] = CJ_FLOW, [']'] = CJ_FLOW, ['{'] = CJ_FLOW, ['}'] = CJ_FLOW,
+    [':'] = CJ_PLAIN_STOP, ['#'] = CJ_PLAIN_STOP,
+};
+
+#define cj_is(c, cls) ((cj_char_class[(unsigned char)(c)] & (cls)) != 0)
+
 static size_t trim_span(const unsigned char *src, const size_t len, size_t *begin, size_t *end) {
     /*
     This loop trims whitespace from both ends of a string by moving two pointers: b from the start and e from the end.
@@ -443,8 +1029,8 @@ static size_t trim_span(const unsigned char *src, const size_t len, size_t *begi
     size_t e = len;
 
     while (b < e) {
-        const int left_space = isspace(src[b]);
-        const int right_space = isspace(src[e - 1]);
+        const int left_space = cj_is(src[b], CJ_WS);
+        const int right_space = cj_is(src[e - 1], CJ_WS);
 
         if (!left_space && !right_space) break;
 
@@ -466,211 +1052,1649 @@ static bool is_comment_or_empty(const unsigned char *s, const size_t b, const si
      */
     if (b >= e) return true;
     size_t i = b;
-    while (i < e && isspace((int)s[i])) ++i;
+    while (i < e && cj_is(s[i], CJ_WS)) ++i;
     if (i >= e) return true;
     if (s[i] == '#') return true;
     return false;
 }
 
 
-static char *memdup_str(const unsigned char *data, const size_t b, const size_t e) {
-    /*
-        This function creates a new heap-allocated C string by copying the memory region `[b, e)` from the input `data`.
-        It allocates `len + 1` bytes, copies the content, and appends a null terminator for convenience.
-        If memory allocation fails, it returns `NULL`; otherwise, it returns the new zero-terminated string.
-     */
-    const size_t len = (e > b) ? (e - b) : 0;
-    char *p = malloc(len + 1);
-    if (!p) return NULL;
-    memcpy(p, data + b, len);
-    p[len] = '\0';
-    return p;
-}
-
 static size_t findFirstCharInScalarAfterDash(const unsigned char *s, const size_t b, const size_t e) {
     size_t firstNonWhitespacechar = b;
     while (firstNonWhitespacechar < e) {
-        if (!isspace((int)s[firstNonWhitespacechar])) {
+        if (!cj_is(s[firstNonWhitespacechar], CJ_WS)) {
             return firstNonWhitespacechar;
         }
         firstNonWhitespacechar++;
     }
     return firstNonWhitespacechar;
 }
-static uint16_t getStyleFlagFromStr(const char *str, const size_t len) {
-    bool hasDigit = false;
-    bool hasDot = false;
-
-    if (len == 0) return SCALAR_STRING;
+/* -------------------------
+   YAML 1.2 core schema resolver
+   -------------------------
+   Resolves a plain scalar to null / bool / int / float / string (YAML 1.2.2, 10.3.2) and decodes the value
+   in the same pass. Digits are classified and accumulated 8 bytes at a time (SWAR); floats use the Clinger
+   fast path (exact for <= 2^53 mantissas and |exp10| <= 22) and fall back to strtod only outside it.
+   Like the node table, the SWAR loads assume a little-endian host.
+*/
+
+// true if all 8 bytes of v are ASCII digits
+static inline bool swar_is_eight_digits(const uint64_t v) {
+    return (((v & 0xF0F0F0F0F0F0F0F0ULL) | (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x3333333333333333ULL);
+}
 
-    for (size_t i = 0; i < len; i++) {
-        const char c = str[i];
+// value of 8 ASCII digits (first byte = most significant digit)
+static inline uint32_t swar_parse_eight_digits(uint64_t v) {
+    const uint64_t mask = 0x000000FF000000FFULL;
+    const uint64_t mul1 = 0x000F424000000064ULL; // 100 + (1000000 << 32)
+    const uint64_t mul2 = 0x0000271000000001ULL; // 1 + (10000 << 32)
+    v -= 0x3030303030303030ULL;
+    v = (v * 10) + (v >> 8);
+    v = (((v & mask) * mul1) + (((v >> 16) & mask) * mul2)) >> 32;
+    return (uint32_t)v;
+}
 
-        if (isdigit((unsigned char)c)) {
-            hasDigit = true;
-        } else if (c == '.') {
-            if (hasDot) return UINT16_MAX;
-            if (!hasDigit) return UINT16_MAX;
-            if (i == len - 1) return UINT16_MAX;
-            hasDot = true;
+/*
+ Consume decimal digits starting at s[*i]. Digits are multiplied into *acc while it holds fewer than
+ 19 significant digits (*taken counts them, leading zeros included); later digits only bump *dropped.
+ Returns the number of digits consumed.
+*/
+static size_t scan_decimal_digits(const char *s, const size_t len, size_t *i, uint64_t *acc, size_t *sig, size_t *taken, size_t *dropped) {
+    const size_t start = *i;
+    size_t p = *i;
+    while (p + 8 <= len && *sig + 8 <= 19) {
+        uint64_t chunk;
+        memcpy(&chunk, s + p, sizeof(chunk));
+        if (!swar_is_eight_digits(chunk)) break;
+        *acc = *acc * 100000000ULL + swar_parse_eight_digits(chunk);
+        if (*acc != 0) *sig += 8; // over-estimate keeps *acc < 10^*sig, so 19 digits never overflow
+        *taken += 8;
+        p += 8;
+    }
+    while (p < len && cj_is(s[p], CJ_DIGIT)) {
+        if (*sig < 19) {
+            *acc = *acc * 10 + (uint64_t)(s[p] - '0');
+            if (*acc != 0) ++*sig;
+            ++*taken;
         } else {
-            if ((len == 4 && strncmp(str, "true", 4) == 0) ||
-                (len == 5 && strncmp(str, "false", 5) == 0)) {
-                return SCALAR_BOOL;
-                }
-            return SCALAR_STRING;
+            ++*dropped;
         }
+        ++p;
     }
-
-    if (hasDot) return SCALAR_FLOAT;
-    if (hasDigit) return SCALAR_INT;
-
-    return SCALAR_STRING;
+    *i = p;
+    return p - start;
 }
 
-static unsigned char *parse(const void *mappedFile, const size_t fileSize, size_t *out_size) {
-    if (!mappedFile || fileSize == 0 || out_size == NULL) {
-        return NULL;
+static bool resolve_radix_int(const char *s, const size_t len, const unsigned shift, uint64_t *bits) {
+    // s = digits after "0x"/"0o"; shift = 4 (hex) or 3 (octal)
+    if (len == 0) return false;
+    uint64_t v = 0;
+    for (size_t i = 0; i < len; ++i) {
+        const unsigned char c = (unsigned char)s[i];
+        unsigned d;
+        if ((unsigned char)(c - '0') < 10) d = c - '0';
+        else if (shift == 4 && (unsigned char)((c | 0x20) - 'a') < 6) d = (c | 0x20) - 'a' + 10;
+        else return false;
+        if (d >> shift) return false;             // '8'/'9' in octal
+        if (v >> (63 - shift)) return false;      // would exceed INT64_MAX -> keep as string
+        v = (v << shift) | d;
     }
+    *bits = v;
+    return true;
+}
 
+/*
+ The "C" locale for strtod_fallback, created once per process: plain strtod follows LC_NUMERIC, so in a process
+ using a comma-decimal locale it would stop at the '.' the scanner has already validated.
+*/
+#if defined(_WIN32)
+typedef _locale_t cj_locale_t;
+static INIT_ONCE c_locale_once = INIT_ONCE_STATIC_INIT;
+static cj_locale_t c_locale;
+
+static BOOL CALLBACK c_locale_create(PINIT_ONCE once, PVOID param, PVOID *context) {
+    (void)once;
+    (void)param;
+    (void)context;
+    c_locale = _create_locale(LC_NUMERIC, "C");
+    return TRUE;
+}
 
+static cj_locale_t c_numeric_locale(void) {
+    InitOnceExecuteOnce(&c_locale_once, c_locale_create, NULL, NULL);
+    return c_locale;
+}
 
-    const unsigned char *data = mappedFile;
-    BlobBuilder bb;
-    builder_init(&bb);
+#define cj_strtod_c(s, end, loc) _strtod_l((s), (end), (loc))
+#else
+typedef locale_t cj_locale_t;
+static pthread_once_t c_locale_once = PTHREAD_ONCE_INIT;
+static cj_locale_t c_locale;
 
+static void c_locale_create(void) {
+    c_locale = newlocale(LC_NUMERIC_MASK, "C", (locale_t)0);
+}
 
-    uint32_t last_key_node = (uint32_t)-1;
-    int expecting_sequence_for_last_key = 0;
+static cj_locale_t c_numeric_locale(void) {
+    pthread_once(&c_locale_once, c_locale_create);
+    return c_locale;
+}
 
-    // Parse line by line
-    size_t pos = 0;
-    while (pos < fileSize) {
-        // find end of line
-        size_t line_start = pos;
-        size_t line_end = pos;
-        while (line_end < fileSize && data[line_end] != '\n' && data[line_end] != '\r') ++line_end;
+#define cj_strtod_c(s, end, loc) strtod_l((s), (end), (loc))
+#endif
 
-        // trim
-        size_t b, e;
-        // Data is a pointer to an array of characters, so if we add the beginning of a line to it,
-        // then only the line is passed to the function, not the entire contents of the file.
-        trim_span(data + line_start, line_end - line_start, &b, &e);
-        b += line_start;
-        e += line_start; // adjust to absolute offsets
+// correctly rounded conversion of a validated decimal float outside the fast path (unwinds with ENOMEM in a parse)
+static bool strtod_fallback(const char *s, const size_t len, double *out) {
+    const cj_locale_t loc = c_numeric_locale();
+    if (!loc) {
+        build_fail(CJYAML_ENOMEM);
+        return false;
+    }
+    char small[64];
+    char *tmp = len < sizeof(small) ? small : cj_realloc(NULL, 0, len + 1);
+    if (tmp == NULL) return false;
+    memcpy(tmp, s, len);
+    tmp[len] = '\0';
+    char *end = NULL;
+    *out = cj_strtod_c(tmp, &end, loc);
+    const bool ok = end == tmp + len;
+    if (tmp != small) cj_release(tmp);
+    return ok;
+}
 
-        if (!is_comment_or_empty(data, b, e)) {
-            // This notation works because b is the first non-whitespace character,
-            // so if b is less than e -1, it means that string has at least 2 characters and if the first non-whitespace character is '-' and the next is a space,
-            // and we know that after the next character there is another character (because if abs(b-e)>2 && last char is not white-space), it's mean it must be a scalar.
-            if (b < e -1 && data[b] == '-' && isspace(data[b + 1])) {
-                //SCALAR CASE
+static bool scalar_text_equals(const char *s, const size_t len, const char *lit) {
+    const size_t n = strlen(lit);
+    return len == n && memcmp(s, lit, n) == 0;
+}
 
-                // If b < e -1 --> abs(b-e) > 2 --> data[b+2] != nullptr
-                size_t item_b = findFirstCharInScalarAfterDash(data, b + 2, e);
+/*
+ Resolve a plain scalar. Returns its style_flags (SCALAR_* subtype, plus SCALAR_NULL for nulls) and
+ stores the decoded value-table bits for int/float/bool.
+*/
+static uint8_t resolve_plain_scalar(const char *s, const size_t len, uint64_t *bits) {
+    static const double pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    *bits = 0;
+    if (len == 0) return SCALAR_STRING | SCALAR_NULL;
+
+    // cheap first-byte reject: most plain scalars are words
+    const unsigned char c0 = (unsigned char)s[0];
+    switch (c0) {
+        case '~':
+            return len == 1 ? (SCALAR_STRING | SCALAR_NULL) : SCALAR_STRING;
+        case 'n': case 'N':
+            if (scalar_text_equals(s, len, "null") || scalar_text_equals(s, len, "Null") || scalar_text_equals(s, len, "NULL"))
+                return SCALAR_STRING | SCALAR_NULL;
+            return SCALAR_STRING;
+        case 't': case 'T':
+            if (scalar_text_equals(s, len, "true") || scalar_text_equals(s, len, "True") || scalar_text_equals(s, len, "TRUE")) {
+                *bits = 1;
+                return SCALAR_BOOL;
+            }
+            return SCALAR_STRING;
+        case 'f': case 'F':
+            if (scalar_text_equals(s, len, "false") || scalar_text_equals(s, len, "False") || scalar_text_equals(s, len, "FALSE"))
+                return SCALAR_BOOL;
+            return SCALAR_STRING;
+        case '+': case '-': case '.':
+            break;
+        default:
+            if (!cj_is(c0, CJ_DIGIT)) return SCALAR_STRING;
+            break;
+    }
 
-                size_t tb, te;
-                trim_span(data + item_b, e - item_b, &tb, &te);
-                tb += item_b;
-                te += item_b;
-
-                char *item_str = memdup_str(data, tb, te);
-                if (!item_str) goto err;
-                const size_t lenItem = strlen(item_str);
-                const uint16_t styleFlagScalar = getStyleFlagFromStr(item_str, lenItem);
-
-                if (styleFlagScalar != UINT16_MAX) {
-                    uint32_t item_node = builder_add_scalar(&bb, item_str, lenItem, styleFlagScalar, 0);
-
-                    if (!expecting_sequence_for_last_key) {
-                        // start a new anonymous sequence (no key) - create seq node that contains this single element for now
-                        uint32_t elems[1] = { item_node };
-                        uint32_t seq_idx = builder_add_sequence(&bb, elems, 1);
-                        // append a pair with empty key? For simplicity we map special key "" to the sequence
-                        uint32_t empty_k = builder_add_scalar(&bb, "", 0, 0, 0);
-                        builder_append_pair(&bb, empty_k, seq_idx);
-                        last_key_node = empty_k;
-                        expecting_sequence_for_last_key = 1; // sequence started
-                    } else {
-                        // append item to last sequence: we must find sequence node index stored as value in last pair
-                        // last_key_node is index of key; find corresponding pair index by scanning pairs (inefficient but fine for demo)
-                        uint32_t seq_pair_index = (uint32_t)-1;
-                        for (size_t pi = 0; pi < bb.pairs.count; ++pi) {
-                            if (bb.pairs.data[pi].key_node_index == last_key_node) {
-                                seq_pair_index = (uint32_t)pi;
-                                break;
-                            }
-                        }
-                        if (seq_pair_index == (uint32_t)-1) {
-                            // fallback: create new sequence and pair
-                            uint32_t elems[1] = { item_node };
-                            uint32_t seq_idx = builder_add_sequence(&bb, elems, 1);
-                            builder_append_pair(&bb, last_key_node, seq_idx);
-                        } else {
-                            // get current value node index (should be sequence node index)
-                            uint32_t value_node_idx = bb.pairs.data[seq_pair_index].value_node_index;
-                            // value_node_idx references a NodeEntry of type SEQUENCE; we need to append item to index_table and increase element_count
-                            if (value_node_idx < bb.nodes.count && bb.nodes.data[value_node_idx].node_type == 1) {
-                                // append to index table
-                                index_push(&bb.indices, item_node);
-                                // update node.b (element_count)
-                                bb.nodes.data[value_node_idx].b += 1;
-                                // note: node.a (first_index) remains valid since index table is flat and we appended at end
-                            } else {
-                                // not a sequence (or not exist), create new sequence and replace pair value
-                                uint32_t elems[1] = { item_node };
-                                uint32_t seq_idx = builder_add_sequence(&bb, elems, 1);
-                                bb.pairs.data[seq_pair_index].value_node_index = seq_idx;
-                            }
-                        }
-                    }
-                }
-                free(item_str);
-                item_str = NULL;
-            } else {
-                // mapping "key: value" (split at first ':')
-                size_t colon = b;
-                while (colon < e && data[colon] != ':') ++colon;
-                if (colon < e && data[colon] == ':') {
-                    // key = [b, colon)
-                    size_t kb, ke;
-                    trim_span(data + b, colon - b, &kb, &ke);
-                    kb += b; ke += b;
-                    // value = after colon
-                    size_t vb = colon + 1;
-                    // skip spaces after colon
-                    while (vb < e && isspace((int)data[vb])) ++vb;
-                    size_t vbegin, vend;
-                    trim_span(data + vb, e - vb, &vbegin, &vend);
-                    vbegin += vb; vend += vb;
+    size_t i = 0;
+    bool negative = false;
+    if (s[0] == '+' || s[0] == '-') {
+        negative = s[0] == '-';
+        i = 1;
+    }
 
-                    char *kstr = memdup_str(data, kb, ke);
-                    char *vstr = memdup_str(data, vbegin, vend);
-                    if (!kstr || !vstr) { free(kstr); free(vstr); goto err; }
+    // .inf / .nan
+    if (i < len && s[i] == '.' && len - i == 4) {
+        const char *w = s + i + 1;
+        if (scalar_text_equals(w, 3, "inf") || scalar_text_equals(w, 3, "Inf") || scalar_text_equals(w, 3, "INF")) {
+            const double d = negative ? -HUGE_VAL : HUGE_VAL;
+            memcpy(bits, &d, sizeof(d));
+            return SCALAR_FLOAT;
+        }
+        if (i == 0 && (scalar_text_equals(w, 3, "nan") || scalar_text_equals(w, 3, "NaN") || scalar_text_equals(w, 3, "NAN"))) {
+            const double d = NAN;
+            memcpy(bits, &d, sizeof(d));
+            return SCALAR_FLOAT;
+        }
+        return SCALAR_STRING;
+    }
 
-                    uint32_t knode = builder_add_scalar(&bb, kstr, strlen(kstr), 0, 0);
-                    uint32_t vnode = builder_add_scalar(&bb, vstr, strlen(vstr), 0, 0);
-                    free(kstr); free(vstr);
+    // 0x.. / 0o.. (unsigned in the core schema)
+    if (i == 0 && len > 2 && s[0] == '0' && (s[1] == 'x' || s[1] == 'o')) {
+        return resolve_radix_int(s + 2, len - 2, s[1] == 'x' ? 4 : 3, bits) ? SCALAR_INT : SCALAR_STRING;
+    }
 
-                    builder_append_pair(&bb, knode, vnode);
+    uint64_t mantissa = 0;
+    size_t sig = 0, taken = 0, dropped = 0;
+    const size_t int_digits = scan_decimal_digits(s, len, &i, &mantissa, &sig, &taken, &dropped);
 
-                    // update last_key_node for possible following sequence items
-                    last_key_node = knode;
-                    expecting_sequence_for_last_key = 0; // value was scalar, not sequence
+    if (i == len) {
+        // [-+]?[0-9]+
+        if (int_digits == 0 || dropped) return SCALAR_STRING;
+        if (mantissa > (uint64_t)INT64_MAX + (negative ? 1u : 0u)) return SCALAR_STRING;
+        *bits = negative ? (uint64_t)0 - mantissa : mantissa;
+        return SCALAR_INT;
+    }
+
+    // [-+]?(\.[0-9]+|[0-9]+(\.[0-9]*)?)([eE][-+]?[0-9]+)?
+    int64_t exp10 = (int64_t)dropped; // integer digits beyond the mantissa scale it up
+    size_t frac_digits = 0;
+    if (s[i] == '.') {
+        ++i;
+        const size_t taken_before = taken;
+        frac_digits = scan_decimal_digits(s, len, &i, &mantissa, &sig, &taken, &dropped);
+        exp10 -= (int64_t)(taken - taken_before); // fraction digits inside the mantissa scale it down
+    }
+    if (int_digits == 0 && frac_digits == 0) return SCALAR_STRING;
+    if (i < len && (s[i] == 'e' || s[i] == 'E')) {
+        ++i;
+        bool exp_negative = false;
+        if (i < len && (s[i] == '+' || s[i] == '-')) {
+            exp_negative = s[i] == '-';
+            ++i;
+        }
+        const size_t exp_start = i;
+        int64_t e = 0;
+        while (i < len && cj_is(s[i], CJ_DIGIT)) {
+            if (e < 100000) e = e * 10 + (s[i] - '0');
+            ++i;
+        }
+        if (i == exp_start) return SCALAR_STRING;
+        exp10 += exp_negative ? -e : e;
+    }
+    if (i != len) return SCALAR_STRING;
+
+    double d;
+    if (!dropped && mantissa <= (1ULL << 53) && exp10 >= -22 && exp10 <= 22) {
+        d = (double)mantissa;
+        d = exp10 < 0 ? d / pow10[-exp10] : d * pow10[exp10];
+        if (negative) d = -d;
+    } else if (!strtod_fallback(s, len, &d)) {
+        return SCALAR_STRING;
+    }
+    memcpy(bits, &d, sizeof(d));
+    return SCALAR_FLOAT;
+}
+
+// add a plain (unquoted) scalar: resolved with the core schema, typed values go to the value table
+static uint32_t builder_add_plain_scalar(BlobBuilder *bb, const char *s, const size_t len) {
+    uint64_t bits = 0;
+    const uint8_t style_flags = resolve_plain_scalar(s, len, &bits);
+    const uint32_t node = builder_add_scalar(bb, s, len, style_flags, 0);
+    if ((style_flags & SCALAR_TYPE_MASK) != SCALAR_STRING) {
+        ScalarValue v;
+        v.node_index = node;
+        v.bits = bits;
+        values_push(&bb->values, v);
+    }
+    return node;
+}
+
+/* -------------------------
+   !include support types
+   -------------------------*/
+
+#define CJYAML_INCLUDE_TAG "!include"
+#define CJYAML_MAX_INCLUDE_DEPTH 16
+#define CJYAML_MAX_INCLUDE_THREADS 16
+
+typedef struct IncludeChain {
+    const char *path;
+    const struct IncludeChain *parent;
+} IncludeChain;
+
+typedef struct {
+    uint32_t node;   // placeholder node ("!include path" scalar) in the including document
+    char *path;      // resolved path of the included file
+    BlobBuilder bb;  // the included document, parsed by a worker
+    uint32_t root;   // its root node in bb, UINT32_MAX if it could not be loaded
+} IncludeJob;
+
+typedef struct {
+    IncludeJob *data;
+    size_t count;
+    size_t cap;
+} IncludeVec;
+
+static void includes_init(IncludeVec *v) {
+    v->data = NULL;
+    v->count = 0;
+    v->cap = 0;
+}
+
+static void includes_free(IncludeVec *v, const cjyaml_allocator *a) {
+    for (size_t i = 0; i < v->count; ++i) {
+        cj_free_with(a, v->data[i].path);
+        builder_free(&v->data[i].bb);
+    }
+    cj_free_with(a, v->data);
+    includes_init(v);
+}
+
+/* -------------------------
+   Parser state
+   -------------------------*/
+
+#define CJYAML_MAX_FLOW_DEPTH 256
+
+/*
+ Anchors: open-addressing map from anchor name (bytes in the source buffer) to the anchored node.
+ An anchor is registered once its node is complete, so an alias can only point at an earlier, finished
+ node - the node graph stays acyclic. That includes "key: &x" followed by block sequence items: the anchor is
+ held back until the sequence is stored over the placeholder, so a "*x" among the items stays unresolved.
+ Redefining an anchor rebinds it for the aliases that follow. A flow value that turns out malformed is rolled
+ back to a plain scalar; the anchors it defined are unbound and the ones it redefined get their earlier binding
+ back (kept in `outer` from the first rebind inside the value).
+*/
+typedef struct {
+    uint64_t hash;      // 0 = empty slot
+    const unsigned char *name;
+    size_t len;
+    uint32_t node;
+    uint32_t outer;     // binding before the flow value being parsed (UINT32_MAX: none), restored on rollback
+} AnchorSlot;
+
+typedef struct {
+    AnchorSlot *slots;  // power-of-two capacity, load factor <= 1/2
+    size_t count;
+    size_t cap;
+    uint32_t flow_first; // first node of the flow value being parsed; bindings to earlier nodes are outer ones
+} AnchorMap;
+
+static void anchors_init(AnchorMap *m) {
+    m->slots = NULL;
+    m->count = 0;
+    m->cap = 0;
+    m->flow_first = UINT32_MAX;
+}
+
+static void anchors_free(AnchorMap *m, const cjyaml_allocator *a) {
+    cj_free_with(a, m->slots);
+    anchors_init(m);
+}
+
+// find the slot of `name` (empty slot if absent); the map must have capacity
+static AnchorSlot *anchors_slot(const AnchorMap *m, const unsigned char *name, const size_t len, const uint64_t h) {
+    size_t i = (size_t)h & (m->cap - 1);
+    for (;;) {
+        AnchorSlot *slot = &m->slots[i];
+        if (!slot->hash || (slot->hash == h && slot->len == len && memcmp(slot->name, name, len) == 0)) return slot;
+        i = (i + 1) & (m->cap - 1);
+    }
+}
+
+static void anchors_set(AnchorMap *m, const unsigned char *name, const size_t len, const uint32_t node) {
+    if ((m->count + 1) * 2 > m->cap) {
+        const size_t new_capacity = m->cap ? m->cap * 2 : 16;
+        AnchorSlot *slots = cj_calloc(new_capacity, sizeof(AnchorSlot));
+        if (!slots) {
+            return;
+        }
+        const AnchorMap grown = { slots, m->count, new_capacity, m->flow_first };
+        for (size_t i = 0; i < m->cap; ++i) {
+            if (m->slots[i].hash) *anchors_slot(&grown, m->slots[i].name, m->slots[i].len, m->slots[i].hash) = m->slots[i];
+        }
+        cj_release(m->slots);
+        *m = grown;
+    }
+    const uint64_t h = fnv1a64(name, len) | 1;
+    AnchorSlot *slot = anchors_slot(m, name, len, h);
+    if (!slot->hash) {
+        slot->hash = h;
+        slot->name = name;
+        slot->len = len;
+        slot->outer = UINT32_MAX;
+        m->count++;
+    } else if (slot->node < m->flow_first) {
+        slot->outer = slot->node;
+    }
+    slot->node = node;
+}
+
+static bool anchors_get(const AnchorMap *m, const unsigned char *name, const size_t len, uint32_t *node) {
+    if (!m->cap) return false;
+    const AnchorSlot *slot = anchors_slot(m, name, len, fnv1a64(name, len) | 1);
+    if (!slot->hash || slot->node == UINT32_MAX) return false;
+    *node = slot->node;
+    return true;
+}
+
+// undo the bindings to nodes >= first_node (the builder rolls back a malformed flow value starting there): anchors
+// it redefined name their outer node again, the others are unbound
+static void anchors_forget_from(AnchorMap *m, const uint32_t first_node) {
+    for (size_t i = 0; i < m->cap; ++i) {
+        AnchorSlot *slot = &m->slots[i];
+        if (slot->hash && slot->node != UINT32_MAX && slot->node >= first_node) {
+            slot->node = slot->outer < first_node ? slot->outer : UINT32_MAX;
+        }
+    }
+}
+
+// add ALIAS node: a = target node index
+static uint32_t builder_add_alias(BlobBuilder *bb, const uint32_t target) {
+    NodeEntry n;
+    n.node_type = ALIAS;
+    n.style_flags = 0;
+    n.tag_index = 0;
+    n.a = target;
+    n.b = 0;
+    nodes_push(&bb->nodes, n);
+    return (uint32_t)(bb->nodes.count - 1);
+}
+
+// end of an anchor/alias name starting at p (names stop at whitespace, line breaks and flow indicators)
+static size_t scan_anchor_name(const unsigned char *d, size_t p, const size_t end) {
+    while (p < end && !cj_is(d[p], CJ_WS | CJ_EOL | CJ_FLOW)) ++p;
+    return p;
+}
+
+/* -------------------------
+   Node properties (&anchor, !tag)
+   -------------------------*/
+
+typedef struct {
+    const unsigned char *anchor; // NULL if none
+    size_t anchor_len;
+    const unsigned char *tag;    // NULL if none; the full tag text as written ("!t", "!!str", "!<...>")
+    size_t tag_len;
+} NodeProps;
+
+/*
+ Scan the properties at *pos: an anchor and/or a tag, in either order, separated by spaces on the same line.
+ *pos ends just after the last property. Returns false if there is none or a property is malformed.
+*/
+static bool scan_node_props(const unsigned char *d, size_t *pos, const size_t end, NodeProps *props) {
+    props->anchor = NULL;
+    props->anchor_len = 0;
+    props->tag = NULL;
+    props->tag_len = 0;
+    size_t p = *pos;
+    size_t last = p;
+    while (p < end && ((d[p] == '&' && !props->anchor) || (d[p] == '!' && !props->tag))) {
+        size_t ne;
+        if (d[p] == '&') {
+            ne = scan_anchor_name(d, p + 1, end);
+            if (ne == p + 1) return false;
+            props->anchor = d + p + 1;
+            props->anchor_len = ne - p - 1;
+        } else {
+            if (p + 1 < end && d[p + 1] == '<') { // verbatim !<...>
+                ne = p + 2;
+                while (ne < end && d[ne] != '>' && !cj_is(d[ne], CJ_WS | CJ_EOL)) ++ne;
+                if (ne >= end || d[ne] != '>') return false;
+                ++ne;
+            } else {
+                ne = scan_anchor_name(d, p + 1, end);
+            }
+            props->tag = d + p;
+            props->tag_len = ne - p;
+        }
+        if (ne < end && !cj_is(d[ne], CJ_WS | CJ_EOL | CJ_FLOW)) return false;
+        last = p = ne;
+        while (p < end && cj_is(d[p], CJ_WS)) ++p;
+    }
+    if (last == *pos) return false;
+    *pos = last;
+    return true;
+}
+
+// "!!str" and the non-specific "!" force a plain scalar to stay a string
+static bool is_string_tag(const unsigned char *t, const size_t len) {
+    return (len == 1 && t[0] == '!')
+        || (len == 5 && memcmp(t, "!!str", 5) == 0)
+        || (len == 24 && memcmp(t, "!<tag:yaml.org,2002:str>", 24) == 0);
+}
+
+typedef struct {
+    const unsigned char *data;
+    size_t size;
+    BlobBuilder *bb;
+
+    PairVec top;        // pairs of the top-level mapping; appended as one contiguous range at the end
+    size_t top_merge;   // position in `top` of the first plain '<<' key (SIZE_MAX if none)
+    IndexVec seq_items; // items of the open block sequence; appended as one contiguous range when it ends
+    size_t seq_pair;    // index in `top` of the pair whose value is the open block sequence
+    bool in_seq;
+    const unsigned char *held_anchor; // "key: &x" with no value yet: bound once the value is known (see anchors)
+    size_t held_anchor_len;
+    uint32_t held_node;               // the null placeholder the anchor names
+
+    IndexVec scratch;   // children of open flow collections (node indices; key/value pairs take two slots)
+    size_t line_indent; // indentation of the current line (parent indentation for block scalars)
+    AnchorMap anchors;  // &name -> node index, for *name aliases
+
+    const char *base_dir;        // canonical directory !include paths are resolved in (NULL: includes are off)
+    const IncludeChain *chain;   // files being parsed, innermost first (cycle detection)
+    int include_depth;           // 0 for the root document
+    size_t include_threads;      // threads for this document's includes (1: on the calling thread)
+    IncludeVec includes;         // !include placeholders found in this document
+} ParserState;
+
+static void parser_state_init(ParserState *ps, const unsigned char *data, const size_t size, BlobBuilder *bb,
+                              const char *base_dir, const IncludeChain *chain, const int include_depth,
+                              const size_t include_threads) {
+    ps->data = data;
+    ps->size = size;
+    ps->bb = bb;
+    pairs_init(&ps->top);
+    ps->top_merge = SIZE_MAX;
+    index_init(&ps->seq_items);
+    ps->seq_pair = 0;
+    ps->in_seq = false;
+    ps->held_anchor = NULL;
+    ps->held_anchor_len = 0;
+    ps->held_node = 0;
+    index_init(&ps->scratch);
+    ps->line_indent = 0;
+    anchors_init(&ps->anchors);
+    ps->base_dir = base_dir;
+    ps->chain = chain;
+    ps->include_depth = include_depth;
+    ps->include_threads = include_threads;
+    includes_init(&ps->includes);
+}
+
+// called after the parse scope has ended: frees through the builder's allocator
+static void parser_state_free(ParserState *ps) {
+    const cjyaml_allocator *a = &ps->bb->alloc;
+    cj_free_with(a, ps->top.data);
+    cj_free_with(a, ps->seq_items.data);
+    cj_free_with(a, ps->scratch.data);
+    anchors_free(&ps->anchors, a);
+    includes_free(&ps->includes, a);
+    ps->top.data = NULL;
+    ps->seq_items.data = NULL;
+    ps->scratch.data = NULL;
+}
+
+// parser vectors a context keeps between parses (the input-independent part of ParserState)
+typedef struct {
+    PairVec top;
+    IndexVec seq_items;
+    IndexVec scratch;
+    AnchorMap anchors;
+} ParserScratch;
+
+static void parser_scratch_init(ParserScratch *k) {
+    pairs_init(&k->top);
+    index_init(&k->seq_items);
+    index_init(&k->scratch);
+    anchors_init(&k->anchors);
+}
+
+static void parser_scratch_free(ParserScratch *k, const cjyaml_allocator *a) {
+    cj_free_with(a, k->top.data);
+    cj_free_with(a, k->seq_items.data);
+    cj_free_with(a, k->scratch.data);
+    anchors_free(&k->anchors, a);
+    parser_scratch_init(k);
+}
+
+// move the kept vectors into a fresh parser state, emptied
+static void parser_state_adopt(ParserState *ps, ParserScratch *k) {
+    ps->top = k->top;
+    ps->top.count = 0;
+    ps->seq_items = k->seq_items;
+    ps->seq_items.count = 0;
+    ps->scratch = k->scratch;
+    ps->scratch.count = 0;
+    ps->anchors = k->anchors;
+    if (ps->anchors.count) memset(ps->anchors.slots, 0, ps->anchors.cap * sizeof(AnchorSlot));
+    ps->anchors.count = 0;
+    parser_scratch_init(k);
+}
+
+// hand the vectors back to the context; parser_state_free then only releases the rest
+static void parser_state_release(ParserState *ps, ParserScratch *k) {
+    k->top = ps->top;
+    k->seq_items = ps->seq_items;
+    k->scratch = ps->scratch;
+    k->anchors = ps->anchors;
+    pairs_init(&ps->top);
+    index_init(&ps->seq_items);
+    index_init(&ps->scratch);
+    anchors_init(&ps->anchors);
+}
+
+// bind the anchor held back on a "key: &x" placeholder, now that its value is complete
+static void bind_held_anchor(ParserState *ps) {
+    if (!ps->held_anchor) return;
+    anchors_set(&ps->anchors, ps->held_anchor, ps->held_anchor_len, ps->held_node);
+    ps->held_anchor = NULL;
+}
+
+// true if the held anchor names the placeholder of the block sequence that an item line opens or continues
+static bool held_anchor_awaits_sequence(const ParserState *ps) {
+    if (!ps->held_anchor || !ps->top.count) return false;
+    const size_t pair = ps->in_seq ? ps->seq_pair : ps->top.count - 1;
+    return ps->top.data[pair].value_node_index == ps->held_node;
+}
+
+// close the open block sequence: emit its items contiguously and store it over the pair's null placeholder
+// value, so an anchor or tag set on "key: &x !t" applies to the sequence
+static void flush_block_sequence(ParserState *ps) {
+    if (!ps->in_seq) return;
+    BlobBuilder *bb = ps->bb;
+    const uint32_t seq = builder_add_sequence(bb, ps->seq_items.data, ps->seq_items.count);
+    const uint32_t value = ps->top.data[ps->seq_pair].value_node_index;
+    NodeEntry *placeholder = &bb->nodes.data[value];
+    const uint16_t tag_index = placeholder->tag_index;
+    *placeholder = bb->nodes.data[seq];
+    placeholder->tag_index = tag_index;
+    bb->nodes.count--;
+    ps->seq_items.count = 0;
+    ps->in_seq = false;
+    if (ps->held_anchor && ps->held_node == value) bind_held_anchor(ps);
+}
+
+static bool path_is_absolute(const char *path, const size_t len) {
+    return (len > 0 && (path[0] == '/' || path[0] == '\\')) || (len > 1 && path[1] == ':'); // drive letter
+}
+
+static bool path_is_separator(const char c) {
+#ifdef _WIN32
+    return c == '/' || c == '\\';
+#else
+    return c == '/';
+#endif
+}
+
+// true if the canonical path names an entry inside the canonical directory dir
+static bool path_is_inside(const char *path, const char *dir) {
+    size_t len = strlen(dir);
+    if (strncmp(path, dir, len) != 0) return false;
+    if (len > 0 && path_is_separator(dir[len - 1])) len--; // dir is a root ("/", "C:\\")
+    return path_is_separator(path[len]) && path[len + 1] != '\0';
+}
+
+// "dir/path" for a relative path, a copy of path otherwise
+static char *path_join(const char *dir, const char *path, const size_t len) {
+    const size_t dir_len = (dir && !path_is_absolute(path, len)) ? strlen(dir) : 0;
+    char *out = cj_realloc(NULL, 0, dir_len + 1 + len + 1);
+    if (!out) {
+        return NULL;
+    }
+    size_t w = 0;
+    if (dir_len) {
+        memcpy(out, dir, dir_len);
+        w = dir_len;
+        out[w++] = '/';
+    }
+    memcpy(out + w, path, len);
+    out[w + len] = '\0';
+    return out;
+}
+
+// directory part of path into dir (cap bytes); false if it has none or it does not fit. Allocates nothing, so it
+// is safe where no parse scope may be charged (the include workers)
+static bool path_dirname(const char *path, char *dir, const size_t cap) {
+    const char *slash = strrchr(path, '/');
+#ifdef _WIN32
+    const char *bslash = strrchr(path, '\\');
+    if (bslash && (!slash || bslash > slash)) slash = bslash;
+#endif
+    if (!slash) return false;
+    const size_t len = slash == path ? 1 : (size_t)(slash - path);
+    if (len >= cap) return false;
+    memcpy(dir, path, len);
+    dir[len] = '\0';
+    return true;
+}
+
+// replace *path with its canonical form so cycles are found whatever the spelling; *path stays the caller's until
+// the copy exists, so an unwind cannot leak it. False (and *path kept) if the path cannot be resolved
+static bool path_canonical(char **path) {
+    if (!*path) return false;
+#ifdef _WIN32
+    char full[_MAX_PATH];
+    if (!_fullpath(full, *path, sizeof(full))) return false;
+#else
+    char full[CJ_PATH_MAX];
+    if (!realpath(*path, full)) return false;
+#endif
+    const size_t len = strlen(full);
+    char *out = cj_realloc(NULL, 0, len + 1); // not realpath's malloc'd copy: it must come from the parse allocator
+    if (!out) {
+        return false;
+    }
+    memcpy(out, full, len + 1);
+    cj_release(*path);
+    *path = out;
+    return true;
+}
+
+// canonical current directory into dir (CJ_PATH_MAX bytes), the base of includes in buffer parses
+static bool path_current_dir(char *dir) {
+#ifdef _WIN32
+    return _fullpath(dir, ".", CJ_PATH_MAX) != NULL;
+#else
+    return realpath(".", dir) != NULL;
+#endif
+}
+
+/*
+ Queue "!include path" on a scalar node. Includes are off without a base directory; absolute paths, paths that
+ leave the base directory, includes too deep and of a file already being parsed stay unresolved.
+*/
+static void include_register(ParserState *ps, const uint32_t node) {
+    const NodeEntry *n = &ps->bb->nodes.data[node];
+    if (!ps->base_dir || n->node_type != SCALAR || n->b == 0 || ps->include_depth >= CJYAML_MAX_INCLUDE_DEPTH) return;
+    if (path_is_absolute(ps->bb->strings.data + n->a, (size_t)n->b)) return;
+
+    // take the job slot first and keep the path in it from the start: if canonicalising it unwinds, the slot and
+    // the path are freed with the parser state
+    IncludeVec *v = &ps->includes;
+    grow_array_if_needed((void**)&v->data, v->count, &v->cap, sizeof(IncludeJob));
+    IncludeJob *job = &v->data[v->count++];
+    job->node = node;
+    job->path = NULL;
+    builder_init(&job->bb);
+    job->bb.alloc = ps->bb->alloc; // the included tables come from the caller's allocator too (freed by builder_free)
+    job->bb.max_bytes = ps->bb->max_bytes; // one budget for the whole parse, the splice is charged again
+    job->bb.parse_bytes = ps->bb->parse_bytes ? ps->bb->parse_bytes : &ps->bb->bytes;
+    job->bb.presize = ps->bb->presize;
+    job->root = UINT32_MAX;
+
+    job->path = path_join(ps->base_dir, ps->bb->strings.data + n->a, (size_t)n->b);
+    if (!path_canonical(&job->path) || !path_is_inside(job->path, ps->base_dir)) {
+        cj_release(job->path);
+        job->path = NULL;
+    }
+    for (const IncludeChain *c = ps->chain; job->path && c; c = c->parent) {
+        if (strcmp(c->path, job->path) == 0) {
+            cj_release(job->path);
+            job->path = NULL;
+        }
+    }
+    if (!job->path) {
+        v->count--;
+        builder_free(&job->bb);
+    }
+}
+
+// attach scanned properties to a finished node: tag_index, string typing for "!!str", and the anchor binding
+static uint32_t apply_node_props(ParserState *ps, const uint32_t node, const NodeProps *props) {
+    BlobBuilder *bb = ps->bb;
+    if (props->tag) {
+        NodeEntry *n = &bb->nodes.data[node];
+        n->tag_index = builder_intern_tag(bb, (const char *)props->tag, props->tag_len);
+        if (n->node_type == SCALAR && is_string_tag(props->tag, props->tag_len)) {
+            n->style_flags &= SCALAR_BLOCK;
+            if (bb->values.count && bb->values.data[bb->values.count - 1].node_index == node) bb->values.count--;
+        }
+    }
+    if (props->anchor) anchors_set(&ps->anchors, props->anchor, props->anchor_len, node);
+    if (props->tag && props->tag_len == sizeof(CJYAML_INCLUDE_TAG) - 1
+        && memcmp(props->tag, CJYAML_INCLUDE_TAG, props->tag_len) == 0) {
+        include_register(ps, node);
+    }
+    return node;
+}
+
+/* -------------------------
+   Flow collections ([a, b], {k: v})
+   -------------------------
+   Recursive descent over the raw bytes. Children of an open collection are kept on ps->scratch and emitted
+   as one contiguous index/pair range when it closes, so nested collections never interleave. The plain
+   scalar scan is a single table-driven loop that only stops on flow indicators, ':' and '#'.
+*/
+
+// skip whitespace, line breaks and comments inside a flow collection
+static size_t flow_skip_space(const ParserState *ps, size_t p) {
+    const unsigned char *d = ps->data;
+    while (p < ps->size) {
+        if (cj_is(d[p], CJ_WS | CJ_EOL)) {
+            ++p;
+        } else if (d[p] == '#' && (p == 0 || cj_is(d[p - 1], CJ_WS | CJ_EOL))) {
+            while (p < ps->size && !cj_is(d[p], CJ_EOL)) ++p;
+        } else {
+            break;
+        }
+    }
+    return p;
+}
+
+// scan a plain scalar inside a flow collection: [*pos, returned end) without trailing whitespace
+static size_t flow_scan_plain(const ParserState *ps, size_t *pos) {
+    const unsigned char *d = ps->data;
+    const size_t start = *pos;
+    size_t p = start;
+    for (;;) {
+        while (p < ps->size && !cj_is(d[p], CJ_FLOW | CJ_EOL | CJ_PLAIN_STOP)) ++p;
+        if (p >= ps->size || !cj_is(d[p], CJ_PLAIN_STOP)) break;
+        if (d[p] == ':' && (p + 1 >= ps->size || cj_is(d[p + 1], CJ_WS | CJ_EOL | CJ_FLOW))) break;
+        if (d[p] == '#' && p > start && cj_is(d[p - 1], CJ_WS)) break;
+        ++p;
+    }
+    *pos = p;
+    while (p > start && cj_is(d[p - 1], CJ_WS)) --p;
+    return p;
+}
+
+/* -------------------------
+   Quoted scalars ("...", '...')
+   -------------------------
+   The closing quote is located with a 16-byte SSE2 compare (scalar loop elsewhere); the unescaped run before
+   it is copied in one memcpy straight into the string arena tail, and escapes are decoded in place there.
+   Once the scalar is complete the tail is committed, so a decoded string equal to an existing one is still
+   deduplicated. Line breaks inside quotes are folded as in YAML (one break -> space, n empty lines -> n LFs).
+*/
+
+#ifdef CJ_HAVE_SSE2
+static inline unsigned cj_ctz32(const unsigned v) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long i;
+    _BitScanForward(&i, v);
+    return (unsigned)i;
+#else
+    return (unsigned)__builtin_ctz(v);
+#endif
+}
+#endif
+
+// first position in [p, end) holding `a`, `b`, '\n' or '\r'; end if none
+static const unsigned char *find_quote_stop(const unsigned char *p, const unsigned char *end, const unsigned char a, const unsigned char b) {
+#ifdef CJ_HAVE_SSE2
+    const __m128i va = _mm_set1_epi8((char)a);
+    const __m128i vb = _mm_set1_epi8((char)b);
+    const __m128i vn = _mm_set1_epi8('\n');
+    const __m128i vr = _mm_set1_epi8('\r');
+    while (end - p >= 16) {
+        const __m128i x = _mm_loadu_si128((const __m128i *)p);
+        const __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, va), _mm_cmpeq_epi8(x, vb)),
+                                       _mm_or_si128(_mm_cmpeq_epi8(x, vn), _mm_cmpeq_epi8(x, vr)));
+        const unsigned mask = (unsigned)_mm_movemask_epi8(m);
+        if (mask) return p + cj_ctz32(mask);
+        p += 16;
+    }
+#endif
+    while (p < end && *p != a && *p != b && !cj_is(*p, CJ_EOL)) ++p;
+    return p;
+}
+
+static bool parse_hex_digits(const unsigned char *p, const unsigned char *end, const int digits, uint32_t *out) {
+    if (end - p < digits) return false;
+    uint32_t v = 0;
+    for (int i = 0; i < digits; ++i) {
+        const unsigned char c = p[i];
+        uint32_t d;
+        if (cj_is(c, CJ_DIGIT)) d = (uint32_t)(c - '0');
+        else if (c >= 'a' && c <= 'f') d = (uint32_t)(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') d = (uint32_t)(c - 'A' + 10);
+        else return false;
+        v = (v << 4) | d;
+    }
+    *out = v;
+    return true;
+}
+
+// encode a code point as UTF-8 into dst (room for 4 bytes); 0 for surrogates / out of range
+static size_t utf8_encode(const uint32_t cp, char *dst) {
+    if (cp < 0x80) {
+        dst[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        dst[0] = (char)(0xC0 | (cp >> 6));
+        dst[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp >= 0xD800 && cp <= 0xDFFF) return 0;
+    if (cp < 0x10000) {
+        dst[0] = (char)(0xE0 | (cp >> 12));
+        dst[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        dst[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    if (cp > 0x10FFFF) return 0;
+    dst[0] = (char)(0xF0 | (cp >> 18));
+    dst[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    dst[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    dst[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+/*
+ Decode the escape sequence at p (p[0] == '\\') into dst (room for 4 bytes).
+ Returns the number of input bytes consumed (0 for an invalid escape) and stores the output length in *out_len.
+*/
+static size_t decode_escape(const unsigned char *p, const unsigned char *end, char *dst, size_t *out_len) {
+    if (end - p < 2) return 0;
+    const char *simple = NULL;
+    switch (p[1]) {
+        case '0': simple = "\0"; break;
+        case 'a': simple = "\a"; break;
+        case 'b': simple = "\b"; break;
+        case 't': case '\t': simple = "\t"; break;
+        case 'n': simple = "\n"; break;
+        case 'v': simple = "\v"; break;
+        case 'f': simple = "\f"; break;
+        case 'r': simple = "\r"; break;
+        case 'e': simple = "\x1b"; break;
+        case ' ': simple = " "; break;
+        case '"': simple = "\""; break;
+        case '/': simple = "/"; break;
+        case '\\': simple = "\\"; break;
+        case 'N': *out_len = utf8_encode(0x85, dst); return 2;
+        case '_': *out_len = utf8_encode(0xA0, dst); return 2;
+        case 'L': *out_len = utf8_encode(0x2028, dst); return 2;
+        case 'P': *out_len = utf8_encode(0x2029, dst); return 2;
+        case 'x': case 'u': case 'U': {
+            const int digits = p[1] == 'x' ? 2 : (p[1] == 'u' ? 4 : 8);
+            uint32_t cp;
+            if (!parse_hex_digits(p + 2, end, digits, &cp)) return 0;
+            size_t used = 2 + (size_t)digits;
+            if (p[1] == 'u' && cp >= 0xD800 && cp <= 0xDBFF) {
+                // UTF-16 surrogate pair written as two \u escapes
+                uint32_t lo;
+                if (end - (p + used) < 6 || p[used] != '\\' || p[used + 1] != 'u'
+                    || !parse_hex_digits(p + used + 2, end, 4, &lo) || lo < 0xDC00 || lo > 0xDFFF) return 0;
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                used += 6;
+            }
+            *out_len = utf8_encode(cp, dst);
+            return *out_len ? used : 0;
+        }
+        default:
+            return 0;
+    }
+    dst[0] = simple[0];
+    *out_len = 1;
+    return 2;
+}
+
+/*
+ Parse the quoted scalar opening at *pos. On success the decoded text is committed to the string arena,
+ *out is the new SCALAR node and *pos is just past the closing quote. On failure (unterminated or invalid
+ escape) nothing is emitted.
+*/
+static bool parse_quoted(ParserState *ps, size_t *pos, uint32_t *out) {
+    const unsigned char *d = ps->data;
+    const unsigned char *end = d + ps->size;
+    const unsigned char q = d[*pos];
+    const bool dq = q == '"';
+    StringArena *sa = &ps->bb->strings;
+    size_t w = 0;    // bytes decoded into the arena tail
+    size_t keep = 0; // decoded bytes that folding must not trim (escaped whitespace)
+
+    const unsigned char *p = d + *pos + 1;
+    for (;;) {
+        const unsigned char *stop = find_quote_stop(p, end, q, dq ? '\\' : q);
+        const size_t run = (size_t)(stop - p);
+        if (run) {
+            char *tail = strings_reserve(sa, w + run) + sa->size;
+            memcpy(tail + w, p, run);
+            w += run;
+        }
+        p = stop;
+        if (p >= end) return false; // unterminated
+
+        if (*p == q) {
+            if (!dq && p + 1 < end && p[1] == '\'') { // '' inside single quotes
+                strings_reserve(sa, w + 1)[sa->size + w] = '\'';
+                keep = ++w;
+                p += 2;
+                continue;
+            }
+            ++p;
+            break;
+        }
+
+        if (*p == '\\') {
+            if (p + 1 < end && cj_is(p[1], CJ_EOL)) {
+                // escaped line break: joined without a space, leading whitespace of the next line dropped
+                p += (p[1] == '\r' && p + 2 < end && p[2] == '\n') ? 3 : 2;
+                while (p < end && cj_is(*p, CJ_WS)) ++p;
+                keep = w;
+                continue;
+            }
+            char *tail = strings_reserve(sa, w + 4) + sa->size;
+            size_t out_len = 0;
+            const size_t used = decode_escape(p, end, tail + w, &out_len);
+            if (!used) return false;
+            w += out_len;
+            keep = w;
+            p += used;
+            continue;
+        }
+
+        // line break: trim trailing whitespace, count breaks, skip indentation of the continuation lines
+        char *tail = sa->data + sa->size; // w > 0 implies the arena exists
+        while (w > keep && (tail[w - 1] == ' ' || tail[w - 1] == '\t')) --w;
+        size_t breaks = 0;
+        while (p < end && cj_is(*p, CJ_EOL)) {
+            p += (p[0] == '\r' && p + 1 < end && p[1] == '\n') ? 2 : 1;
+            ++breaks;
+            while (p < end && cj_is(*p, CJ_WS)) ++p;
+        }
+        const size_t fold = breaks == 1 ? 1 : breaks - 1;
+        tail = strings_reserve(sa, w + fold) + sa->size;
+        memset(tail + w, breaks == 1 ? ' ' : '\n', fold);
+        w += fold;
+        keep = w;
+    }
+
+    const uint64_t offset = strings_commit_tail(sa, w);
+    *out = builder_add_scalar_at(ps->bb, offset, w, SCALAR_STRING, 0);
+    *pos = (size_t)(p - d);
+    return true;
+}
+
+static bool parse_flow_node(ParserState *ps, size_t *pos, int depth, uint32_t *out);
+
+static bool parse_flow_sequence(ParserState *ps, size_t *pos, const int depth, uint32_t *out) {
+    const unsigned char *d = ps->data;
+    const size_t base = ps->scratch.count;
+    size_t p = *pos + 1; // past '['
+    for (;;) {
+        p = flow_skip_space(ps, p);
+        if (p >= ps->size) return false;
+        if (d[p] == ']') { ++p; break; }
+
+        uint32_t child;
+        if (!parse_flow_node(ps, &p, depth + 1, &child)) return false;
+        index_push(&ps->scratch, child);
+
+        p = flow_skip_space(ps, p);
+        if (p >= ps->size) return false;
+        if (d[p] == ',') { ++p; continue; }
+        if (d[p] == ']') { ++p; break; }
+        return false;
+    }
+    *out = builder_add_sequence(ps->bb, ps->scratch.data + base, ps->scratch.count - base);
+    ps->scratch.count = base;
+    *pos = p;
+    return true;
+}
+
+static bool parse_flow_mapping(ParserState *ps, size_t *pos, const int depth, uint32_t *out) {
+    const unsigned char *d = ps->data;
+    const size_t base = ps->scratch.count;
+    size_t merge_at = SIZE_MAX; // position of the first plain '<<' key
+    size_t p = *pos + 1; // past '{'
+    for (;;) {
+        p = flow_skip_space(ps, p);
+        if (p >= ps->size) return false;
+        if (d[p] == '}') { ++p; break; }
+        if (cj_is(d[p], CJ_FLOW)) return false; // complex keys / empty entries are not supported
+
+        uint32_t key;
+        if (d[p] == '"' || d[p] == '\'') {
+            if (!parse_quoted(ps, &p, &key)) return false;
+        } else {
+            const size_t kb = p;
+            const size_t ke = flow_scan_plain(ps, &p);
+            if (ke == kb) return false;
+            if (merge_at == SIZE_MAX && is_merge_key(d + kb, ke - kb)) merge_at = (ps->scratch.count - base) / 2;
+            key = builder_add_scalar(ps->bb, (const char *)d + kb, ke - kb, 0, 0);
+        }
+
+        uint32_t value;
+        p = flow_skip_space(ps, p);
+        if (p < ps->size && d[p] == ':') {
+            p = flow_skip_space(ps, p + 1);
+            if (p >= ps->size) return false;
+            if (d[p] == ',' || d[p] == '}') {
+                value = builder_add_plain_scalar(ps->bb, "", 0); // {k: } -> null
+            } else if (!parse_flow_node(ps, &p, depth + 1, &value)) {
+                return false;
+            }
+        } else {
+            value = builder_add_plain_scalar(ps->bb, "", 0); // {k} -> k: null
+        }
+        index_push(&ps->scratch, key);
+        index_push(&ps->scratch, value);
+
+        p = flow_skip_space(ps, p);
+        if (p >= ps->size) return false;
+        if (d[p] == ',') { ++p; continue; }
+        if (d[p] == '}') { ++p; break; }
+        return false;
+    }
+    const uint64_t first = ps->bb->pairs.count;
+    for (size_t i = base; i < ps->scratch.count; i += 2) {
+        builder_append_pair(ps->bb, ps->scratch.data[i], ps->scratch.data[i + 1]);
+    }
+    const size_t count = (ps->scratch.count - base) / 2;
+    *out = builder_add_mapping(ps->bb, first, count, builder_place_merge(ps->bb, first, count, merge_at));
+    ps->scratch.count = base;
+    *pos = p;
+    return true;
+}
+
+static bool parse_flow_node(ParserState *ps, size_t *pos, const int depth, uint32_t *out) {
+    if (depth > CJYAML_MAX_FLOW_DEPTH) return false;
+    const unsigned char c = ps->data[*pos];
+    if (c == '[') return parse_flow_sequence(ps, pos, depth, out);
+    if (c == '{') return parse_flow_mapping(ps, pos, depth, out);
+    if (c == '"' || c == '\'') return parse_quoted(ps, pos, out);
+    if (cj_is(c, CJ_FLOW)) return false;
+
+    if (c == '*') {
+        const size_t nb = *pos + 1;
+        const size_t ne = scan_anchor_name(ps->data, nb, ps->size);
+        uint32_t target;
+        if (ne == nb || !anchors_get(&ps->anchors, ps->data + nb, ne - nb, &target)) return false; // unknown alias
+        *out = builder_add_alias(ps->bb, target);
+        *pos = ne;
+        return true;
+    }
+    if (c == '&' || c == '!') {
+        NodeProps props;
+        size_t p = *pos;
+        if (!scan_node_props(ps->data, &p, ps->size, &props)) return false;
+        p = flow_skip_space(ps, p);
+        if (p >= ps->size) return false;
+        if (ps->data[p] == ',' || ps->data[p] == ']' || ps->data[p] == '}') {
+            *out = builder_add_plain_scalar(ps->bb, "", 0); // properties on an empty node
+        } else if (!parse_flow_node(ps, &p, depth + 1, out)) {
+            return false;
+        }
+        apply_node_props(ps, *out, &props);
+        *pos = p;
+        return true;
+    }
+
+    const size_t b = *pos;
+    const size_t e = flow_scan_plain(ps, pos);
+    *out = builder_add_plain_scalar(ps->bb, (const char *)ps->data + b, e - b);
+    return true;
+}
+
+/* -------------------------
+   Block scalars (| literal, > folded)
+   -------------------------
+   Content lines are located with memchr and their text (minus the indentation) is copied with one memcpy
+   per line straight into the string arena tail; no per-character processing. Chomping: '-' strips all
+   trailing line breaks, '+' keeps them, default clips to one. An explicit indentation digit is relative to
+   the parent line, otherwise the indentation of the first non-empty line is used.
+*/
+
+// parse the header "|" / ">" with optional chomping and indentation indicators, optionally followed by a comment
+static bool parse_block_header(const unsigned char *d, const size_t vb, const size_t e, bool *folded, char *chomp, size_t *explicit_indent) {
+    *folded = d[vb] == '>';
+    *chomp = 0;
+    *explicit_indent = 0;
+    size_t p = vb + 1;
+    for (int i = 0; i < 2 && p < e; ++i, ++p) {
+        if ((d[p] == '-' || d[p] == '+') && !*chomp) *chomp = (char)d[p];
+        else if (d[p] >= '1' && d[p] <= '9' && !*explicit_indent) *explicit_indent = (size_t)(d[p] - '0');
+        else break;
+    }
+    if (p < e && !cj_is(d[p], CJ_WS)) return false;
+    return is_comment_or_empty(d, p, e);
+}
+
+static bool parse_block_scalar(ParserState *ps, const size_t vb, const size_t e, size_t *line_end, uint32_t *out) {
+    bool folded;
+    char chomp;
+    size_t explicit_indent;
+    if (!parse_block_header(ps->data, vb, e, &folded, &chomp, &explicit_indent)) return false;
+
+    const unsigned char *d = ps->data;
+    const size_t n = ps->size;
+    StringArena *sa = &ps->bb->strings;
+    size_t indent = explicit_indent ? ps->line_indent + explicit_indent : 0;
+    size_t w = 0;             // bytes written into the arena tail
+    size_t pending = 0;       // line breaks not emitted yet (the previous line's break + empty lines)
+    bool any = false;         // a content line was seen
+    bool prev_more = false;   // folded: previous content line was more indented (kept verbatim)
+    bool broken = true;       // the last line read ended with a line break (not the end of the document)
+    size_t consumed = *line_end; // end of the last line belonging to the scalar
+
+    size_t ls = *line_end;
+    if (ls < n && d[ls] == '\r') ++ls;
+    if (ls < n && d[ls] == '\n') ++ls;
+    while (ls < n) {
+        const unsigned char *nl = memchr(d + ls, '\n', n - ls);
+        const size_t next = nl ? (size_t)(nl - d) + 1 : n;
+        size_t le = nl ? (size_t)(nl - d) : n;
+        if (le > ls && d[le - 1] == '\r') --le;
+
+        size_t sp = ls;
+        while (sp < le && d[sp] == ' ') ++sp;
+        size_t t = sp;
+        while (t < le && cj_is(d[t], CJ_WS)) ++t;
+        if (t == le && (!indent || le - ls <= indent)) { // empty line; white space past the indentation is content
+            ++pending;
+            broken = nl != NULL;
+            consumed = le;
+            ls = next;
+            continue;
+        }
+        if (!indent) {
+            if (sp - ls <= ps->line_indent) break; // no content at all
+            indent = sp - ls;
+        }
+        if (sp - ls < indent) break; // less indented: the scalar ends here
+
+        const size_t tb = ls + indent;
+        const size_t len = le - tb;
+        const bool more = folded && cj_is(d[tb], CJ_WS);
+        char *tail = strings_reserve(sa, w + pending + 1 + len + 1) + sa->size;
+        if (!any) {
+            memset(tail + w, '\n', pending); // leading empty lines
+            w += pending;
+        } else if (folded && !prev_more && !more) {
+            // folding: a single break between text lines becomes a space, each empty line stays a LF
+            if (pending) {
+                memset(tail + w, '\n', pending);
+                w += pending;
+            } else {
+                tail[w++] = ' ';
+            }
+        } else {
+            memset(tail + w, '\n', pending + 1);
+            w += pending + 1;
+        }
+        memcpy(tail + w, d + tb, len);
+        w += len;
+
+        any = true;
+        prev_more = more;
+        pending = 0;
+        broken = nl != NULL;
+        consumed = le;
+        ls = next;
+    }
+
+    // chomping of the final line break and trailing empty lines; a document ending without a break adds none
+    size_t breaks = 0;
+    if (any && chomp != '-') breaks = chomp == '+' ? pending + broken : pending || broken;
+    else if (!any && chomp == '+' && pending) breaks = pending - 1 + broken;
+    if (breaks) {
+        char *tail = strings_reserve(sa, w + breaks) + sa->size;
+        memset(tail + w, '\n', breaks);
+        w += breaks;
+    }
+
+    const uint64_t offset = strings_commit_tail(sa, w);
+    *out = builder_add_scalar_at(ps->bb, offset, w, SCALAR_BLOCK, 0);
+    *line_end = consumed;
+    return true;
+}
+
+/*
+ Parse the value starting at vb on the current line [.., e).
+ Properties (&anchor, !tag) apply to the value that follows them; an alias (*name) becomes an ALIAS node.
+ A block scalar header ('|' / '>') consumes the following more-indented lines.
+ A value opening with '[', '{' or a quote is parsed as a flow collection / quoted scalar, which may continue on
+ following lines; then *line_end is moved to the end of the line holding the closing bracket or quote. Anything
+ that is not well-formed (or has trailing content after it) is kept as a plain scalar, as before.
+*/
+static uint32_t parse_value(ParserState *ps, const size_t vb, const size_t e, size_t *line_end) {
+    const unsigned char *d = ps->data;
+    if (vb < e && (d[vb] == '&' || d[vb] == '!')) {
+        NodeProps props;
+        size_t p = vb;
+        if (scan_node_props(d, &p, e, &props)) {
+            // "&name !tag value"; properties alone apply to the null placeholder a following block sequence is
+            // stored over, and its anchor is held until then (parse_lines binds it before the next other line)
+            while (p < e && cj_is(d[p], CJ_WS)) ++p;
+            if (!is_comment_or_empty(d, p, e)) return apply_node_props(ps, parse_value(ps, p, e, line_end), &props);
+            const uint32_t node = builder_add_plain_scalar(ps->bb, "", 0);
+            bind_held_anchor(ps);
+            ps->held_anchor = props.anchor;
+            ps->held_anchor_len = props.anchor_len;
+            ps->held_node = node;
+            props.anchor = NULL;
+            return apply_node_props(ps, node, &props);
+        }
+    }
+    if (vb + 1 < e && d[vb] == '*') {
+        const size_t ne = scan_anchor_name(d, vb + 1, e);
+        size_t rest = ne;
+        while (rest < e && cj_is(d[rest], CJ_WS)) ++rest;
+        uint32_t target;
+        if (ne > vb + 1 && is_comment_or_empty(d, rest, e) && anchors_get(&ps->anchors, d + vb + 1, ne - vb - 1, &target)) {
+            return builder_add_alias(ps->bb, target);
+        }
+    }
+    if (vb < e && (d[vb] == '|' || d[vb] == '>')) {
+        uint32_t node;
+        if (parse_block_scalar(ps, vb, e, line_end, &node)) return node;
+    }
+    if (vb < e && (d[vb] == '[' || d[vb] == '{' || d[vb] == '"' || d[vb] == '\'')) {
+        BlobBuilder *bb = ps->bb;
+        const size_t nodes = bb->nodes.count, pairs = bb->pairs.count, indices = bb->indices.count, values = bb->values.count;
+        const size_t tags = bb->tags.count;
+
+        size_t p = vb;
+        uint32_t node;
+        ps->anchors.flow_first = (uint32_t)nodes;
+        if (parse_flow_node(ps, &p, 0, &node)) {
+            size_t le = p;
+            while (le < ps->size && !cj_is(d[le], CJ_EOL)) ++le;
+            if (is_comment_or_empty(d, p, le)) {
+                *line_end = le;
+                return node;
+            }
+        }
+        // not well-formed: roll back whatever was emitted (strings stay deduplicated)
+        bb->nodes.count = nodes;
+        bb->pairs.count = pairs;
+        bb->indices.count = indices;
+        bb->values.count = values;
+        tags_truncate(&bb->tags, tags);
+        ps->scratch.count = 0;
+        if (ps->anchors.count) anchors_forget_from(&ps->anchors, (uint32_t)nodes);
+        while (ps->includes.count && ps->includes.data[ps->includes.count - 1].node >= nodes) {
+            IncludeJob *job = &ps->includes.data[--ps->includes.count];
+            cj_release(job->path);
+            builder_free(&job->bb);
+        }
+    }
+
+    size_t tb, te;
+    trim_span(d + vb, e - vb, &tb, &te);
+    return builder_add_plain_scalar(ps->bb, (const char *)d + vb + tb, te - tb);
+}
+
+static void top_push(ParserState *ps, const uint32_t key, const uint32_t value) {
+    PairEntry p;
+    p.key_node_index = key;
+    p.value_node_index = value;
+    pairs_push(&ps->top, p);
+}
+
+/* -------------------------
+   !include resolution
+   -------------------------
+   "!include path" scalars are collected while a document is parsed. Afterwards every referenced file is parsed
+   into its own builder - the includes of the root document concurrently, one worker per CPU (max
+   CJYAML_MAX_INCLUDE_THREADS), nested includes serially inside their worker - and the builders are spliced into
+   the including one in document order with relocated node/pair/index/string/tag references. The placeholder
+   becomes an ALIAS of the included root and keeps its !include tag. Files that cannot be read stay unresolved.
+*/
+
+static uint32_t parse_document(const unsigned char *data, size_t size, BlobBuilder *bb, ParserScratch *keep,
+                               const char *base_dir, const IncludeChain *chain, int include_depth,
+                               size_t include_threads);
+
+// parse one included file; its own includes resolve against its directory (the includer's if the path has none)
+static void run_include_job(IncludeJob *job, const char *base_dir, const IncludeChain *chain, const int depth) {
+    size_t size = 0;
+    void *mapped = mapFile(job->path, &size);
+    if (mapped == NULL) return;
+    char dir[CJ_PATH_MAX];
+    const IncludeChain link = { job->path, chain };
+    job->root = parse_document(mapped, size, &job->bb, NULL, path_dirname(job->path, dir, sizeof(dir)) ? dir : base_dir,
+                               &link, depth, 1);
+    unmapFile(mapped, size);
+}
+
+typedef struct {
+    IncludeJob *jobs;
+    size_t count;
+    size_t first;   // this worker runs jobs first, first + stride, ...
+    size_t stride;
+    const char *base_dir; // directory of the including document
+    const IncludeChain *chain;
+    int depth;
+} IncludeWorker;
+
+static void include_worker_run(const IncludeWorker *w) {
+    for (size_t i = w->first; i < w->count; i += w->stride) {
+        run_include_job(&w->jobs[i], w->base_dir, w->chain, w->depth);
+    }
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI include_worker_main(LPVOID arg) {
+    include_worker_run(arg);
+    return 0;
+}
+#else
+static void *include_worker_main(void *arg) {
+    include_worker_run(arg);
+    return NULL;
+}
+#endif
+
+static size_t online_cpus(void) {
+#if defined(_WIN32)
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwNumberOfProcessors ? (size_t)si.dwNumberOfProcessors : 1;
+#else
+    const long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (size_t)n : 1;
+#endif
+}
+
+/*
+ Parse the jobs on `threads` threads (0 = one per CPU), the calling thread being one of them. The threads live for
+ this call only: the library keeps no global state to own a pool, and starting a few threads is cheap next to
+ mapping and parsing the files they are started for (only documents with includes, and only when enabled).
+*/
+static void run_include_jobs(IncludeJob *jobs, const size_t count, const char *base_dir, const IncludeChain *chain,
+                             const int depth, size_t threads) {
+    if (threads == 0) threads = online_cpus();
+    if (threads > count) threads = count;
+    if (threads > CJYAML_MAX_INCLUDE_THREADS) threads = CJYAML_MAX_INCLUDE_THREADS;
+
+    IncludeWorker workers[CJYAML_MAX_INCLUDE_THREADS];
+    bool started[CJYAML_MAX_INCLUDE_THREADS] = { false };
+#if defined(_WIN32)
+    HANDLE handles[CJYAML_MAX_INCLUDE_THREADS];
+#else
+    pthread_t handles[CJYAML_MAX_INCLUDE_THREADS];
+#endif
+    /*
+     The workers run outside the including parse's scope: an allocation failure there would unwind past the join
+     and free the jobs under the running threads. Each job fails into its own builder instead, and resolve_includes
+     raises the first status once every thread is joined.
+    */
+    BuildScope *const scope = build_scope;
+    build_scope = NULL;
+    for (size_t t = 0; t < threads; ++t) {
+        workers[t].jobs = jobs;
+        workers[t].count = count;
+        workers[t].first = t;
+        workers[t].stride = threads;
+        workers[t].base_dir = base_dir;
+        workers[t].chain = chain;
+        workers[t].depth = depth;
+    }
+    // worker 0 runs on the calling thread; a worker whose thread cannot be started runs here as well
+    for (size_t t = 1; t < threads; ++t) {
+#if defined(_WIN32)
+        handles[t] = CreateThread(NULL, 0, include_worker_main, &workers[t], 0, NULL);
+        started[t] = handles[t] != NULL;
+#else
+        started[t] = pthread_create(&handles[t], NULL, include_worker_main, &workers[t]) == 0;
+#endif
+    }
+    for (size_t t = 0; t < threads; ++t) {
+        if (!started[t]) include_worker_run(&workers[t]);
+    }
+    for (size_t t = 1; t < threads; ++t) {
+        if (!started[t]) continue;
+#if defined(_WIN32)
+        WaitForSingleObject(handles[t], INFINITE);
+        CloseHandle(handles[t]);
+#else
+        pthread_join(handles[t], NULL);
+#endif
+    }
+    build_scope = scope;
+}
+
+/*
+ Append the nodes, pairs, indices, typed values and tags of `sub` to `bb`, relocating every reference, and return
+ the relocated index of sub_root. Strings and tags are re-interned, so text shared with the parent is stored once.
+*/
+static uint32_t builder_splice(BlobBuilder *bb, const BlobBuilder *sub, const uint32_t sub_root) {
+    const uint32_t node_base = (uint32_t)bb->nodes.count;
+    const uint64_t pair_base = bb->pairs.count;
+    const uint64_t index_base = bb->indices.count;
+    const cjyaml_capacity c = {
+        bb->nodes.count + sub->nodes.count, bb->pairs.count + sub->pairs.count,
+        bb->indices.count + sub->indices.count, 0, bb->strings.size + sub->strings.size
+    };
+    builder_reserve(bb, &c);
+
+    for (size_t i = 0; i < sub->nodes.count; ++i) {
+        NodeEntry n = sub->nodes.data[i];
+        switch (n.node_type) {
+            case SCALAR:   n.a = strings_intern(&bb->strings, sub->strings.data + n.a, (size_t)n.b); break;
+            case SEQUENCE: n.a += index_base; break;
+            case MAPPING:  n.a += pair_base; break;
+            case ALIAS:
+            case DOCUMENT: n.a += node_base; break;
+            default: break;
+        }
+        if (n.tag_index && n.tag_index <= sub->tags.count) {
+            const TagEntry *t = &sub->tags.data[n.tag_index - 1];
+            n.tag_index = builder_intern_tag(bb, sub->strings.data + t->name_offset, t->name_len);
+        } else {
+            n.tag_index = 0;
+        }
+        nodes_push(&bb->nodes, n);
+    }
+    for (size_t i = 0; i < sub->pairs.count; ++i) {
+        PairEntry pe = sub->pairs.data[i];
+        pe.key_node_index += node_base;
+        pe.value_node_index += node_base;
+        pairs_push(&bb->pairs, pe);
+    }
+    for (size_t i = 0; i < sub->indices.count; ++i) {
+        index_push(&bb->indices, sub->indices.data[i] + node_base);
+    }
+    for (size_t i = 0; i < sub->values.count; ++i) {
+        ScalarValue v = sub->values.data[i];
+        v.node_index += node_base;
+        values_push(&bb->values, v);
+    }
+    return sub_root + node_base;
+}
+
+static void resolve_includes(ParserState *ps) {
+    IncludeVec *v = &ps->includes;
+    if (!v->count) return;
+    run_include_jobs(v->data, v->count, ps->base_dir, ps->chain, ps->include_depth + 1, ps->include_threads);
+    for (size_t i = 0; i < v->count; ++i) {
+        IncludeJob *job = &v->data[i];
+        ps->bb->allocs += job->bb.allocs;
+        if (job->bb.status != CJYAML_OK) build_fail(job->bb.status); // out of memory/budget: the whole parse fails
+        if (job->root == UINT32_MAX) continue;
+        const uint32_t root = builder_splice(ps->bb, &job->bb, job->root);
+        NodeEntry *placeholder = &ps->bb->nodes.data[job->node];
+        placeholder->node_type = ALIAS;
+        placeholder->style_flags = 0;
+        placeholder->a = root;
+        placeholder->b = 0;
+    }
+}
+
+// the line loop of parse_document; allocation failures unwind out of it (see build_guarded)
+static uint32_t parse_lines(ParserState *ps) {
+    const unsigned char *data = ps->data;
+    const size_t fileSize = ps->size;
+    BlobBuilder *bb = ps->bb;
+
+    // Parse line by line
+    size_t pos = 0;
+    while (pos < fileSize) {
+        // find end of line
+        size_t line_start = pos;
+        size_t line_end = pos;
+        while (line_end < fileSize && !cj_is(data[line_end], CJ_EOL)) ++line_end;
+
+        // trim
+        size_t b, e;
+        // Data is a pointer to an array of characters, so if we add the beginning of a line to it,
+        // then only the line is passed to the function, not the entire contents of the file.
+        trim_span(data + line_start, line_end - line_start, &b, &e);
+        b += line_start;
+        e += line_start; // adjust to absolute offsets
+        ps->line_indent = b - line_start;
+
+        if (!is_comment_or_empty(data, b, e)) {
+            // This notation works because b is the first non-whitespace character,
+            // so if b is less than e -1, it means that string has at least 2 characters and if the first non-whitespace character is '-' and the next is a space,
+            // and we know that after the next character there is another character (because if abs(b-e)>2 && last char is not white-space), it's mean it must be a scalar.
+            if (b < e -1 && data[b] == '-' && cj_is(data[b + 1], CJ_WS)) {
+                // SEQUENCE ITEM CASE
+
+                // If b < e -1 --> abs(b-e) > 2 --> data[b+2] != nullptr
+                if (!held_anchor_awaits_sequence(ps)) bind_held_anchor(ps);
+                size_t item_b = findFirstCharInScalarAfterDash(data, b + 2, e);
+                const uint32_t item_node = parse_value(ps, item_b, e, &line_end);
+
+                if (!ps->in_seq) {
+                    // "key:" with an empty value followed by items -> the items are that key's value
+                    const NodeEntry *last_value = ps->top.count
+                        ? &bb->nodes.data[ps->top.data[ps->top.count - 1].value_node_index] : NULL;
+                    if (last_value && last_value->node_type == SCALAR && (last_value->style_flags & SCALAR_NULL) && last_value->b == 0) {
+                        ps->seq_pair = ps->top.count - 1;
+                    } else {
+                        // otherwise start a new anonymous sequence mapped under the special key ""
+                        const uint32_t empty_k = builder_add_scalar(bb, "", 0, 0, 0);
+                        top_push(ps, empty_k, builder_add_plain_scalar(bb, "", 0));
+                        ps->seq_pair = ps->top.count - 1;
+                    }
+                    ps->in_seq = true;
+                }
+                index_push(&ps->seq_items, item_node);
+            } else {
+                flush_block_sequence(ps);
+                bind_held_anchor(ps);
+
+                // mapping "key: value" (split at first ':'); lines opening a flow collection are bare values
+                uint32_t knode = UINT32_MAX;
+                size_t colon = b;
+                if (data[b] == '"' || data[b] == '\'') {
+                    // quoted key: the ':' must follow the closing quote on the same line
+                    size_t q = b;
+                    if (parse_quoted(ps, &q, &knode)) {
+                        while (q < e && cj_is(data[q], CJ_WS)) ++q;
+                        if (q < e && data[q] == ':' && (q + 1 == e || cj_is(data[q + 1], CJ_WS))) {
+                            colon = q;
+                        } else {
+                            bb->nodes.count--; // a quoted value, not a key
+                            knode = UINT32_MAX;
+                            colon = e;
+                        }
+                    } else {
+                        colon = e;
+                    }
+                } else if (data[b] != '[' && data[b] != '{') {
+                    while (colon < e && data[colon] != ':') ++colon;
+                } else {
+                    colon = e;
+                }
+                if (colon < e && data[colon] == ':') {
+                    if (knode == UINT32_MAX) {
+                        // key = [b, colon)
+                        size_t kb, ke;
+                        trim_span(data + b, colon - b, &kb, &ke);
+                        kb += b; ke += b;
+                        knode = builder_add_scalar(bb, (const char *)data + kb, ke - kb, 0, 0);
+                        if (ps->top_merge == SIZE_MAX && is_merge_key(data + kb, ke - kb)) ps->top_merge = ps->top.count;
+                    }
+                    // value = after colon
+                    size_t vb = colon + 1;
+                    // skip spaces after colon
+                    while (vb < e && cj_is(data[vb], CJ_WS)) ++vb;
+
+                    const uint32_t vnode = parse_value(ps, vb, e, &line_end);
+                    top_push(ps, knode, vnode);
                 } else {
                     // no colon found: treat as plain scalar/document root (store as single scalar)
-                    size_t tb, te;
-                    trim_span(data + b, e - b, &tb, &te);
-                    tb += b; te += b;
-                    char *s = memdup_str(data, tb, te);
-                    if (!s) goto err;
-                    uint32_t n = builder_add_scalar(&bb, s, strlen(s), 0, 0);
-                    free(s);
+                    const uint32_t n = parse_value(ps, b, e, &line_end);
                     // append as a pair with empty key
-                    uint32_t empty_k = builder_add_scalar(&bb, "", 0, 0, 0);
-                    builder_append_pair(&bb, empty_k, n);
-                    last_key_node = empty_k;
-                    expecting_sequence_for_last_key = 0;
+                    const uint32_t empty_k = builder_add_scalar(bb, "", 0, 0, 0);
+                    top_push(ps, empty_k, n);
                 }
             }
         }
@@ -681,45 +2705,147 @@ static unsigned char *parse(const void *mappedFile, const size_t fileSize, size_
         if (pos < fileSize && data[pos] == '\n') ++pos;
         // alternatively just skip single newline; the above handles both \r\n and \n
     }
+    flush_block_sequence(ps);
+    bind_held_anchor(ps);
+
+    // After collecting pairs, create a top-level mapping node that spans the top-level pairs
+    uint32_t root = UINT32_MAX;
+    if (ps->top.count > 0) {
+        const uint64_t first = bb->pairs.count;
+        for (size_t i = 0; i < ps->top.count; ++i) {
+            pairs_push(&bb->pairs, ps->top.data[i]);
+        }
+        root = builder_add_mapping(bb, first, ps->top.count, builder_place_merge(bb, first, ps->top.count, ps->top_merge));
+    }
+    resolve_includes(ps);
+    return root;
+}
 
-    // After collecting pairs, create a top-level mapping node that spans all pairs
-    if (bb.pairs.count > 0) {
-        NodeEntry top;
-        top.node_type = 2; top.style_flags = 0; top.tag_index = 0;
-        top.a = 0; // first pair index
-        top.b = bb.pairs.count;
-        nodes_push(&bb.nodes, top);
-        uint32_t top_idx = (uint32_t)(bb.nodes.count - 1);
-
-        // create document node referencing top
-        NodeEntry doc;
-        doc.node_type = 4; doc.style_flags = 0; doc.tag_index = 0;
-        doc.a = top_idx; doc.b = 0;
-        nodes_push(&bb.nodes, doc);
-    } else {
-        // empty document -> create empty document node pointing to nothing (or a null root)
+typedef struct {
+    ParserState *ps;
+    uint32_t root;
+} DocumentRun;
+
+static void parse_document_run(void *arg) {
+    DocumentRun *run = arg;
+    if (run->ps->bb->presize) builder_presize(run->ps->bb, run->ps->data, run->ps->size);
+    run->root = parse_lines(run->ps);
+    if (run->ps->include_depth == 0) {
+        // create document node referencing the root (an empty document points to node 0)
         NodeEntry doc;
-        doc.node_type = 4; doc.style_flags = 0; doc.tag_index = 0;
-        doc.a = 0; doc.b = 0;
-        nodes_push(&bb.nodes, doc);
+        doc.node_type = DOCUMENT; doc.style_flags = 0; doc.tag_index = 0;
+        doc.a = run->root == UINT32_MAX ? 0 : run->root; doc.b = 0;
+        nodes_push(&run->ps->bb->nodes, doc);
     }
+}
 
-    size_t blob_size = 0;
-    unsigned char *blob_buf = builder_build_to_memory(&bb, &blob_size, CJYAML_MAGIC, 1, 0, 1);
-    if (!blob_buf) {
-        builder_free(&bb);
-        *out_size = 0;
-        return NULL;
+/*
+ Parse one YAML document into bb and return its root node (UINT32_MAX for an empty document or an error,
+ which is left in bb->status). The root document (include_depth 0) also gets its DOCUMENT node. Included files are parsed and spliced in
+ before this returns. keep (may be NULL) lends the parser its vectors from a previous parse.
+*/
+static uint32_t parse_document(const unsigned char *data, const size_t fileSize, BlobBuilder *bb, ParserScratch *keep,
+                               const char *base_dir, const IncludeChain *chain, const int include_depth,
+                               const size_t include_threads) {
+    ParserState ps;
+    parser_state_init(&ps, data, fileSize, bb, base_dir, chain, include_depth, include_threads);
+    if (keep) parser_state_adopt(&ps, keep);
+    DocumentRun run = { &ps, UINT32_MAX };
+    if (!build_guarded(bb, parse_document_run, &run)) run.root = UINT32_MAX;
+    if (keep) parser_state_release(&ps, keep);
+    parser_state_free(&ps);
+    return run.root;
+}
+
+struct cjyaml_context {
+    BlobBuilder bb;
+    ParserScratch scratch;
+};
+
+// bytes a reset context still holds: what its tables and parser scratch cost a fresh parse to allocate
+static size_t context_capacity(const cjyaml_context *ctx) {
+    const BlobBuilder *bb = &ctx->bb;
+    const ParserScratch *k = &ctx->scratch;
+    return bb->nodes.cap * sizeof(NodeEntry) + bb->pairs.cap * sizeof(PairEntry) + bb->indices.cap * sizeof(uint32_t)
+        + bb->strings.cap + bb->strings.slot_cap * sizeof(StringSlot) + bb->values.cap * sizeof(ScalarValue)
+        + bb->tags.cap * sizeof(TagEntry) + bb->tags.slot_cap * sizeof(uint16_t)
+        + k->top.cap * sizeof(PairEntry) + (k->seq_items.cap + k->scratch.cap) * sizeof(uint32_t)
+        + k->anchors.cap * sizeof(AnchorSlot);
+}
+
+static void context_release(cjyaml_context *ctx) {
+    builder_free(&ctx->bb);
+    parser_scratch_free(&ctx->scratch, &ctx->bb.alloc);
+}
+
+/*
+ Parse a whole buffer into a blob; base_dir is the canonical directory of the document, which !include paths are
+ resolved in when the options enable them (NULL: no includes). With a context its builder and parser scratch are
+ reset and reused, otherwise a fresh builder is freed after.
+ The memory a context retains counts towards max_bytes as if the parse had allocated it, so a warmed context
+ never holds more than the budget. It is released first when it alone exceeds the budget, and a parse that runs
+ out with retained memory charged is retried once from a trimmed context, so the context never fails a document
+ that a fresh builder parses within the budget.
+*/
+static int parse_with_base(const void *mappedFile, const size_t fileSize, const char *base_dir, const IncludeChain *chain,
+                           cjyaml_context *ctx, const cjyaml_parse_options *options, unsigned char **out_blob, size_t *out_size) {
+    if (out_blob) *out_blob = NULL;
+    if (out_size) *out_size = 0;
+    if (!mappedFile || fileSize == 0 || out_blob == NULL || out_size == NULL) {
+        return CJYAML_EINVAL;
     }
-    builder_free(&bb);
-    *out_size = blob_size;
-    return blob_buf;
 
+    BlobBuilder local;
+    BlobBuilder *bb = ctx ? &ctx->bb : &local;
+    size_t retained = 0;
+    if (ctx) {
+        builder_reset(bb);
+        retained = context_capacity(ctx);
+        if (options && options->max_bytes && retained > options->max_bytes) {
+            context_release(ctx);
+            retained = 0;
+        }
+        bb->bytes = retained;
+    } else {
+        builder_init(bb);
+    }
+    if (options) {
+        const cjyaml_allocator *a = options->allocator;
+        if (a && !ctx) {
+            if (!a->malloc_fn || !a->realloc_fn || !a->free_fn) return CJYAML_EINVAL;
+            bb->alloc = *a;
+        }
+        bb->max_bytes = options->max_bytes;
+        bb->presize = !(options->flags & CJYAML_PARSE_NO_PRESIZE);
+    }
+    if (!options || !(options->flags & CJYAML_PARSE_INCLUDES)) base_dir = NULL;
+    parse_document(mappedFile, fileSize, bb, ctx ? &ctx->scratch : NULL, base_dir, chain, 0,
+                   options ? options->include_threads : 0);
+
+    int status = bb->status;
+    if (status == CJYAML_OK) {
+        const uint32_t flags = (options && (options->flags & CJYAML_PARSE_CHECKSUM)) ? CJYAML_FLAG_CHECKSUM : 0;
+        *out_blob = builder_build_to_memory(bb, out_size, CJYAML_MAGIC, CJYAML_VERSION, flags, 1);
+        if (!*out_blob) status = CJYAML_ENOMEM;
+    }
+    if (status == CJYAML_ELIMIT && retained) {
+        context_release(ctx);
+        return parse_with_base(mappedFile, fileSize, base_dir, chain, ctx, options, out_blob, out_size);
+    }
+    if (options && options->stats) {
+        options->stats->allocations = bb->allocs;
+        options->stats->bytes = bb->bytes;
+    }
+    if (!ctx) builder_free(bb);
+    return status;
+}
 
-err:
-    builder_free(&bb);
-    *out_size = 0;
-    return NULL;
+static unsigned char *parse(const void *mappedFile, const size_t fileSize, size_t *out_size) {
+    unsigned char *blob = NULL;
+    size_t size = 0;
+    parse_with_base(mappedFile, fileSize, NULL, NULL, NULL, NULL, &blob, &size);
+    if (out_size) *out_size = size;
+    return blob;
 }
 
 /* -------------------------
@@ -851,287 +2977,714 @@ MYLIB_API int unmapFile(void *addr, const size_t size) {
 }
 
 
-
 /* -------------------------
-   JNI helpers
-   ------------------------- */
+   Public C API
+   -------------------------
+   Plain C entry points used by the FFM (java.lang.foreign) binding and by native consumers.
+   Blobs returned here are owned by the caller and must be released with cjyaml_free_blob().
+*/
+
+MYLIB_API int cjyaml_context_parse_buffer(cjyaml_context *ctx, const void *data, const size_t size,
+                                          const cjyaml_parse_options *options, unsigned char **out_blob, size_t *out_size) {
+    char dir[CJ_PATH_MAX];
+    const bool includes = options && (options->flags & CJYAML_PARSE_INCLUDES) && path_current_dir(dir);
+    return parse_with_base(data, size, includes ? dir : NULL, NULL, ctx, options, out_blob, out_size);
+}
 
-/* Helper: create direct ByteBuffer or free pointer if creation fails */
-static jobject create_direct_bytebuffer_or_free(JNIEnv *env, void *buf, const jlong len) {
-    jobject bb = (*env)->NewDirectByteBuffer(env, buf, len);
-    if (bb == NULL) {
-        free(buf);
-        buf = NULL;
-        return NULL;
+MYLIB_API int cjyaml_context_parse_file(cjyaml_context *ctx, const char *path, const cjyaml_parse_options *options,
+                                        unsigned char **out_blob, size_t *out_size) {
+    if (out_blob) *out_blob = NULL;
+    if (out_size) *out_size = 0;
+    if (path == NULL || out_blob == NULL || out_size == NULL) return CJYAML_EINVAL;
+
+    size_t mapped_size = 0;
+    void *mapped = mapFile(path, &mapped_size);
+    if (mapped == NULL) return CJYAML_EIO;
+
+    char *canonical = path_join(NULL, path, strlen(path));
+    path_canonical(&canonical);
+    int status = CJYAML_ENOMEM;
+    if (canonical) {
+        char dir[CJ_PATH_MAX];
+        const IncludeChain root = { canonical, NULL };
+        status = parse_with_base(mapped, mapped_size, path_dirname(canonical, dir, sizeof(dir)) ? dir : NULL, &root,
+                                 ctx, options, out_blob, out_size);
     }
-    return bb;
+    cj_release(canonical);
+    unmapFile(mapped, mapped_size);
+    return status;
 }
 
-/* -------------------------
-   JNI wrappers (stubs)
-   ------------------------- */
+MYLIB_API int cjyaml_parse_buffer_opts(const void *data, const size_t size, const cjyaml_parse_options *options,
+                                       unsigned char **out_blob, size_t *out_size) {
+    return cjyaml_context_parse_buffer(NULL, data, size, options, out_blob, out_size);
+}
 
+MYLIB_API int cjyaml_parse_file_opts(const char *path, const cjyaml_parse_options *options, unsigned char **out_blob, size_t *out_size) {
+    return cjyaml_context_parse_file(NULL, path, options, out_blob, out_size);
+}
 
-JNIEXPORT jobject JNICALL
-Java_com_github_scalerock_cjyaml_CJYaml_00024NativeBlob_NativeLib_1parseToDirectByteBuffer(JNIEnv *env, const jclass cls, const jstring path) {
-    (void)cls;
-    if (path == NULL) return NULL;
+MYLIB_API cjyaml_context *cjyaml_context_new_with(const cjyaml_allocator *allocator) {
+    const cjyaml_allocator *a = allocator ? allocator : &cj_default_allocator;
+    if (!a->malloc_fn || !a->realloc_fn || !a->free_fn) return NULL;
+    cjyaml_context *ctx = a->malloc_fn(a->user, sizeof(cjyaml_context));
+    if (!ctx) return NULL;
+    builder_init(&ctx->bb);
+    ctx->bb.alloc = *a;
+    parser_scratch_init(&ctx->scratch);
+    return ctx;
+}
 
-    const char *cpath = (*env)->GetStringUTFChars(env, path, NULL);
-    if (cpath == NULL) return NULL; // Out of memory
+MYLIB_API cjyaml_context *cjyaml_context_new(void) {
+    return cjyaml_context_new_with(NULL);
+}
 
-    size_t mapped_size = 0;
-    void *mapped = mapFile(cpath, &mapped_size);
+MYLIB_API void cjyaml_context_trim(cjyaml_context *ctx) {
+    if (!ctx) return;
+    context_release(ctx);
+}
 
-    (*env)->ReleaseStringUTFChars(env, path, cpath);
-    cpath = NULL;
+MYLIB_API void cjyaml_context_free(cjyaml_context *ctx) {
+    if (!ctx) return;
+    const cjyaml_allocator a = ctx->bb.alloc;
+    cjyaml_context_trim(ctx);
+    cj_free_with(&a, ctx);
+}
 
-    if (mapped == NULL) {
-        return NULL;
+MYLIB_API void cjyaml_estimate_capacity(const void *data, const size_t size, cjyaml_capacity *out) {
+    if (!out) return;
+    if (!data) {
+        memset(out, 0, sizeof(*out));
+        return;
     }
+    estimate_capacity(data, size, out);
+}
 
-    /* Parse file contents into a new buffer */
-    size_t parsed_size = 0;
-    void *buf = parse(mapped, mapped_size, &parsed_size);
-    if (!buf) {
-        free(mapped);
-        mapped = NULL;
-        return NULL;
-    }
+MYLIB_API void cjyaml_builder_init(BlobBuilder *bb) {
+    if (bb) builder_init(bb);
+}
 
-    /* If parse() allocates a new buffer, we can unmap the original file now */
-    if (unmapFile(mapped, mapped_size) != 0) {
-        free(buf);
-        buf = NULL;
-        return NULL;
-    }
+MYLIB_API void cjyaml_builder_free(BlobBuilder *bb) {
+    if (bb) builder_free(bb);
+}
 
-    /* Safely convert size_t → jlong */
-    jlong jlen;
-    if (parsed_size <= (size_t)LLONG_MAX) {
-        jlen = (jlong)parsed_size;
-    } else {
-        free(buf);
-        return NULL;
-    }
+typedef struct {
+    BlobBuilder *bb;
+    const cjyaml_capacity *capacity;
+} ReserveRun;
 
+static void builder_reserve_run(void *arg) {
+    const ReserveRun *run = arg;
+    builder_reserve(run->bb, run->capacity);
+}
 
+MYLIB_API int cjyaml_builder_reserve(BlobBuilder *bb, const cjyaml_capacity *capacity) {
+    if (!bb || !capacity) return CJYAML_EINVAL;
+    ReserveRun run = { bb, capacity };
+    return build_guarded(bb, builder_reserve_run, &run) ? CJYAML_OK : bb->status;
+}
 
-    /* Wrap the native buffer as a DirectByteBuffer.
-       The helper should free buf on error automatically. */
-    return create_direct_bytebuffer_or_free(env, buf, jlen);
+MYLIB_API unsigned char *cjyaml_parse_buffer(const void *data, const size_t size, size_t *out_size) {
+    return parse(data, size, out_size);
 }
 
+MYLIB_API unsigned char *cjyaml_parse_file(const char *path, size_t *out_size) {
+    unsigned char *blob = NULL;
+    cjyaml_parse_file_opts(path, NULL, &blob, out_size);
+    return blob;
+}
 
-JNIEXPORT jbyteArray JNICALL
-Java_com_github_scalerock_cjyaml_CJYaml_00024NativeBlob_NativeLib_1parseToByteArray(JNIEnv *env, const jclass cls, jstring path) {
-    (void)cls;
-    if (path == NULL) return NULL;
+MYLIB_API void cjyaml_free_blob(void *blob) {
+    if (!blob) return;
+    unsigned char *base = (unsigned char *)blob - CJ_BLOB_PREFIX;
+    BlobPrefix prefix;
+    memcpy(&prefix, base, sizeof(prefix));
+    prefix.alloc.free_fn(prefix.alloc.user, base);
+}
 
-    const char *cpath = (*env)->GetStringUTFChars(env, path, NULL);
-    if (cpath == NULL) return NULL;
+/*
+ Parse `path` and store the blob in `blob_path` so readers can mmap it (no copy into their heap).
+ The blob is written to "<blob_path>.tmp" and renamed into place, so a concurrent reader either
+ sees the previous complete file or the new one - never a partially written blob.
+ cjyaml_compile_file returns 0 on success, -1 on failure; cjyaml_compile_file_opts returns a CJYAML_* status.
+*/
+MYLIB_API int cjyaml_compile_file(const char *path, const char *blob_path, size_t *out_size) {
+    return cjyaml_compile_file_opts(path, blob_path, NULL, out_size) == CJYAML_OK ? 0 : -1;
+}
 
-    size_t mapped_size = 0;
-    void *mapped = mapFile(cpath, &mapped_size);
-    if (mapped == NULL) {
-        (*env)->ReleaseStringUTFChars(env, path, cpath);
-        cpath = NULL;
-        return NULL;
-    }
+MYLIB_API int cjyaml_compile_file_opts(const char *path, const char *blob_path, const cjyaml_parse_options *options, size_t *out_size) {
+    if (out_size) *out_size = 0;
+    if (path == NULL || blob_path == NULL) return CJYAML_EINVAL;
 
-    /* Parse the file */
-    size_t parsed_size = 0;
-    void *buf = parse(mapped, mapped_size, &parsed_size);
-    if (!buf) {
-        (*env)->ReleaseStringUTFChars(env, path, cpath);
-        cpath = NULL;
-        return NULL;
+    size_t blob_size = 0;
+    unsigned char *blob = NULL;
+    const int status = cjyaml_parse_file_opts(path, options, &blob, &blob_size);
+    if (status != CJYAML_OK) return status;
+
+    const size_t path_len = strlen(blob_path);
+    char *tmp_path = malloc(path_len + sizeof(".tmp"));
+    if (tmp_path == NULL) {
+        cjyaml_free_blob(blob);
+        return CJYAML_ENOMEM;
+    }
+    memcpy(tmp_path, blob_path, path_len);
+    memcpy(tmp_path + path_len, ".tmp", sizeof(".tmp"));
+
+    FILE *f = fopen(tmp_path, "wb");
+    int rc = CJYAML_EIO;
+    if (f != NULL) {
+        const size_t written = fwrite(blob, 1, blob_size, f);
+        const int closed = fclose(f);
+        if (written == blob_size && closed == 0) {
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+            rc = rename(tmp_path, blob_path) == 0 ? CJYAML_OK : CJYAML_EIO;
+#else
+            rc = MoveFileExA(tmp_path, blob_path, MOVEFILE_REPLACE_EXISTING) ? CJYAML_OK : CJYAML_EIO;
+#endif
+        }
+        if (rc != CJYAML_OK) remove(tmp_path);
     }
 
-    /* Unmap the original file after parsing */
-    if (unmapFile(mapped, mapped_size) != 0) {
-        free(buf);
-        (*env)->ReleaseStringUTFChars(env, path, cpath);
+    free(tmp_path);
+    cjyaml_free_blob(blob);
+    if (rc == CJYAML_OK && out_size) *out_size = blob_size;
+    return rc;
+}
 
-        cpath = NULL;
-        buf = NULL;
-        return NULL;
-    }
 
-    /* Ensure size fits in jsize */
-    if (parsed_size > (size_t)INT_MAX) {
-        free(buf);
-        (*env)->ReleaseStringUTFChars(env, path, cpath);
 
-        buf = NULL;
-        cpath = NULL;
-        return NULL;
-    }
-    const jsize len = (jsize)parsed_size;
+/*
+ Read and sanity-check the header of an in-memory blob (host is little-endian, as for the node table).
+ Returns false if the buffer is too small or not a CJYAML blob.
+*/
+static bool read_blob_header(const void *blob, const size_t blob_size, HeaderBlob *out) {
+    if (blob == NULL || blob_size < sizeof(HeaderBlob)) return false;
+    memcpy(out, blob, sizeof(HeaderBlob));
+    return out->magic == CJYAML_MAGIC;
+}
 
-    /* Create a Java byte array for the parsed data */
-    const jbyteArray out = (*env)->NewByteArray(env, len);
-    if (out == NULL) {
-        free(buf);
-        buf = NULL;
-        (*env)->ReleaseStringUTFChars(env, path, cpath);
-        return NULL;
+// Locate the node entry and value-table slot of node_index; false if out of range or there is no value table.
+static bool blob_typed_node(const void *blob, const size_t blob_size, uint32_t node_index, NodeEntry *node, uint64_t *bits) {
+    HeaderBlob h;
+    if (!read_blob_header(blob, blob_size, &h)) return false;
+    if (h.value_count != h.node_count || h.value_table_offset == 0) return false;
+
+    // aliases are followed to the anchored node (targets always precede the alias, but bound the walk anyway)
+    for (int hops = 0; ; ++hops) {
+        if ((uint64_t)node_index >= h.node_count || hops > CJYAML_MAX_ALIAS_HOPS) return false;
+        const uint64_t node_off = h.node_table_offset + (uint64_t)node_index * sizeof(NodeEntry);
+        if (node_off + sizeof(NodeEntry) > blob_size) return false;
+        memcpy(node, (const unsigned char *)blob + node_off, sizeof(NodeEntry));
+        if (node->node_type != ALIAS) break;
+        node_index = (uint32_t)node->a;
     }
 
-    /* Copy from native buffer to Java byte[] */
-    (*env)->SetByteArrayRegion(env, out, 0, len, (const jbyte *)buf);
-    if ((*env)->ExceptionCheck(env)) {
-        free(buf);
-        buf = NULL;
-        (*env)->ExceptionClear(env);
-        (*env)->DeleteLocalRef(env, out);
-        (*env)->ReleaseStringUTFChars(env, path, cpath);
-        return NULL;
+    const uint64_t value_off = h.value_table_offset + (uint64_t)node_index * sizeof(uint64_t);
+    if (value_off + sizeof(uint64_t) > blob_size) return false;
+    memcpy(bits, (const unsigned char *)blob + value_off, sizeof(uint64_t));
+    return node->node_type == SCALAR;
+}
+
+MYLIB_API int cjyaml_get_i64(const void *blob, const size_t blob_size, const uint32_t node_index, int64_t *out) {
+    NodeEntry n;
+    uint64_t bits;
+    if (out == NULL || !blob_typed_node(blob, blob_size, node_index, &n, &bits)) return -1;
+    const uint8_t subtype = n.style_flags & SCALAR_TYPE_MASK;
+    if (subtype != SCALAR_INT && subtype != SCALAR_BOOL) return -1;
+    *out = (int64_t)bits;
+    return 0;
+}
+
+MYLIB_API int cjyaml_get_f64(const void *blob, const size_t blob_size, const uint32_t node_index, double *out) {
+    NodeEntry n;
+    uint64_t bits;
+    if (out == NULL || !blob_typed_node(blob, blob_size, node_index, &n, &bits)) return -1;
+    switch (n.style_flags & SCALAR_TYPE_MASK) {
+        case SCALAR_FLOAT:
+            memcpy(out, &bits, sizeof(*out));
+            return 0;
+        case SCALAR_INT:
+            *out = (double)(int64_t)bits;
+            return 0;
+        default:
+            return -1;
     }
+}
 
-    /* Free native memory and release Java string */
-    free(buf);
-    (*env)->ReleaseStringUTFChars(env, path, cpath);
+// Read tag entry tag_index (1-based) after checking it and the tag table against the blob size.
+static bool blob_tag_entry(const void *blob, const size_t blob_size, const HeaderBlob *h, const uint16_t tag_index, TagEntry *out) {
+    if (tag_index == 0 || tag_index > h->tag_count || h->tag_table_offset == 0) return false;
+    const uint64_t off = h->tag_table_offset + (uint64_t)(tag_index - 1) * sizeof(TagEntry);
+    if (off + sizeof(TagEntry) > blob_size) return false;
+    memcpy(out, (const unsigned char *)blob + off, sizeof(TagEntry));
+    return out->name_offset + out->name_len <= h->string_table_size
+        && h->string_table_offset + h->string_table_size <= blob_size;
+}
 
-    return out;
+MYLIB_API int cjyaml_find_tag(const void *blob, const size_t blob_size, const char *tag, const size_t tag_len, uint16_t *out_tag_index) {
+    HeaderBlob h;
+    if (tag == NULL || out_tag_index == NULL || !read_blob_header(blob, blob_size, &h)) return -1;
+    *out_tag_index = 0;
+    // the table holds one entry per distinct tag, so a linear pass is short
+    for (uint64_t i = 1; i <= h.tag_count && i <= CJYAML_MAX_TAGS; ++i) {
+        TagEntry te;
+        if (!blob_tag_entry(blob, blob_size, &h, (uint16_t)i, &te)) return -1;
+        if (te.name_len == tag_len && memcmp((const unsigned char *)blob + h.string_table_offset + te.name_offset, tag, tag_len) == 0) {
+            *out_tag_index = (uint16_t)i;
+            return 0;
+        }
+    }
+    return -1;
 }
 
-JNIEXPORT jbyteArray JNICALL
-Java_com_github_scalerock_cjyaml_CJYaml_00024NativeBlob_NativeLib_1parseToByteArrayFromOpenFile(JNIEnv *env, const jclass cls, const jstring fileContent) {
-    (void)cls;
-    if (fileContent == NULL) return NULL;
+MYLIB_API int cjyaml_tag_nodes(const void *blob, const size_t blob_size, const uint16_t tag_index, uint32_t *out, const size_t cap, size_t *out_count) {
+    HeaderBlob h;
+    TagEntry te;
+    if (out_count == NULL || (out == NULL && cap) || !read_blob_header(blob, blob_size, &h)
+        || !blob_tag_entry(blob, blob_size, &h, tag_index, &te)) return -1;
+    const uint64_t list = h.tag_table_offset + h.tag_count * sizeof(TagEntry) + te.first_node * sizeof(uint32_t);
+    if (list + (uint64_t)te.node_count * sizeof(uint32_t) > blob_size) return -1;
+    const unsigned char *p = (const unsigned char *)blob + list;
+    for (size_t i = 0; i < te.node_count && i < cap; ++i) {
+        memcpy(&out[i], p + i * sizeof(uint32_t), sizeof(uint32_t));
+    }
+    *out_count = te.node_count;
+    return 0;
+}
 
-    const char *cpath = (*env)->GetStringUTFChars(env, fileContent, NULL);
-    if (cpath == NULL) return NULL;
 
+/* -------------------------
+   Traversal
+   -------------------------
+   Iterative depth-first walk with an explicit frame stack. ALIAS and DOCUMENT nodes are followed, so an
+   anchored subtree is visited again at every alias - the expansion budget (events emitted) is what bounds
+   "billion laughs" graphs. A bitmap marks the collections on the current path; entering one of them again is
+   a cycle. Every offset is checked against the blob, so untrusted (e.g. mapped) blobs can be walked.
+*/
+
+typedef struct {
+    uint32_t node;
+    uint8_t node_type;  // SEQUENCE or MAPPING
+    uint64_t first;     // first index-table slot / first pair
+    uint64_t count;     // children: items, or 2 * pairs (key, value, key, value, ...)
+    uint64_t next;
+} WalkFrame;
+
+typedef struct {
+    const unsigned char *blob;
+    size_t blob_size;
+    HeaderBlob h;
+    uint8_t *on_path;   // bit per node: collection is an open frame
+    WalkFrame *stack;
+    size_t depth;
+    size_t cap;
+    uint32_t max_depth;
+    uint64_t budget;
+    cjyaml_walk_fn fn;
+    void *user;
+} Walker;
+
+static int walker_init(Walker *w, const void *blob, const size_t blob_size, const cjyaml_walk_limits *limits,
+                       const cjyaml_walk_fn fn, void *user) {
+    memset(w, 0, sizeof(*w));
+    if (fn == NULL || !read_blob_header(blob, blob_size, &w->h)) return CJYAML_EINVAL;
+    const HeaderBlob *h = &w->h;
+    if (h->node_count > UINT32_MAX
+        || !table_fits(h->node_table_offset, h->node_count, sizeof(NodeEntry), blob_size)
+        || !table_fits(h->pair_table_offset, h->pair_count, sizeof(PairEntry), blob_size)
+        || !table_fits(h->index_table_offset, h->index_count, sizeof(uint32_t), blob_size)) return CJYAML_EINVAL;
+
+    w->blob = blob;
+    w->blob_size = blob_size;
+    w->max_depth = (limits && limits->max_depth) ? limits->max_depth : CJYAML_WALK_DEFAULT_DEPTH;
+    w->budget = (limits && limits->max_nodes) ? limits->max_nodes : h->node_count + CJYAML_WALK_DEFAULT_EXPANSION;
+    w->fn = fn;
+    w->user = user;
+    w->on_path = calloc((size_t)(h->node_count / 8 + 1), 1);
+    if (!w->on_path) {
+        return CJYAML_ENOMEM;
+    }
+    return CJYAML_OK;
+}
+
+static void walker_free(Walker *w) {
+    free(w->on_path);
+    free(w->stack);
+    w->on_path = NULL;
+    w->stack = NULL;
+}
 
-    /* Parse the file */
-    size_t parsed_size = 0;
-    const size_t fileSize = (*env)->GetStringUTFLength(env, fileContent);
-    void *buf = parse(fileContent, fileSize, &parsed_size);
-    (*env)->ReleaseStringUTFChars(env, fileContent, cpath);
-    cpath = NULL;
+static bool walker_node(const Walker *w, const uint64_t node_index, NodeEntry *out) {
+    if (node_index >= w->h.node_count) return false;
+    memcpy(out, w->blob + w->h.node_table_offset + node_index * sizeof(NodeEntry), sizeof(NodeEntry));
+    return true;
+}
 
-    if (buf == NULL) {
-        return NULL;
+// emit one node (aliases resolved) and open a frame for a collection
+static int walker_visit(Walker *w, uint32_t node) {
+    NodeEntry n;
+    for (int hops = 0; ; ++hops) {
+        if (hops > CJYAML_MAX_ALIAS_HOPS) return CJYAML_ECYCLE;
+        if (!walker_node(w, node, &n)) return CJYAML_EINVAL;
+        if (n.node_type != ALIAS && n.node_type != DOCUMENT) break;
+        if (n.a >= w->h.node_count) return CJYAML_EINVAL;
+        node = (uint32_t)n.a;
     }
+    if (w->budget == 0) return CJYAML_EBUDGET;
+    --w->budget;
+
+    const uint32_t depth = (uint32_t)w->depth;
+    switch (n.node_type) {
+        case SCALAR:
+            return w->fn(w->user, CJYAML_WALK_SCALAR, node, depth);
+        case SEQUENCE:
+        case MAPPING: {
+            const uint64_t limit = n.node_type == SEQUENCE ? w->h.index_count : w->h.pair_count;
+            if (n.b > limit || n.a > limit - n.b) return CJYAML_EINVAL;
+            if (w->depth >= w->max_depth) return CJYAML_EDEPTH;
+            if (w->on_path[node >> 3] & (1u << (node & 7))) return CJYAML_ECYCLE;
+
+            const int rc = w->fn(w->user, n.node_type == SEQUENCE ? CJYAML_WALK_SEQUENCE : CJYAML_WALK_MAPPING, node, depth);
+            if (rc != CJYAML_OK) return rc;
+            if (!grow_array_if_needed((void**)&w->stack, w->depth, &w->cap, sizeof(WalkFrame))) return CJYAML_ENOMEM;
+            WalkFrame *f = &w->stack[w->depth++];
+            f->node = node;
+            f->node_type = n.node_type;
+            f->first = n.a;
+            f->count = n.node_type == SEQUENCE ? n.b : n.b * 2;
+            f->next = 0;
+            w->on_path[node >> 3] |= (uint8_t)(1u << (node & 7));
+            return CJYAML_OK;
+        }
+        default:
+            return CJYAML_EINVAL;
+    }
+}
 
-    /* Ensure size fits in jsize */
-    if (parsed_size > (size_t)INT_MAX) {
-        free(buf);
-        buf = NULL;
-        return NULL;
+static int walker_run(Walker *w, const uint32_t root) {
+    int rc = walker_visit(w, root);
+    while (rc == CJYAML_OK && w->depth) {
+        WalkFrame *f = &w->stack[w->depth - 1];
+        if (f->next == f->count) {
+            w->on_path[f->node >> 3] &= (uint8_t)~(1u << (f->node & 7));
+            --w->depth;
+            rc = w->fn(w->user, CJYAML_WALK_END, f->node, (uint32_t)w->depth);
+            continue;
+        }
+        uint32_t child;
+        if (f->node_type == SEQUENCE) {
+            memcpy(&child, w->blob + w->h.index_table_offset + (f->first + f->next) * sizeof(uint32_t), sizeof(uint32_t));
+        } else {
+            const unsigned char *pe = w->blob + w->h.pair_table_offset + (f->first + f->next / 2) * sizeof(PairEntry);
+            memcpy(&child, pe + (f->next & 1) * sizeof(uint32_t), sizeof(uint32_t));
+        }
+        ++f->next;
+        rc = walker_visit(w, child); // may grow (move) the stack; f is not used afterwards
     }
-    const jsize len = (jsize)parsed_size;
+    return rc;
+}
 
-    /* Create a Java byte array for the parsed data */
-    const jbyteArray out = (*env)->NewByteArray(env, len);
-    if (out == NULL) {
-        free(buf);
-        buf = NULL;
-        return NULL;
+// the DOCUMENT node is the last one the parser emits; fall back to node 0 like the Java readers
+static uint32_t walker_document(const Walker *w) {
+    NodeEntry n;
+    for (uint64_t i = w->h.node_count; i-- > 0; ) {
+        if (walker_node(w, i, &n) && n.node_type == DOCUMENT) return (uint32_t)i;
     }
+    return 0;
+}
 
-    /* Copy from native buffer to Java byte[] */
-    (*env)->SetByteArrayRegion(env, out, 0, len, (const jbyte *)buf);
-    if ((*env)->ExceptionCheck(env)) {
-        (*env)->ExceptionClear(env);
-        free(buf);
-        buf = NULL;
-        (*env)->DeleteLocalRef(env, out);
-        (*env)->ReleaseStringUTFChars(env, fileContent, cpath);
-        return NULL;
+MYLIB_API int cjyaml_walk(const void *blob, const size_t blob_size, const uint32_t root, const cjyaml_walk_limits *limits,
+                          const cjyaml_walk_fn fn, void *user) {
+    Walker w;
+    int rc = walker_init(&w, blob, blob_size, limits, fn, user);
+    if (rc == CJYAML_OK) rc = walker_run(&w, root == CJYAML_WALK_DOCUMENT ? walker_document(&w) : root);
+    walker_free(&w);
+    return rc;
+}
+
+typedef struct {
+    uint32_t *out;
+    size_t cap;    // in events
+    size_t count;
+} EventSink;
+
+static int event_sink_push(void *user, const int event, const uint32_t node_index, const uint32_t depth) {
+    (void)depth;
+    EventSink *sink = user;
+    if (sink->count < sink->cap) {
+        sink->out[sink->count * 2] = (uint32_t)event;
+        sink->out[sink->count * 2 + 1] = node_index;
     }
+    ++sink->count;
+    return CJYAML_OK;
+}
 
-    /* Free native memory and release Java string */
-    free(buf);
-    buf = NULL;
+MYLIB_API int cjyaml_walk_events(const void *blob, const size_t blob_size, const uint32_t root, const cjyaml_walk_limits *limits,
+                                 uint32_t *out, const size_t cap, size_t *out_count) {
+    if (out_count == NULL || (out == NULL && cap)) return CJYAML_EINVAL;
+    EventSink sink = { out, cap, 0 };
+    const int rc = cjyaml_walk(blob, blob_size, root, limits, event_sink_push, &sink);
+    *out_count = sink.count;
+    if (rc != CJYAML_OK) return rc;
+    return sink.count > cap ? CJYAML_ERANGE : CJYAML_OK;
+}
 
-    return out;
+/* -------------------------
+   Integrity
+   -------------------------
+   cjyaml_verify compares the checksum table with freshly computed digests; cjyaml_validate checks every
+   reference once so that a blob from disk or a cache cannot send a reader outside the buffer.
+*/
+
+MYLIB_API int cjyaml_verify(const void *blob, const size_t blob_size, uint32_t *out_bad_sections) {
+    HeaderBlob h;
+    uint64_t table;
+    if (out_bad_sections) *out_bad_sections = 0;
+    if (!read_blob_header(blob, blob_size, &h) || !blob_checksum_offset(&h, blob_size, &table)) return CJYAML_EINVAL;
+
+    ChecksumEntry digest[CJYAML_SECTION_COUNT];
+    if (!blob_section_digests(blob, blob_size, &h, digest)) return CJYAML_EINVAL;
+    uint32_t bad = 0;
+    for (int i = 0; i < CJYAML_SECTION_COUNT; ++i) {
+        ChecksumEntry stored;
+        memcpy(&stored, (const unsigned char *)blob + table + (uint64_t)i * sizeof(ChecksumEntry), sizeof(stored));
+        if (stored.low64 != digest[i].low64 || stored.high64 != digest[i].high64) bad |= 1u << i;
+    }
+    if (out_bad_sections) *out_bad_sections = bad;
+    return bad ? CJYAML_ECHECKSUM : CJYAML_OK;
 }
 
+// alias chains (through DOCUMENT links too) must stay in the node table and end within CJYAML_MAX_ALIAS_HOPS
+static bool alias_chain_ends(const unsigned char *blob, const HeaderBlob *h, uint64_t node_index) {
+    for (int hops = 0; node_index < h->node_count && hops <= CJYAML_MAX_ALIAS_HOPS; ++hops) {
+        NodeEntry n;
+        memcpy(&n, blob + h->node_table_offset + node_index * sizeof(NodeEntry), sizeof(n));
+        if (n.node_type != ALIAS && n.node_type != DOCUMENT) return true;
+        node_index = n.a;
+    }
+    return false;
+}
 
-/*
- * freeBlob
- *
- * JNI wrapper that releases native memory referenced by a DirectByteBuffer.
- *
- * This must be called explicitly from Java when the buffer is no longer needed,
- * unless a Cleaner or finalizer is used on the Java side to automatically handle cleanup.
- *
- * The function validates the buffer by reading the first HEADER_BLOB_SIZE bytes
- * and checking whether the magic number matches the expected CJYAML blob header.
- * If the magic number does not match, the buffer is not freed, and a Java
- * IllegalArgumentException is thrown instead.
- *
- * This prevents accidental free() calls on invalid or non-owned memory.
- */
+// k-th child of node n (items; keys and values; alias and DOCUMENT targets), false past the last one
+static bool node_child(const unsigned char *blob, const HeaderBlob *h, const NodeEntry *n, const uint64_t k,
+                       uint32_t *child) {
+    switch (n->node_type) {
+        case SEQUENCE:
+            if (k >= n->b) return false;
+            memcpy(child, blob + h->index_table_offset + (n->a + k) * sizeof(uint32_t), sizeof(*child));
+            return true;
+        case MAPPING: {
+            if (k >= 2 * n->b) return false;
+            PairEntry pe;
+            memcpy(&pe, blob + h->pair_table_offset + (n->a + k / 2) * sizeof(PairEntry), sizeof(pe));
+            *child = k % 2 ? pe.value_node_index : pe.key_node_index;
+            return true;
+        }
+        case ALIAS:
+        case DOCUMENT:
+            if (k > 0) return false;
+            *child = (uint32_t)n->a;
+            return true;
+        default:
+            return false;
+    }
+}
 
 /*
- * Reads a 32-bit unsigned integer from a byte buffer in little-endian order.
- * This helper is used to interpret the 'magic' field in the CJYAML blob header.
- *
- * Parameters:
- *   p - pointer to the first byte of the 4-byte field
- *
- * Returns:
- *   The decoded 32-bit unsigned integer in host byte order.
- */
-static uint32_t read_u32_le_from_bytes(const void *p) {
-    const uint8_t *b = (const uint8_t *)p;
-    return (uint32_t)b[0]
-         | ((uint32_t)b[1] << 8)
-         | ((uint32_t)b[2] << 16)
-         | ((uint32_t)b[3] << 24);
+ No node may reach itself: the parser only links finished nodes, and readers that recurse through the cursor or
+ cjyaml::Node rely on it. Depth-first search over the already range-checked references, iterative so a deep blob
+ cannot overflow the stack; CJYAML_ECYCLE on a back edge, CJYAML_ENOMEM if the scratch cannot be allocated.
+*/
+static int validate_acyclic(const unsigned char *blob, const HeaderBlob *h) {
+    typedef struct {
+        uint32_t node;
+        uint64_t next; // next child to visit
+    } Frame;
+    if (h->node_count == 0) return CJYAML_OK;
+    if (h->node_count > SIZE_MAX / sizeof(Frame)) return CJYAML_ENOMEM;
+    uint8_t *state = calloc((size_t)h->node_count, 1); // 0 unvisited, 1 on the path, 2 done
+    Frame *stack = malloc((size_t)h->node_count * sizeof(Frame));
+    int rc = state && stack ? CJYAML_OK : CJYAML_ENOMEM;
+    for (uint64_t root = 0; rc == CJYAML_OK && root < h->node_count; ++root) {
+        if (state[root]) continue;
+        size_t depth = 0;
+        stack[depth++] = (Frame){ (uint32_t)root, 0 };
+        state[root] = 1;
+        while (depth && rc == CJYAML_OK) {
+            Frame *f = &stack[depth - 1];
+            NodeEntry n;
+            memcpy(&n, blob + h->node_table_offset + (uint64_t)f->node * sizeof(NodeEntry), sizeof(n));
+            uint32_t child;
+            if (!node_child(blob, h, &n, f->next++, &child)) {
+                state[f->node] = 2;
+                --depth;
+            } else if (state[child] == 1) {
+                rc = CJYAML_ECYCLE;
+            } else if (state[child] == 0) {
+                state[child] = 1;
+                stack[depth++] = (Frame){ child, 0 };
+            }
+        }
+    }
+    free(stack);
+    free(state);
+    return rc;
 }
 
-/*
- * JNI function: NativeLib_freeBlob
- *
- * Safely frees a native buffer previously allocated by the CJYAML builder and
- * wrapped into a DirectByteBuffer on the Java side.
- *
- * The function performs the following steps:
- *   1. Obtains the native memory address from the DirectByteBuffer.
- *   2. Reads the first HEADER_BLOB_SIZE bytes of the buffer.
- *   3. Extracts the 'magic' field from the header and validates it against CJYAML_MAGIC.
- *   4. If validation succeeds, the memory is freed using free().
- *   5. If validation fails, a Java IllegalArgumentException is thrown and the
- *      buffer is left untouched.
- *
- * Notes:
- *   - This function assumes that the buffer points to the beginning of the blob.
- *     Passing a sliced or offset buffer will fail validation (by design).
- *   - The function is no-op if buffer is NULL or if the native address is NULL.
- */
-JNIEXPORT void JNICALL
-Java_com_github_scalerock_cjyaml_CJYaml_00024NativeBlob_NativeLib_1freeBlob(JNIEnv *env, const jclass cls, jobject buffer) {
-    (void)cls;
-
-    if (buffer == NULL) return;
-
-    void *addr = (*env)->GetDirectBufferAddress(env, buffer);
-    if (addr == NULL) return;
-
-    /* Read the first HEADER_BLOB_SIZE bytes to validate the blob header */
-    uint8_t hdr_bytes[HEADER_BLOB_SIZE];
-    memcpy(hdr_bytes, addr, HEADER_BLOB_SIZE);
-
-    /* Extract and validate the magic number (little-endian) */
-    const uint32_t magic = read_u32_le_from_bytes(hdr_bytes);
-
-    if (magic != CJYAML_MAGIC) {
-        const jclass exClass = (*env)->FindClass(env, "java/lang/IllegalArgumentException");
-        if (exClass) {
-            (*env)->ThrowNew(env, exClass, "Buffer magic mismatch: not a CJYAML blob (or not base pointer).");
+MYLIB_API int cjyaml_validate(const void *blob, const size_t blob_size) {
+    HeaderBlob h;
+    uint64_t off[CJYAML_SECTION_COUNT], len[CJYAML_SECTION_COUNT], table;
+    if (!read_blob_header(blob, blob_size, &h)) return CJYAML_EINVAL;
+    for (int i = 0; i < CJYAML_SECTION_COUNT; ++i) {
+        if (!blob_section_span(&h, blob_size, i, &off[i], &len[i])) return CJYAML_EINVAL;
+    }
+    if ((h.flags & CJYAML_FLAG_CHECKSUM) && !blob_checksum_offset(&h, blob_size, &table)) return CJYAML_EINVAL;
+    // node and pair references are uint32; the value table is dense; tag indexes are 16-bit
+    if (h.node_count > UINT32_MAX || h.pair_count > UINT32_MAX
+        || (h.value_count && h.value_count != h.node_count)
+        || h.tag_count > CJYAML_MAX_TAGS || h.tag_count * sizeof(TagEntry) > len[CJYAML_SECTION_TAGS]) return CJYAML_EINVAL;
+
+    const unsigned char *b = blob;
+    for (uint64_t i = 0; i < h.node_count; ++i) {
+        NodeEntry n;
+        memcpy(&n, b + h.node_table_offset + i * sizeof(NodeEntry), sizeof(n));
+        if (n.tag_index > h.tag_count) return CJYAML_EINVAL;
+        bool ok;
+        switch (n.node_type) {
+            case SCALAR:   ok = n.a <= h.string_table_size && n.b <= h.string_table_size - n.a; break;
+            case SEQUENCE: ok = n.a <= h.index_count && n.b <= h.index_count - n.a; break;
+            case MAPPING:  ok = n.a <= h.pair_count && n.b <= h.pair_count - n.a; break;
+            case ALIAS:    ok = alias_chain_ends(b, &h, n.a); break;
+            case DOCUMENT: ok = n.a < h.node_count; break;
+            default:       ok = false; break;
         }
-        return;
+        if (!ok) return CJYAML_EINVAL;
+    }
+    for (uint64_t i = 0; i < h.pair_count; ++i) {
+        PairEntry pe;
+        memcpy(&pe, b + h.pair_table_offset + i * sizeof(PairEntry), sizeof(pe));
+        if (pe.key_node_index >= h.node_count || pe.value_node_index >= h.node_count) return CJYAML_EINVAL;
     }
+    for (uint64_t i = 0; i < h.index_count; ++i) {
+        uint32_t idx;
+        memcpy(&idx, b + h.index_table_offset + i * sizeof(uint32_t), sizeof(idx));
+        if (idx >= h.node_count) return CJYAML_EINVAL;
+    }
+    for (uint64_t i = 0; i < h.hash_index_size; ++i) {
+        HashEntry he;
+        memcpy(&he, b + h.hash_index_offset + i * sizeof(HashEntry), sizeof(he));
+        if (he.pair_index >= h.pair_count) return CJYAML_EINVAL;
+    }
+    if (h.tag_count) {
+        const uint64_t list = h.tag_table_offset + h.tag_count * sizeof(TagEntry);
+        const uint64_t list_len = (len[CJYAML_SECTION_TAGS] - h.tag_count * sizeof(TagEntry)) / sizeof(uint32_t);
+        for (uint64_t i = 0; i < h.tag_count; ++i) {
+            TagEntry te;
+            memcpy(&te, b + h.tag_table_offset + i * sizeof(TagEntry), sizeof(te));
+            if (te.name_offset > h.string_table_size || te.name_len > h.string_table_size - te.name_offset
+                || te.first_node > list_len || te.node_count > list_len - te.first_node) return CJYAML_EINVAL;
+        }
+        for (uint64_t i = 0; i < list_len; ++i) {
+            uint32_t idx;
+            memcpy(&idx, b + list + i * sizeof(uint32_t), sizeof(idx));
+            if (idx >= h.node_count) return CJYAML_EINVAL;
+        }
+    }
+    return validate_acyclic(b, &h);
+}
 
-    /* Magic number matches – safe to free the memory */
-    free(addr);
-    addr = NULL;
+MYLIB_API int cjyaml_blob_open(cjyaml_blob *b, const void *blob, const size_t blob_size, const uint32_t options) {
+    if (b == NULL) return CJYAML_EINVAL;
+    memset(b, 0, sizeof(*b));
+    HeaderBlob h;
+    if (!read_blob_header(blob, blob_size, &h) || h.node_count == 0) return CJYAML_EINVAL;
+    if (!(options & CJYAML_OPEN_TRUSTED) && cjyaml_validate(blob, blob_size) != CJYAML_OK) return CJYAML_EINVAL;
+
+    const unsigned char *base = blob;
+    b->base = base;
+    b->size = blob_size;
+    b->nodes = (const NodeEntry *)(base + h.node_table_offset);
+    b->pairs = (const PairEntry *)(base + h.pair_table_offset);
+    b->index = base + h.index_table_offset;
+    b->values = h.value_count ? base + h.value_table_offset : NULL;
+    b->strings = (const char *)(base + h.string_table_offset);
+    b->hash = h.hash_index_size ? base + h.hash_index_offset : NULL;
+    b->node_count = h.node_count;
+    b->pair_count = h.pair_count;
+    b->index_count = h.index_count;
+    b->string_size = h.string_table_size;
+    b->hash_count = h.hash_index_size;
+    // the DOCUMENT node is appended last by the builder; search backwards
+    for (uint64_t i = h.node_count; i-- > 0; ) {
+        if (b->nodes[i].node_type == DOCUMENT) {
+            b->root = (uint32_t)b->nodes[i].a;
+            break;
+        }
+    }
+    b->flags = CJYAML_BLOB_VALIDATED;
+    return CJYAML_OK;
 }
 
+MYLIB_API uint64_t cjyaml_blob_hash(const cjyaml_blob *b, const uint32_t node_index) {
+    const NodeEntry *n = &b->nodes[node_index];
+    if (n->node_type != SCALAR) return 0;
+    return XXH64(b->strings + n->a, (size_t)n->b, 0);
+}
 
+/*
+ Child loops with software prefetch in three stages: the pair/index entry CJ_PREFETCH_AHEAD children ahead,
+ the node entries it references half that far ahead (their entry is cached by then), and the text of the key
+ a couple of children ahead (its node is cached by then).
+*/
+#if defined(__GNUC__) || defined(__clang__)
+    #define CJ_PREFETCH(p) __builtin_prefetch((p), 0, 1)
+#elif defined(CJ_HAVE_SSE2)
+    #define CJ_PREFETCH(p) _mm_prefetch((const char *)(p), _MM_HINT_T1)
+#else
+    #define CJ_PREFETCH(p) ((void)(p))
+#endif
+#define CJ_PREFETCH_AHEAD 8
+
+MYLIB_API int cjyaml_for_each_pair(const cjyaml_cursor *map, const cjyaml_cursor_fn fn, void *user) {
+    if (map == NULL || fn == NULL || !(map->blob->flags & CJYAML_BLOB_VALIDATED)) return CJYAML_EINVAL;
+    const cjyaml_blob *b = map->blob;
+    const NodeEntry *n = &b->nodes[map->node];
+    if (n->node_type != MAPPING) return CJYAML_EINVAL;
+
+    const PairEntry *pairs = b->pairs + n->a;
+    const uint64_t count = n->b;
+    cjyaml_cursor child;
+    child.blob = b;
+    for (uint64_t k = 0; k < count; ++k) {
+        if (k + CJ_PREFETCH_AHEAD < count) CJ_PREFETCH(&pairs[k + CJ_PREFETCH_AHEAD]);
+        if (k + CJ_PREFETCH_AHEAD / 2 < count) {
+            const PairEntry *p = &pairs[k + CJ_PREFETCH_AHEAD / 2];
+            CJ_PREFETCH(&b->nodes[p->key_node_index]);
+            CJ_PREFETCH(&b->nodes[p->value_node_index]);
+        }
+        if (k + 2 < count) CJ_PREFETCH(b->strings + b->nodes[pairs[k + 2].key_node_index].a);
+        cjyaml_cursor_place(&child, n, k);
+        const int rc = fn(user, &child);
+        if (rc) return rc;
+    }
+    return CJYAML_OK;
+}
 
+MYLIB_API int cjyaml_for_each_item(const cjyaml_cursor *seq, const cjyaml_cursor_fn fn, void *user) {
+    if (seq == NULL || fn == NULL || !(seq->blob->flags & CJYAML_BLOB_VALIDATED)) return CJYAML_EINVAL;
+    const cjyaml_blob *b = seq->blob;
+    const NodeEntry *n = &b->nodes[seq->node];
+    if (n->node_type != SEQUENCE) return CJYAML_EINVAL;
+
+    const uint64_t count = n->b;
+    cjyaml_cursor child;
+    child.blob = b;
+    for (uint64_t k = 0; k < count; ++k) {
+        if (k + CJ_PREFETCH_AHEAD < count) CJ_PREFETCH(b->index + (size_t)(n->a + k + CJ_PREFETCH_AHEAD) * sizeof(uint32_t));
+        if (k + CJ_PREFETCH_AHEAD / 2 < count) CJ_PREFETCH(&b->nodes[cjyaml_blob_item(b, n, k + CJ_PREFETCH_AHEAD / 2)]);
+        cjyaml_cursor_place(&child, n, k);
+        const int rc = fn(user, &child);
+        if (rc) return rc;
+    }
+    return CJYAML_OK;
+}
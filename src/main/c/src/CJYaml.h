@@ -7,7 +7,7 @@ extern "C" {
 
 #include <stdint.h>
 #include <stddef.h>
-#include <jni.h>
+#include <string.h>
 
 /* Export macro */
 #ifdef _WIN32
@@ -22,6 +22,11 @@ extern "C" {
 
 #define POSIX_C_SOURCE 200809L
 
+/* the layout checks below are C11; C++ (CJYaml.hpp) spells them static_assert */
+#if defined(__cplusplus) && !defined(_Static_assert)
+  #define _Static_assert static_assert
+#endif
+
 /*
 Idea:
     name: John Doe
@@ -57,7 +62,10 @@ Idea:
  [ PAIR_TABLE ]   // pair_count * sizeof(PairEntry)
  [ INDEX_TABLE ]  // index_count * sizeof(uint32_t)
  [ HASH_INDEX ]   // hash_index_count * sizeof(HashEntry)  (optional)
+ [ VALUE_TABLE ]  // value_count * sizeof(uint64_t)  (optional; value_count == node_count when present)
+ [ TAG_TABLE ]    // tag_count * sizeof(TagEntry), followed by the tag node list (uint32 node indexes) (optional)
  [ STRING_TABLE ] // concatenated UTF-8 strings (deduplicated)
+ [ CHECKSUMS ]    // CJYAML_SECTION_COUNT * sizeof(ChecksumEntry)  (optional, header flag CJYAML_FLAG_CHECKSUM)
 */
 #pragma pack(push, 1)
     typedef struct HeaderBlob {
@@ -79,13 +87,47 @@ Idea:
 
         uint64_t string_table_offset;
         uint64_t string_table_size;
+
+        uint64_t value_table_offset; // 0 when the blob has no typed scalars
+        uint64_t value_count;
+
+        uint64_t tag_table_offset;   // 0 when no node is tagged
+        uint64_t tag_count;
     } HeaderBlob;
 #pragma pack(pop)
-_Static_assert(sizeof(HeaderBlob) == 90, "HeaderBlob must be 90 bytes");
+_Static_assert(sizeof(HeaderBlob) == 122, "HeaderBlob must be 122 bytes");
 
 #define CJYAML_MAGIC 0x59414D4Cu  // 'Y','A','M','L'
+#define CJYAML_VERSION 3          // 2: value table, 3: tag table
 #define HEADER_BLOB_SIZE (sizeof(HeaderBlob))
 
+/*
+ Header flags.
+ CJYAML_FLAG_CHECKSUM: the string table is followed by the checksum table, one XXH3-128 digest per section
+ (indexed by CJYAML_SECTION_*). The header digest covers the HEADER_BLOB_SIZE header bytes, the tag digest the
+ tag entries plus the tag node list, and an absent section has the digest of zero bytes. Readers that do not
+ know the flag never look past the string table, so the version is unchanged.
+*/
+#define CJYAML_FLAG_CHECKSUM 0x1u
+
+#define CJYAML_SECTION_HEADER  0
+#define CJYAML_SECTION_NODES   1
+#define CJYAML_SECTION_PAIRS   2
+#define CJYAML_SECTION_INDEX   3
+#define CJYAML_SECTION_HASH    4
+#define CJYAML_SECTION_VALUES  5
+#define CJYAML_SECTION_TAGS    6
+#define CJYAML_SECTION_STRINGS 7
+#define CJYAML_SECTION_COUNT   8
+
+#pragma pack(push, 1)
+typedef struct ChecksumEntry {
+    uint64_t low64;  // XXH3-128 digest, little-endian halves
+    uint64_t high64;
+} ChecksumEntry;
+#pragma pack(pop)
+_Static_assert(sizeof(ChecksumEntry) == 16, "ChecksumEntry size mismatch");
+
 #define SCALAR 0
 #define SEQUENCE 1
 #define MAPPING 2
@@ -98,6 +140,26 @@ _Static_assert(sizeof(HeaderBlob) == 90, "HeaderBlob must be 90 bytes");
 #define SCALAR_INT    0x1
 #define SCALAR_FLOAT  0x2
 #define SCALAR_BOOL   0x3
+#define SCALAR_TYPE_MASK 0x3
+#define SCALAR_BLOCK  0x4  // bit 2: block scalar text (literal '|' or folded '>'); subtype is SCALAR_STRING
+#define SCALAR_NULL   0x8  // bit 3: core-schema null (null, Null, NULL, ~ or empty); subtype is SCALAR_STRING
+
+/*
+ MAPPING flag: the first pair of the range is a merge key ('<<'). Its value is the parent mapping - an ALIAS of
+ a MAPPING, an inline MAPPING, or a SEQUENCE of those (earlier entries win) - and the remaining pairs are the
+ overrides. Lookups search the overrides first and then fall through to the parents, so a merged mapping stores
+ only its own pairs instead of a copy of the base.
+*/
+#define MAPPING_MERGE 0x1
+
+/*
+ Value table: one uint64 per node, indexed by node index (same index as the node table).
+ For typed scalars it holds the value decoded once at build time, so readers skip strtol/strtod:
+    SCALAR_INT   -> int64_t (two's complement)
+    SCALAR_FLOAT -> IEEE-754 double bits
+    SCALAR_BOOL  -> 0 or 1
+ Entries of all other nodes are 0.
+*/
 
 
 #pragma pack(push,1)
@@ -127,11 +189,13 @@ typedef struct {
     /*
     style_flags bits:
         Bit 0..1: SCALAR subtype (00=string, 01=int, 10=float, 11=bool)
-        Bit 2: folded literal indicator (text format)
-        Bits 3..7: reserved for future use
+        Bit 2: block scalar indicator, literal '|' or folded '>' (SCALAR_BLOCK)
+        Bit 3: null (SCALAR_NULL)
+        Bits 4..7: reserved for future use
+    For MAPPING nodes bit 0 is MAPPING_MERGE (first pair is a '<<' merge link).
 
      */
-    uint16_t tag_index; // if non-zero this is an index into the string table containing the explicit YAML tag (e.g. "!!str", "!mytag"). 0 means "no tag".
+    uint16_t tag_index; // 1-based index into the tag table (explicit YAML tag such as "!!str" or "!mytag"); 0 means "no tag".
 
     uint64_t a;
     uint64_t b;
@@ -156,6 +220,24 @@ typedef struct {
 #pragma pack(pop)
 _Static_assert(sizeof(PairEntry) == 8, "PairEntry size mismatch");
 
+/*
+ Tag table: one entry per distinct tag, tag_index N refers to entry N-1. Tags are stored as written ("!secret",
+ "!!str", "!<tag:example.com:x>") in the string table. The entries are followed by the tag node list: the
+ indexes of all tagged nodes grouped by tag (ascending within a tag), so all nodes with one tag are a single
+ contiguous run [first_node, first_node + node_count).
+*/
+#pragma pack(push,1)
+typedef struct TagEntry {
+    uint64_t name_offset; // offset of the tag text in the string table
+    uint32_t name_len;
+    uint32_t node_count;  // number of nodes carrying this tag
+    uint64_t first_node;  // position of the first of them in the tag node list
+} TagEntry;
+#pragma pack(pop)
+_Static_assert(sizeof(TagEntry) == 24, "TagEntry size mismatch");
+
+#define CJYAML_MAX_TAGS 65535 // tag_index is 16-bit
+
 #pragma pack(push,1)
 typedef struct HashEntry {
     uint64_t key_hash;
@@ -183,12 +265,25 @@ typedef struct {
     size_t count;
     size_t cap;
 } IndexVec;
+/*
+ String arena: the string table under construction. Unique strings are appended back to back, so a scalar's
+ offset into `data` is already its final string-table offset. Deduplication goes through an open-addressing
+ hash table over (hash, offset, len) slots; a slot with hash 0 is empty (real hashes are forced non-zero).
+*/
 typedef struct {
-   char **data;    // pointers to allocated null-terminated strings
-   size_t *lens;   // lengths for each string
-   size_t count;
-   size_t cap;
-} StringVec;
+    uint64_t hash;
+    uint64_t offset;
+    uint64_t len;
+} StringSlot;
+
+typedef struct {
+    char *data;         // concatenated unique strings (becomes the string table verbatim)
+    size_t size;
+    size_t cap;
+    StringSlot *slots;  // power-of-two open-addressing table, load factor <= 1/2
+    size_t slot_count;
+    size_t slot_cap;
+} StringArena;
 
 typedef struct {
     HashEntry *data;
@@ -196,16 +291,405 @@ typedef struct {
     size_t cap;
 } HashVec;
 
+typedef struct {
+    uint32_t node_index;
+    uint64_t bits;
+} ScalarValue;
+
+typedef struct {
+    ScalarValue *data; // decoded typed scalars, expanded into the dense value table at build time
+    size_t count;
+    size_t cap;
+} ValueVec;
+
+
+typedef struct {
+    TagEntry *data;     // tag names (string-table offset/len); node counts are filled in at build time
+    size_t count;
+    size_t cap;
+    uint16_t *slots;    // open-addressing map name_offset -> tag_index (0 = empty slot)
+    size_t slot_cap;
+} TagVec;
+
+
+/*
+ Allocator used by a parse for the builder tables, the parser scratch and the emitted blob. realloc_fn gets the
+ old size (for pool/arena allocators that need it); free_fn may be called with blobs from any thread. The
+ functions must be thread safe when !include files are parsed (they are parsed on worker threads).
+*/
+typedef struct cjyaml_allocator {
+    void *(*malloc_fn)(void *user, size_t size);
+    void *(*realloc_fn)(void *user, void *ptr, size_t old_size, size_t new_size);
+    void (*free_fn)(void *user, void *ptr);
+    void *user;
+} cjyaml_allocator;
 
 typedef struct {
    NodeVec nodes;
    PairVec pairs;
    IndexVec indices;
-   StringVec strings; // unique strings (dedup)
-      // temporary mapping of node scalar -> string index is implicit because scalar node stores offset (we'll fill after building string table)
+   StringArena strings; // unique strings (dedup); scalar nodes store final offsets into it
+   ValueVec values;     // decoded values of typed scalars
+   TagVec tags;         // distinct explicit tags
+   size_t bytes;        // bytes allocated while parsing into this builder (tables, arena and parser scratch),
+                        // for the root builder of a parse including its !include files
+   size_t max_bytes;    // memory budget for `bytes`, 0 = unlimited
+   size_t *parse_bytes; // parsing an !include: the root builder's `bytes`, charged as well (one budget per parse)
+   size_t allocs;       // allocation calls made while parsing into this builder (malloc/realloc that grew)
+   int presize;         // reserve the tables from a pre-scan of the input before parsing
+   int status;          // sticky: CJYAML_OK, or the first CJYAML_ENOMEM / CJYAML_ELIMIT of the parse
+   cjyaml_allocator alloc; // owns every table above (malloc/realloc/free unless replaced)
 } BlobBuilder;
 
 
+/* Status codes (0 = success, negative = error) */
+#define CJYAML_OK       0
+#define CJYAML_EINVAL  (-1)  // invalid argument, blob or node index
+#define CJYAML_EDEPTH  (-2)  // nesting deeper than max_depth
+#define CJYAML_EBUDGET (-3)  // expansion budget (max_nodes) exhausted
+#define CJYAML_ECYCLE  (-4)  // a collection contains itself, or an alias chain does not end
+#define CJYAML_ERANGE  (-5)  // output buffer too small (the required size is still reported)
+#define CJYAML_ENOMEM  (-6)  // native allocation failed
+#define CJYAML_ELIMIT  (-7)  // parse needed more than cjyaml_parse_options.max_bytes
+#define CJYAML_EIO     (-8)  // file could not be read or written
+#define CJYAML_ECHECKSUM (-9) // blob contents do not match its checksum table
+
+/*
+ Public C API (plain C ABI, no JNI types) - also the entry points bound by the Java FFM layer.
+ Returned blobs are heap buffers owned by the caller; release them with cjyaml_free_blob(), which returns each
+ blob to the allocator it came from (a copy of the vtable is kept in front of the blob - the allocator's user data
+ must stay valid until then). Never free() a blob directly.
+ On failure NULL is returned and *out_size is set to 0.
+*/
+MYLIB_API unsigned char *cjyaml_parse_buffer(const void *data, size_t size, size_t *out_size);
+MYLIB_API unsigned char *cjyaml_parse_file(const char *path, size_t *out_size);
+MYLIB_API void cjyaml_free_blob(void *blob);
+/* Parse `path` and atomically write the blob to `blob_path` (for mmap by readers). 0 on success, -1 on failure. */
+MYLIB_API int cjyaml_compile_file(const char *path, const char *blob_path, size_t *out_size);
+
+/*
+ Parsing with options and a status result. Allocation failure never terminates the process: the parse is
+ abandoned, everything it allocated is freed and CJYAML_ENOMEM is returned. max_bytes caps the memory the
+ builder may allocate for one parse (node/pair/index/value/tag tables, string arena and parser scratch; the
+ !include files share it with the including document, charged while they are parsed and again when spliced) - an
+ input that needs more fails fast with CJYAML_ELIMIT. On success *out_blob receives the blob (free with cjyaml_free_blob).
+*/
+#define CJYAML_PARSE_NO_PRESIZE 0x1u // skip the capacity pre-scan and grow the tables on demand
+#define CJYAML_PARSE_CHECKSUM   0x2u // append the checksum table (CJYAML_FLAG_CHECKSUM), e.g. for blobs written to disk
+#define CJYAML_PARSE_INCLUDES   0x4u // resolve "!include path" nodes (see below); off: they stay the tagged path
+
+/*
+ !include files are read only with CJYAML_PARSE_INCLUDES. The path must be relative and stay inside the directory
+ of the including file (for buffer parses: the current directory) once "..", "." and symbolic links are resolved;
+ absolute paths and paths that leave it stay unresolved, like files that cannot be read.
+ The files the document includes directly are parsed by up to include_threads threads (capped at the number of
+ files and CJYAML_MAX_INCLUDE_THREADS; 1 parses them on the calling thread), started for the parse and joined
+ before it returns. Deeper includes are parsed by the thread that parses the including file.
+*/
+
+typedef struct cjyaml_parse_stats {
+    size_t allocations; // allocation calls made by the parse (including !include files)
+    size_t bytes;       // bytes allocated by the parse (what max_bytes is checked against)
+} cjyaml_parse_stats;
+
+typedef struct cjyaml_parse_options {
+    size_t max_bytes;          // 0 = unlimited
+    uint32_t flags;            // CJYAML_PARSE_*
+    cjyaml_parse_stats *stats; // filled in when not NULL (also when the parse fails)
+    const cjyaml_allocator *allocator; // NULL = malloc/realloc/free; ignored by context parses (see below)
+    uint32_t include_threads;  // threads parsing the !include files of the document, 0 = one per CPU
+} cjyaml_parse_options;
+
+MYLIB_API int cjyaml_parse_buffer_opts(const void *data, size_t size, const cjyaml_parse_options *options, unsigned char **out_blob, size_t *out_size);
+MYLIB_API int cjyaml_parse_file_opts(const char *path, const cjyaml_parse_options *options, unsigned char **out_blob, size_t *out_size);
+MYLIB_API int cjyaml_compile_file_opts(const char *path, const char *blob_path, const cjyaml_parse_options *options, size_t *out_size);
+
+/*
+ Capacity pre-sizing. Before parsing, one pass over the input counts line breaks, mapping colons, sequence
+ dashes, flow commas and brackets, and the builder tables are reserved from that estimate once instead of
+ growing through repeated reallocs (skipped when the estimate alone would exceed max_bytes).
+ cjyaml_estimate_capacity exposes the estimate; cjyaml_builder_reserve grows a builder to at least the given
+ capacity (it never shrinks) and returns a CJYAML_* status.
+*/
+typedef struct cjyaml_capacity {
+    size_t nodes;
+    size_t pairs;
+    size_t indices;
+    size_t strings;      // distinct strings
+    size_t string_bytes; // string arena bytes
+} cjyaml_capacity;
+
+MYLIB_API void cjyaml_estimate_capacity(const void *data, size_t size, cjyaml_capacity *out);
+MYLIB_API void cjyaml_builder_init(BlobBuilder *bb);
+MYLIB_API void cjyaml_builder_free(BlobBuilder *bb);
+MYLIB_API int cjyaml_builder_reserve(BlobBuilder *bb, const cjyaml_capacity *capacity);
+
+/*
+ Reusable parse context. It keeps the builder tables, the string arena and its hash table and the parser
+ scratch between parses: each parse resets them instead of freeing, so re-parsing many small documents costs
+ almost no allocations after the first one. A context is not thread safe - use one per thread. The returned
+ blobs are independent of the context (free them with cjyaml_free_blob). cjyaml_context_trim releases the
+ retained memory (e.g. after an unusually large document); the context stays usable.
+ The retained memory counts towards max_bytes as if the parse had allocated it (and shows in stats->bytes), so a
+ context never holds more than the budget. It trims what it holds when that is in the way: a context parse does
+ not fail with CJYAML_ELIMIT where a parse without the context succeeds.
+*/
+typedef struct cjyaml_context cjyaml_context;
+
+MYLIB_API cjyaml_context *cjyaml_context_new(void);
+/* context whose tables and blobs come from allocator (copied; NULL = malloc); options->allocator is not used */
+MYLIB_API cjyaml_context *cjyaml_context_new_with(const cjyaml_allocator *allocator);
+MYLIB_API void cjyaml_context_free(cjyaml_context *ctx);
+MYLIB_API void cjyaml_context_trim(cjyaml_context *ctx);
+MYLIB_API int cjyaml_context_parse_buffer(cjyaml_context *ctx, const void *data, size_t size, const cjyaml_parse_options *options, unsigned char **out_blob, size_t *out_size);
+MYLIB_API int cjyaml_context_parse_file(cjyaml_context *ctx, const char *path, const cjyaml_parse_options *options, unsigned char **out_blob, size_t *out_size);
+
+/*
+ Typed scalar accessors (read the value table; no text parsing).
+ Plain scalars are typed with the YAML 1.2 core schema: decimal/0x/0o ints, floats incl. exponents and .inf/.nan, bools.
+ cjyaml_get_i64 accepts SCALAR_INT and SCALAR_BOOL nodes; cjyaml_get_f64 accepts SCALAR_FLOAT and SCALAR_INT.
+ ALIAS nodes (*name) are followed to the anchored node.
+ Return 0 and store the value on success, -1 if the blob/index is invalid or the node has another type.
+*/
+MYLIB_API int cjyaml_get_i64(const void *blob, size_t blob_size, uint32_t node_index, int64_t *out);
+MYLIB_API int cjyaml_get_f64(const void *blob, size_t blob_size, uint32_t node_index, double *out);
+
+/*
+ Tags. cjyaml_find_tag looks a tag up by its text as written in the YAML ("!secret", "!!str") and stores its
+ tag_index (0 and -1 if no node has that tag). cjyaml_tag_nodes copies the indexes of the nodes carrying
+ tag_index, in document order, to out (at most cap entries) and stores the total number in *out_count, so one
+ call with cap 0 sizes the buffer. Both return 0 on success, -1 on an invalid blob or tag.
+*/
+MYLIB_API int cjyaml_find_tag(const void *blob, size_t blob_size, const char *tag, size_t tag_len, uint16_t *out_tag_index);
+MYLIB_API int cjyaml_tag_nodes(const void *blob, size_t blob_size, uint16_t tag_index, uint32_t *out, size_t cap, size_t *out_count);
+
+
+
+/*
+ Traversal. cjyaml_walk visits the subtree of root depth-first without recursion and calls fn once per event:
+    CJYAML_WALK_SCALAR               a scalar
+    CJYAML_WALK_SEQUENCE / _MAPPING  start of a collection; its items (key, value, key, value, ... for a mapping,
+                                     merge link first when MAPPING_MERGE is set) follow, then CJYAML_WALK_END
+ ALIAS and DOCUMENT nodes are followed, so node_index is never one of them and an aliased subtree is visited at
+ every use. depth is the number of open collections. A non-zero return from fn stops the walk and is returned.
+ Limits (0 selects the default) keep untrusted or alias-heavy blobs cheap: max_depth bounds nesting, max_nodes
+ bounds the number of nodes visited including alias re-expansions (default node_count + CJYAML_WALK_DEFAULT_EXPANSION).
+ root CJYAML_WALK_DOCUMENT walks the document root.
+*/
+#define CJYAML_WALK_SCALAR   0
+#define CJYAML_WALK_SEQUENCE 1
+#define CJYAML_WALK_MAPPING  2
+#define CJYAML_WALK_END      3
+
+#define CJYAML_WALK_DOCUMENT UINT32_MAX
+#define CJYAML_WALK_DEFAULT_DEPTH 1024
+#define CJYAML_WALK_DEFAULT_EXPANSION (1u << 20)
+
+typedef struct cjyaml_walk_limits {
+    uint32_t max_depth;
+    uint64_t max_nodes;
+} cjyaml_walk_limits;
+
+typedef int (*cjyaml_walk_fn)(void *user, int event, uint32_t node_index, uint32_t depth);
+
+MYLIB_API int cjyaml_walk(const void *blob, size_t blob_size, uint32_t root, const cjyaml_walk_limits *limits, cjyaml_walk_fn fn, void *user);
+
+/*
+ Same walk, recorded as (event, node_index) uint32 pairs into out (room for cap events, i.e. 2 * cap uint32).
+ *out_count receives the number of events; CJYAML_ERANGE means cap was too small and nothing past it was written.
+*/
+MYLIB_API int cjyaml_walk_events(const void *blob, size_t blob_size, uint32_t root, const cjyaml_walk_limits *limits, uint32_t *out, size_t cap, size_t *out_count);
+
+/*
+ Integrity of blobs loaded from disk or a cache.
+ cjyaml_verify recomputes the digest of every section of a blob built with CJYAML_PARSE_CHECKSUM and compares
+ it with the checksum table. It is one sequential pass per section (XXH3 runs at memory bandwidth with the SIMD
+ the build targets). Returns CJYAML_OK, CJYAML_ECHECKSUM on a mismatch (out_bad_sections, when not NULL, gets
+ bit 1 << CJYAML_SECTION_* set for each bad section) or CJYAML_EINVAL if the blob has no checksum table or its
+ sections do not fit blob_size.
+ cjyaml_validate checks the structure: every section lies inside blob_size, every node/pair/index/hash/value/tag
+ reference points inside its table, scalar and tag text inside the string table, alias chains end and no node
+ reaches itself through its children or aliases. It returns CJYAML_OK, CJYAML_EINVAL, CJYAML_ECYCLE for a
+ collection that contains itself or CJYAML_ENOMEM (the cycle check allocates 17 bytes of scratch per node). Run it
+ once on an untrusted blob; after that no reference read from it can leave the buffer and a recursive reader
+ terminates, so readers may skip their per-access bounds checks.
+*/
+MYLIB_API int cjyaml_verify(const void *blob, size_t blob_size, uint32_t *out_bad_sections);
+MYLIB_API int cjyaml_validate(const void *blob, size_t blob_size);
+
+/*
+ Trusted blob handle. cjyaml_blob_open runs cjyaml_validate once and caches the section pointers; the handle
+ then carries CJYAML_BLOB_VALIDATED and the inline accessors below read the blob without any checks, so a hot
+ traversal loop is just loads. CJYAML_OPEN_TRUSTED skips the validation for blobs the caller has just built
+ with this library (valid by construction). The blob must outlive the handle.
+ Nothing is checked on access: node indexes must come from the blob itself (root, pairs, sequence items,
+ aliases) or be below node_count, and k below the collection's b.
+*/
+#define CJYAML_BLOB_VALIDATED 0x1u
+#define CJYAML_OPEN_TRUSTED   0x1u
+
+typedef struct cjyaml_blob {
+    const unsigned char *base;
+    size_t size;
+    const NodeEntry *nodes;
+    const PairEntry *pairs;
+    const unsigned char *index;  // uint32 entries, not necessarily aligned
+    const unsigned char *values; // uint64 entries, not necessarily aligned; NULL without a value table
+    const char *strings;
+    const unsigned char *hash;   // HashEntry index sorted by (key_hash, pair_index), not necessarily aligned
+    uint64_t node_count;
+    uint64_t pair_count;
+    uint64_t index_count;
+    uint64_t string_size;
+    uint64_t hash_count;
+    uint32_t root;               // root node of the document (what the DOCUMENT node points to)
+    uint32_t flags;              // CJYAML_BLOB_VALIDATED once open succeeded
+} cjyaml_blob;
+
+/* CJYAML_OK, or CJYAML_EINVAL (handle left without CJYAML_BLOB_VALIDATED) if the blob fails validation. */
+MYLIB_API int cjyaml_blob_open(cjyaml_blob *b, const void *blob, size_t blob_size, uint32_t options);
+/* XXH64 of a scalar's text (compute_hash_from_node without the checks); 0 for other node types */
+MYLIB_API uint64_t cjyaml_blob_hash(const cjyaml_blob *b, uint32_t node_index);
+
+static inline const NodeEntry *cjyaml_blob_node(const cjyaml_blob *b, const uint32_t node_index) {
+    return &b->nodes[node_index];
+}
+
+// follow ALIAS nodes to the anchored node (validation guarantees the chain ends)
+static inline uint32_t cjyaml_blob_resolve(const cjyaml_blob *b, uint32_t node_index) {
+    while (b->nodes[node_index].node_type == ALIAS) node_index = (uint32_t)b->nodes[node_index].a;
+    return node_index;
+}
+
+// k-th item of a SEQUENCE node
+static inline uint32_t cjyaml_blob_item(const cjyaml_blob *b, const NodeEntry *seq, const uint64_t k) {
+    uint32_t v;
+    memcpy(&v, b->index + (size_t)(seq->a + k) * sizeof(uint32_t), sizeof(v));
+    return v;
+}
+
+// k-th pair of a MAPPING node (the merge link first when MAPPING_MERGE is set)
+static inline const PairEntry *cjyaml_blob_pair(const cjyaml_blob *b, const NodeEntry *map, const uint64_t k) {
+    return &b->pairs[map->a + k];
+}
+
+// text of a SCALAR node (not NUL-terminated)
+static inline const char *cjyaml_blob_text(const cjyaml_blob *b, const NodeEntry *scalar, size_t *len) {
+    *len = (size_t)scalar->b;
+    return b->strings + scalar->a;
+}
+
+// value-table slot of a node (see "Value table"); 0 when the blob has none
+static inline uint64_t cjyaml_blob_value(const cjyaml_blob *b, const uint32_t node_index) {
+    uint64_t v = 0;
+    if (b->values) memcpy(&v, b->values + (size_t)node_index * sizeof(uint64_t), sizeof(v));
+    return v;
+}
+
+/*
+ Cursor over a validated blob (cjyaml_blob_open) - a small value type, no allocation. A cursor stands on one
+ node with aliases already resolved; a cursor on a child of a collection also remembers its position there,
+ and for a mapping child the key node of its pair. The children of a MAPPING are its pairs in order (for a
+ MAPPING_MERGE mapping the first one is the '<<' link); the children of a SEQUENCE are its items.
+
+    cjyaml_cursor root = cjyaml_cursor_root(&blob), it;
+    for (int ok = cjyaml_cursor_first_child(&root, &it); ok; ok = cjyaml_cursor_next_sibling(&it)) {
+        size_t klen;
+        const char *key = cjyaml_cursor_key(&it, &klen);
+        ...
+    }
+*/
+typedef struct cjyaml_cursor {
+    const cjyaml_blob *blob;
+    const NodeEntry *parent; // collection the cursor is a child of; NULL for cjyaml_cursor_root / _at
+    uint64_t pos;            // position in parent (pair or item)
+    uint32_t node;           // current node, aliases resolved
+    uint32_t key;            // key node of the current pair; UINT32_MAX if the parent is not a mapping
+} cjyaml_cursor;
+
+static inline cjyaml_cursor cjyaml_cursor_at(const cjyaml_blob *b, const uint32_t node_index) {
+    cjyaml_cursor c;
+    c.blob = b;
+    c.parent = NULL;
+    c.pos = 0;
+    c.node = cjyaml_blob_resolve(b, node_index);
+    c.key = UINT32_MAX;
+    return c;
+}
+
+static inline cjyaml_cursor cjyaml_cursor_root(const cjyaml_blob *b) {
+    return cjyaml_cursor_at(b, b->root);
+}
+
+// SCALAR, SEQUENCE or MAPPING (DOCUMENT for the root of an empty document)
+static inline int cjyaml_cursor_type(const cjyaml_cursor *c) {
+    return c->blob->nodes[c->node].node_type;
+}
+
+// number of children: pairs of a mapping, items of a sequence, 0 otherwise
+static inline uint64_t cjyaml_cursor_count(const cjyaml_cursor *c) {
+    const NodeEntry *n = &c->blob->nodes[c->node];
+    return (n->node_type == SEQUENCE || n->node_type == MAPPING) ? n->b : 0;
+}
+
+// move c onto child pos of parent; 0 (c unchanged) if there is no such child
+static inline int cjyaml_cursor_place(cjyaml_cursor *c, const NodeEntry *parent, const uint64_t pos) {
+    if (pos >= parent->b) return 0;
+    if (parent->node_type == MAPPING) {
+        const PairEntry *p = cjyaml_blob_pair(c->blob, parent, pos);
+        c->key = p->key_node_index;
+        c->node = cjyaml_blob_resolve(c->blob, p->value_node_index);
+    } else {
+        c->key = UINT32_MAX;
+        c->node = cjyaml_blob_resolve(c->blob, cjyaml_blob_item(c->blob, parent, pos));
+    }
+    c->parent = parent;
+    c->pos = pos;
+    return 1;
+}
+
+// child pos of c (random access); 0 if c is not a collection or has fewer children
+static inline int cjyaml_cursor_child(const cjyaml_cursor *c, const uint64_t pos, cjyaml_cursor *child) {
+    const NodeEntry *n = &c->blob->nodes[c->node];
+    if (n->node_type != SEQUENCE && n->node_type != MAPPING) return 0;
+    child->blob = c->blob;
+    return cjyaml_cursor_place(child, n, pos);
+}
+
+static inline int cjyaml_cursor_first_child(const cjyaml_cursor *c, cjyaml_cursor *child) {
+    return cjyaml_cursor_child(c, 0, child);
+}
+
+// advance to the next child of the same parent; 0 (c unchanged) at the last one
+static inline int cjyaml_cursor_next_sibling(cjyaml_cursor *c) {
+    return c->parent != NULL && cjyaml_cursor_place(c, c->parent, c->pos + 1);
+}
+
+// key text of the current pair (not NUL-terminated); NULL if c is not a mapping child or the key is not a scalar
+static inline const char *cjyaml_cursor_key(const cjyaml_cursor *c, size_t *len) {
+    if (c->key == UINT32_MAX) return NULL;
+    const NodeEntry *k = &c->blob->nodes[cjyaml_blob_resolve(c->blob, c->key)];
+    return k->node_type == SCALAR ? cjyaml_blob_text(c->blob, k, len) : NULL;
+}
+
+// scalar text of the current node (not NUL-terminated); NULL if it is not a scalar
+static inline const char *cjyaml_cursor_value(const cjyaml_cursor *c, size_t *len) {
+    const NodeEntry *n = &c->blob->nodes[c->node];
+    return n->node_type == SCALAR ? cjyaml_blob_text(c->blob, n, len) : NULL;
+}
+
+/*
+ Call fn once per child of a MAPPING (cjyaml_for_each_pair) or SEQUENCE (cjyaml_for_each_item) with a cursor on
+ it. Upcoming pair/index entries, their nodes and key texts are prefetched a few children ahead, which is what
+ makes long collections in large (cache-cold, mapped) blobs fast to scan. A non-zero return from fn stops the
+ loop and is returned; CJYAML_EINVAL if the handle is not validated or the node has another type.
+*/
+typedef int (*cjyaml_cursor_fn)(void *user, const cjyaml_cursor *child);
+
+MYLIB_API int cjyaml_for_each_pair(const cjyaml_cursor *map, cjyaml_cursor_fn fn, void *user);
+MYLIB_API int cjyaml_for_each_item(const cjyaml_cursor *seq, cjyaml_cursor_fn fn, void *user);
+
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,475 @@
+#ifndef CJYAML_HPP
+#define CJYAML_HPP
+
+/*
+ Header-only C++17 view over a CJYaml blob.
+
+    cjyaml::View doc(data, size);                  // validates once (cjyaml_blob_open)
+    using namespace cjyaml::literals;
+    int port = doc.at("server.port"_path).as<int>();
+    for (auto [key, value] : doc["servers"].map()) { ... }
+    for (cjyaml::Node item : doc.root()["hosts"].seq()) { std::string_view h = item.str(); }
+
+ Everything except cjyaml_blob_open is inline and reads the blob through the unchecked cjyaml_blob accessors, so
+ lookups and loops compile down to loads. Key hashes of literals ("port"_key, "a.b"_path, cjyaml::path(...)) are
+ computed at compile time and go straight into a binary search of the blob's hash index.
+
+ Lifetime: a View does not own the blob (free it with cjyaml_free_blob after the View is gone) and Nodes, Maps
+ and Seqs point into the View, so it is neither copyable nor movable.
+ Missing keys, out-of-range items and type mismatches give an empty Node (operator bool is false) or an empty
+ std::optional from get<T>(); only as<T>() throws (cjyaml::type_error).
+*/
+
+#include "CJYaml.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace cjyaml {
+
+enum class Type : uint8_t {
+    Scalar = SCALAR,
+    Sequence = SEQUENCE,
+    Mapping = MAPPING,
+    Alias = ALIAS,
+    Document = DOCUMENT,
+    Missing = 0xff // empty Node
+};
+
+class type_error : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// FNV-1a 64-bit, the hash the builder puts into the hash index
+constexpr uint64_t key_hash(std::string_view s) noexcept {
+    uint64_t h = 14695981039346656037ULL;
+    for (const char c : s) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// a mapping key and its hash (a compile-time constant for literals)
+struct Key {
+    std::string_view text;
+    uint64_t hash = key_hash({});
+
+    constexpr Key() noexcept = default;
+    constexpr Key(std::string_view s) noexcept : text(s), hash(key_hash(s)) {}
+    constexpr Key(const char *s) noexcept : Key(std::string_view(s)) {}
+};
+
+inline constexpr std::size_t max_path_depth = 16;
+
+/*
+ A path of keys. A segment of digits only also selects that item when the node it is applied to is a sequence.
+ Path("a.b.0") splits on '.'; cjyaml::path("a.b", "c") takes each argument verbatim (keys containing dots).
+*/
+class Path {
+public:
+    struct Segment {
+        Key key;
+        uint64_t index = 0;
+        bool numeric = false;
+    };
+
+    constexpr Path() noexcept = default;
+
+    constexpr explicit Path(std::string_view dotted) {
+        std::size_t start = 0;
+        for (std::size_t i = 0; i <= dotted.size(); ++i) {
+            if (i == dotted.size() || dotted[i] == '.') {
+                push(dotted.substr(start, i - start));
+                start = i + 1;
+            }
+        }
+    }
+
+    constexpr Path &push(std::string_view key) {
+        if (n_ == max_path_depth) {
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+            throw std::length_error("cjyaml::Path: more than max_path_depth segments");
+#else
+            std::abort();
+#endif
+        }
+        Segment &s = seg_[n_++];
+        s.key = Key(key);
+        s.numeric = !key.empty();
+        s.index = 0;
+        for (const char c : key) {
+            if (c < '0' || c > '9') {
+                s.numeric = false;
+                break;
+            }
+            s.index = s.index * 10 + static_cast<uint64_t>(c - '0');
+        }
+        return *this;
+    }
+
+    constexpr std::size_t size() const noexcept { return n_; }
+    constexpr const Segment &operator[](std::size_t i) const noexcept { return seg_[i]; }
+
+private:
+    Segment seg_[max_path_depth] = {};
+    std::size_t n_ = 0;
+};
+
+template <class... Keys>
+constexpr Path path(const Keys &...keys) {
+    Path p;
+    (p.push(std::string_view(keys)), ...);
+    return p;
+}
+
+namespace literals {
+constexpr Key operator""_key(const char *s, std::size_t n) noexcept { return Key(std::string_view(s, n)); }
+constexpr Path operator""_path(const char *s, std::size_t n) { return Path(std::string_view(s, n)); }
+} // namespace literals
+
+class Map;
+class Seq;
+
+namespace detail {
+// mappings one merge lookup has searched, one bit per node; heap-backed only for blobs over 512 nodes
+class Visited {
+public:
+    explicit Visited(uint64_t node_count) noexcept
+        : bits_(node_count <= sizeof(small_) * 8
+                    ? small_
+                    : static_cast<uint64_t *>(std::calloc(static_cast<std::size_t>((node_count + 63) / 64),
+                                                          sizeof(uint64_t)))) {}
+    ~Visited() {
+        if (bits_ != small_) std::free(bits_);
+    }
+    Visited(const Visited &) = delete;
+    Visited &operator=(const Visited &) = delete;
+
+    explicit operator bool() const noexcept { return bits_ != nullptr; }
+    // true the first time node i is inserted
+    bool insert(uint32_t i) noexcept {
+        const uint64_t bit = uint64_t{1} << (i % 64);
+        if (bits_[i / 64] & bit) return false;
+        bits_[i / 64] |= bit;
+        return true;
+    }
+
+private:
+    uint64_t small_[8] = {};
+    uint64_t *bits_;
+};
+} // namespace detail
+
+class Node {
+public:
+    constexpr Node() noexcept = default;
+    Node(const cjyaml_blob *b, uint32_t index) noexcept : b_(b), i_(cjyaml_blob_resolve(b, index)) {}
+
+    explicit operator bool() const noexcept { return b_ != nullptr; }
+    uint32_t index() const noexcept { return i_; }
+    Type type() const noexcept { return b_ ? static_cast<Type>(entry().node_type) : Type::Missing; }
+    uint16_t tag_index() const noexcept { return b_ ? entry().tag_index : 0; }
+
+    bool is_scalar() const noexcept { return type() == Type::Scalar; }
+    bool is_map() const noexcept { return type() == Type::Mapping; }
+    bool is_seq() const noexcept { return type() == Type::Sequence; }
+    // core-schema null (null, ~, empty)
+    bool is_null() const noexcept { return is_scalar() && (entry().style_flags & SCALAR_NULL) != 0; }
+
+    // scalar text as written (empty for other nodes)
+    std::string_view str() const noexcept {
+        if (!is_scalar()) return {};
+        return std::string_view(b_->strings + entry().a, static_cast<std::size_t>(entry().b));
+    }
+
+    // number of pairs / items (0 for scalars)
+    std::size_t size() const noexcept { return (is_map() || is_seq()) ? static_cast<std::size_t>(entry().b) : 0; }
+
+    inline Map map() const noexcept;
+    inline Seq seq() const noexcept;
+
+    // value of key in a mapping (own pairs first, then '<<' merged parents)
+    Node operator[](const Key &key) const noexcept { return find(key, 0, nullptr); }
+    // i-th item of a sequence
+    Node operator[](std::size_t i) const noexcept {
+        if (!is_seq() || i >= entry().b) return {};
+        return Node(b_, cjyaml_blob_item(b_, &entry(), i));
+    }
+
+    Node at(const Path &p) const noexcept {
+        Node n = *this;
+        for (std::size_t i = 0; i < p.size() && n; ++i) {
+            n = (p[i].numeric && n.is_seq()) ? n[static_cast<std::size_t>(p[i].index)] : n[p[i].key];
+        }
+        return n;
+    }
+
+    /*
+     Typed value: integers (SCALAR_INT/SCALAR_BOOL, range-checked), floating point (SCALAR_FLOAT/SCALAR_INT),
+     bool (SCALAR_BOOL), std::string_view / std::string (any non-null scalar's text). Typed values come from
+     the value table, no text is parsed. Empty on a mismatch.
+    */
+    template <class T>
+    std::optional<T> get() const {
+        if (!is_scalar()) return std::nullopt;
+        const unsigned sub = entry().style_flags & SCALAR_TYPE_MASK;
+        if constexpr (std::is_same_v<T, bool>) {
+            if (sub != SCALAR_BOOL) return std::nullopt;
+            return cjyaml_blob_value(b_, i_) != 0;
+        } else if constexpr (std::is_integral_v<T>) {
+            if (sub != SCALAR_INT && sub != SCALAR_BOOL) return std::nullopt;
+            const int64_t v = static_cast<int64_t>(cjyaml_blob_value(b_, i_));
+            if constexpr (std::is_signed_v<T>) {
+                if (v < static_cast<int64_t>(std::numeric_limits<T>::min()) || v > static_cast<int64_t>(std::numeric_limits<T>::max())) return std::nullopt;
+            } else {
+                if (v < 0 || static_cast<uint64_t>(v) > static_cast<uint64_t>(std::numeric_limits<T>::max())) return std::nullopt;
+            }
+            return static_cast<T>(v);
+        } else if constexpr (std::is_floating_point_v<T>) {
+            const uint64_t bits = cjyaml_blob_value(b_, i_);
+            if (sub == SCALAR_INT) return static_cast<T>(static_cast<int64_t>(bits));
+            if (sub != SCALAR_FLOAT) return std::nullopt;
+            double d;
+            std::memcpy(&d, &bits, sizeof(d));
+            return static_cast<T>(d);
+        } else if constexpr (std::is_same_v<T, std::string_view> || std::is_same_v<T, std::string>) {
+            if (is_null()) return std::nullopt;
+            return T(str());
+        } else {
+            static_assert(sizeof(T) == 0, "cjyaml::Node::get<T>: unsupported type");
+        }
+    }
+
+    // get<T>() or throw type_error (std::abort without exceptions)
+    template <class T>
+    T as() const {
+        if (std::optional<T> v = get<T>()) return *v;
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+        throw type_error("cjyaml: node is missing or not convertible to the requested type");
+#else
+        std::abort();
+#endif
+    }
+
+    template <class T>
+    T value_or(T fallback) const {
+        std::optional<T> v = get<T>();
+        return v ? *v : fallback;
+    }
+
+private:
+    friend class Map;
+    friend class Seq;
+
+    const NodeEntry &entry() const noexcept { return b_->nodes[i_]; }
+
+    uint64_t hash_at(uint64_t e, uint32_t *pair) const noexcept {
+        HashEntry he;
+        std::memcpy(&he, b_->hash + e * sizeof(HashEntry), sizeof(he));
+        *pair = he.pair_index;
+        return he.key_hash;
+    }
+
+    bool key_matches(uint64_t pair, const Key &key) const noexcept {
+        const Node k(b_, b_->pairs[pair].key_node_index);
+        return k.is_scalar() && k.str() == key.text;
+    }
+
+    /*
+     Own pairs first, then the '<<' parents. seen holds the mappings this lookup has already searched: one reached
+     again through another merge link (<<: [*a, *a], diamonds) cannot match, so each is searched once instead of
+     once per path to it. It is created by the first merged mapping, so plain lookups do not touch it.
+    */
+    Node find(const Key &key, int depth, detail::Visited *seen) const noexcept {
+        if (!is_map() || depth > 64 || (seen && !seen->insert(i_))) return {};
+        const NodeEntry &m = entry();
+        const bool merged = (m.style_flags & MAPPING_MERGE) != 0 && m.b > 0;
+        const uint64_t first = merged ? m.a + 1 : m.a;
+        const uint64_t end = m.a + m.b;
+
+        if (b_->hash_count) {
+            // lower bound of (key.hash, first) in the index sorted by (key_hash, pair_index)
+            uint64_t lo = 0, hi = b_->hash_count;
+            while (lo < hi) {
+                const uint64_t mid = lo + (hi - lo) / 2;
+                uint32_t pair;
+                const uint64_t h = hash_at(mid, &pair);
+                if (h < key.hash || (h == key.hash && pair < first)) lo = mid + 1; else hi = mid;
+            }
+            for (uint64_t e = lo; e < b_->hash_count; ++e) {
+                uint32_t pair;
+                if (hash_at(e, &pair) != key.hash || pair >= end) break;
+                if (key_matches(pair, key)) return Node(b_, b_->pairs[pair].value_node_index);
+            }
+        } else {
+            for (uint64_t pair = first; pair < end; ++pair) {
+                if (key_matches(pair, key)) return Node(b_, b_->pairs[pair].value_node_index);
+            }
+        }
+        if (!merged) return {};
+        if (seen) return find_in_parents(key, depth, seen);
+        detail::Visited own(b_->node_count);
+        if (!own) return {};
+        own.insert(i_);
+        return find_in_parents(key, depth, &own);
+    }
+
+    // '<<' link of a MAPPING_MERGE mapping: a mapping, or a sequence of mappings where earlier ones win
+    Node find_in_parents(const Key &key, int depth, detail::Visited *seen) const noexcept {
+        const Node parent(b_, b_->pairs[entry().a].value_node_index);
+        if (parent.is_seq()) {
+            for (uint64_t i = 0; i < parent.entry().b; ++i) {
+                const Node found = Node(b_, cjyaml_blob_item(b_, &parent.entry(), i)).find(key, depth + 1, seen);
+                if (found) return found;
+            }
+            return {};
+        }
+        return parent.find(key, depth + 1, seen);
+    }
+
+    const cjyaml_blob *b_ = nullptr;
+    uint32_t i_ = 0;
+};
+
+// one pair of a mapping; key is empty when the key node is not a scalar
+struct Pair {
+    std::string_view key;
+    Node value;
+};
+
+/*
+ Pairs of a mapping in document order. For a MAPPING_MERGE mapping the first pair is the '<<' link; lookups
+ through operator[] / find follow it, iteration does not.
+*/
+class Map {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Pair;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = Pair;
+
+        iterator() noexcept = default;
+        iterator(const cjyaml_blob *b, uint64_t pair) noexcept : b_(b), pair_(pair) {}
+
+        Pair operator*() const noexcept {
+            const PairEntry &p = b_->pairs[pair_];
+            return Pair{Node(b_, p.key_node_index).str(), Node(b_, p.value_node_index)};
+        }
+        iterator &operator++() noexcept { ++pair_; return *this; }
+        iterator operator++(int) noexcept { iterator t = *this; ++pair_; return t; }
+        bool operator==(const iterator &o) const noexcept { return pair_ == o.pair_; }
+        bool operator!=(const iterator &o) const noexcept { return pair_ != o.pair_; }
+
+    private:
+        const cjyaml_blob *b_ = nullptr;
+        uint64_t pair_ = 0;
+    };
+
+    Map() noexcept = default;
+    explicit Map(const Node &n) noexcept : node_(n.is_map() ? n : Node()) {}
+
+    explicit operator bool() const noexcept { return static_cast<bool>(node_); }
+    std::size_t size() const noexcept { return node_.size(); }
+    bool empty() const noexcept { return size() == 0; }
+    iterator begin() const noexcept { return node_ ? iterator(node_.b_, node_.entry().a) : iterator(); }
+    iterator end() const noexcept { return node_ ? iterator(node_.b_, node_.entry().a + node_.entry().b) : iterator(); }
+
+    Node operator[](const Key &key) const noexcept { return node_[key]; }
+    Node find(const Key &key) const noexcept { return node_[key]; }
+    bool contains(const Key &key) const noexcept { return static_cast<bool>(node_[key]); }
+    Node node() const noexcept { return node_; }
+
+private:
+    Node node_;
+};
+
+// items of a sequence in document order
+class Seq {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Node;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = Node;
+
+        iterator() noexcept = default;
+        iterator(const cjyaml_blob *b, const NodeEntry *seq, uint64_t k) noexcept : b_(b), seq_(seq), k_(k) {}
+
+        Node operator*() const noexcept { return Node(b_, cjyaml_blob_item(b_, seq_, k_)); }
+        iterator &operator++() noexcept { ++k_; return *this; }
+        iterator operator++(int) noexcept { iterator t = *this; ++k_; return t; }
+        bool operator==(const iterator &o) const noexcept { return k_ == o.k_; }
+        bool operator!=(const iterator &o) const noexcept { return k_ != o.k_; }
+
+    private:
+        const cjyaml_blob *b_ = nullptr;
+        const NodeEntry *seq_ = nullptr;
+        uint64_t k_ = 0;
+    };
+
+    Seq() noexcept = default;
+    explicit Seq(const Node &n) noexcept : node_(n.is_seq() ? n : Node()) {}
+
+    explicit operator bool() const noexcept { return static_cast<bool>(node_); }
+    std::size_t size() const noexcept { return node_.size(); }
+    bool empty() const noexcept { return size() == 0; }
+    iterator begin() const noexcept { return node_ ? iterator(node_.b_, &node_.entry(), 0) : iterator(); }
+    iterator end() const noexcept { return node_ ? iterator(node_.b_, &node_.entry(), node_.entry().b) : iterator(); }
+
+    Node operator[](std::size_t i) const noexcept { return node_[i]; }
+    Node node() const noexcept { return node_; }
+
+private:
+    Node node_;
+};
+
+inline Map Node::map() const noexcept { return Map(*this); }
+inline Seq Node::seq() const noexcept { return Seq(*this); }
+
+/*
+ A validated blob. options is passed to cjyaml_blob_open: CJYAML_OPEN_TRUSTED skips the validation for a blob
+ this process has just parsed. An invalid View (operator bool false, status() != CJYAML_OK) yields empty Nodes.
+*/
+class View {
+public:
+    View() noexcept : b_(), status_(CJYAML_EINVAL) {}
+    View(const void *data, std::size_t size, uint32_t options = 0) noexcept : b_() {
+        status_ = cjyaml_blob_open(&b_, data, size, options);
+    }
+    View(const View &) = delete;
+    View &operator=(const View &) = delete;
+
+    explicit operator bool() const noexcept { return (b_.flags & CJYAML_BLOB_VALIDATED) != 0; }
+    int status() const noexcept { return status_; }
+    const cjyaml_blob &blob() const noexcept { return b_; }
+    std::size_t node_count() const noexcept { return static_cast<std::size_t>(b_.node_count); }
+
+    Node root() const noexcept { return *this ? Node(&b_, b_.root) : Node(); }
+    Node node(uint32_t index) const noexcept { return (*this && index < b_.node_count) ? Node(&b_, index) : Node(); }
+    Node operator[](const Key &key) const noexcept { return root()[key]; }
+    Node at(const Path &p) const noexcept { return root().at(p); }
+
+private:
+    cjyaml_blob b_;
+    int status_;
+};
+
+} // namespace cjyaml
+
+#endif /* CJYAML_HPP */
@@ -0,0 +1,549 @@
+/*
+ JNI bindings for com.github.scalerock.cjyaml.CJYaml.NativeBlob. Built into libcjyaml (the cjyaml_jni target) on
+ top of the parser core; everything here goes through the public C API in CJYaml.h, which itself has no JNI types.
+*/
+#include "CJYaml.h"
+
+#include <jni.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* -------------------------
+   JNI helpers
+   ------------------------- */
+
+/* Helper: create direct ByteBuffer or free pointer if creation fails */
+static jobject create_direct_bytebuffer_or_free(JNIEnv *env, void *buf, const jlong len) {
+    jobject bb = (*env)->NewDirectByteBuffer(env, buf, len);
+    if (bb == NULL) {
+        cjyaml_free_blob(buf);
+        buf = NULL;
+        return NULL;
+    }
+    return bb;
+}
+
+/*
+ Raise the Java exception for a failed parse: OutOfMemoryError when native memory ran out, IllegalStateException
+ when the input needs more than the caller's memory budget. Other failures return NULL/-1 without an exception
+ and the Java side reports them.
+*/
+static void throw_parse_status(JNIEnv *env, const int status) {
+    const char *cls_name = NULL;
+    const char *msg = NULL;
+    if (status == CJYAML_ENOMEM) {
+        cls_name = "java/lang/OutOfMemoryError";
+        msg = "native allocation failed while parsing YAML";
+    } else if (status == CJYAML_ELIMIT) {
+        cls_name = "java/lang/IllegalStateException";
+        msg = "YAML exceeds the parser memory budget (maxBytes)";
+    }
+    if (!cls_name) return;
+    const jclass exClass = (*env)->FindClass(env, cls_name);
+    if (exClass) (*env)->ThrowNew(env, exClass, msg);
+}
+
+// parse options from the Java maxBytes argument (<= 0: unlimited); includes only for file parses that ask for them
+static cjyaml_parse_options jni_parse_options(const jlong maxBytes, const jboolean includes) {
+    cjyaml_parse_options o;
+    o.max_bytes = maxBytes > 0 && (uint64_t)maxBytes <= SIZE_MAX ? (size_t)maxBytes : 0;
+    o.flags = includes ? CJYAML_PARSE_INCLUDES : 0;
+    o.stats = NULL;
+    o.allocator = NULL;
+    o.include_threads = 0;
+    return o;
+}
+
+// context handle from Java (0: parse with a fresh builder)
+static cjyaml_context *jni_context(const jlong context) {
+    return (cjyaml_context *)(intptr_t)context;
+}
+
+/* -------------------------
+   JNI wrappers (CJYaml.NativeBlob.NativeLib natives)
+   ------------------------- */
+
+/*
+ * JNI functions: NativeLib_contextNew / NativeLib_contextFree
+ *
+ * Create and release the reusable parse context a CJYaml instance passes to the parse wrappers.
+ * contextNew throws OutOfMemoryError (and returns 0) if the context cannot be allocated.
+ */
+JNIEXPORT jlong JNICALL
+Java_com_github_scalerock_cjyaml_CJYaml_00024NativeBlob_NativeLib_1contextNew(JNIEnv *env, const jclass cls) {
+    (void)cls;
+    cjyaml_context *ctx = cjyaml_context_new();
+    if (ctx == NULL) throw_parse_status(env, CJYAML_ENOMEM);
+    return (jlong)(intptr_t)ctx;
+}
+
+JNIEXPORT void JNICALL
+Java_com_github_scalerock_cjyaml_CJYaml_00024NativeBlob_NativeLib_1contextFree(JNIEnv *env, const jclass cls, const jlong context) {
+    (void)env;
+    (void)cls;
+    cjyaml_context_free(jni_context(context));
+}
+
+
+JNIEXPORT jobject JNICALL
+Java_com_github_scalerock_cjyaml_CJYaml_00024NativeBlob_NativeLib_1parseToDirectByteBuffer(JNIEnv *env, const jclass cls, const jlong context, const jstring path, const jlong maxBytes, const jboolean includes) {
+    (void)cls;
+    if (path == NULL) return NULL;
+
+    const char *cpath = (*env)->GetStringUTFChars(env, path, NULL);
+    if (cpath == NULL) return NULL; // Out of memory
+
+    /* Map, parse and unmap the file into a new buffer */
+    size_t parsed_size = 0;
+    unsigned char *buf = NULL;
+    const cjyaml_parse_options options = jni_parse_options(maxBytes, includes);
+    const int status = cjyaml_context_parse_file(jni_context(context), cpath, &options, &buf, &parsed_size);
+
+    (*env)->ReleaseStringUTFChars(env, path, cpath);
+    cpath = NULL;
+
+    if (!buf) {
+        throw_parse_status(env, status);
+        return NULL;
+    }
+
+    /* Safely convert size_t → jlong */
+    jlong jlen;
+    if (parsed_size <= (size_t)LLONG_MAX) {
+        jlen = (jlong)parsed_size;
+    } else {
+        cjyaml_free_blob(buf);
+        return NULL;
+    }
+
+
+
+    /* Wrap the native buffer as a DirectByteBuffer.
+       The helper should free buf on error automatically. */
+    return create_direct_bytebuffer_or_free(env, buf, jlen);
+}
+
+
+JNIEXPORT jbyteArray JNICALL
+Java_com_github_scalerock_cjyaml_CJYaml_00024NativeBlob_NativeLib_1parseToByteArray(JNIEnv *env, const jclass cls, const jlong context, jstring path, const jlong maxBytes, const jboolean includes) {
+    (void)cls;
+    if (path == NULL) return NULL;
+
+    const char *cpath = (*env)->GetStringUTFChars(env, path, NULL);
+    if (cpath == NULL) return NULL;
+
+    /* Map, parse and unmap the file */
+    size_t parsed_size = 0;
+    unsigned char *buf = NULL;
+    const cjyaml_parse_options options = jni_parse_options(maxBytes, includes);
+    const int status = cjyaml_context_parse_file(jni_context(context), cpath, &options, &buf, &parsed_size);
+    if (!buf) {
+        (*env)->ReleaseStringUTFChars(env, path, cpath);
+        cpath = NULL;
+        throw_parse_status(env, status);
+        return NULL;
+    }
+
+    /* Ensure size fits in jsize */
+    if (parsed_size > (size_t)INT_MAX) {
+        cjyaml_free_blob(buf);
+        (*env)->ReleaseStringUTFChars(env, path, cpath);
+
+        buf = NULL;
+        cpath = NULL;
+        return NULL;
+    }
+    const jsize len = (jsize)parsed_size;
+
+    /* Create a Java byte array for the parsed data */
+    const jbyteArray out = (*env)->NewByteArray(env, len);
+    if (out == NULL) {
+        cjyaml_free_blob(buf);
+        buf = NULL;
+        (*env)->ReleaseStringUTFChars(env, path, cpath);
+        return NULL;
+    }
+
+    /* Copy from native buffer to Java byte[] */
+    (*env)->SetByteArrayRegion(env, out, 0, len, (const jbyte *)buf);
+    if ((*env)->ExceptionCheck(env)) {
+        cjyaml_free_blob(buf);
+        buf = NULL;
+        (*env)->ExceptionClear(env);
+        (*env)->DeleteLocalRef(env, out);
+        (*env)->ReleaseStringUTFChars(env, path, cpath);
+        return NULL;
+    }
+
+    /* Free native memory and release Java string */
+    cjyaml_free_blob(buf);
+    (*env)->ReleaseStringUTFChars(env, path, cpath);
+
+    return out;
+}
+
+JNIEXPORT jbyteArray JNICALL
+Java_com_github_scalerock_cjyaml_CJYaml_00024NativeBlob_NativeLib_1parseToByteArrayFromOpenFile(JNIEnv *env, const jclass cls, const jstring fileContent) {
+    (void)cls;
+    if (fileContent == NULL) return NULL;
+
+    const char *cpath = (*env)->GetStringUTFChars(env, fileContent, NULL);
+    if (cpath == NULL) return NULL;
+
+
+    /* Parse the (modified UTF-8) string contents */
+    size_t parsed_size = 0;
+    const size_t fileSize = (size_t)(*env)->GetStringUTFLength(env, fileContent);
+    void *buf = cjyaml_parse_buffer(cpath, fileSize, &parsed_size);
+    (*env)->ReleaseStringUTFChars(env, fileContent, cpath);
+    cpath = NULL;
+
+    if (buf == NULL) {
+        return NULL;
+    }
+
+    /* Ensure size fits in jsize */
+    if (parsed_size > (size_t)INT_MAX) {
+        cjyaml_free_blob(buf);
+        buf = NULL;
+        return NULL;
+    }
+    const jsize len = (jsize)parsed_size;
+
+    /* Create a Java byte array for the parsed data */
+    const jbyteArray out = (*env)->NewByteArray(env, len);
+    if (out == NULL) {
+        cjyaml_free_blob(buf);
+        buf = NULL;
+        return NULL;
+    }
+
+    /* Copy from native buffer to Java byte[] */
+    (*env)->SetByteArrayRegion(env, out, 0, len, (const jbyte *)buf);
+    if ((*env)->ExceptionCheck(env)) {
+        (*env)->ExceptionClear(env);
+        cjyaml_free_blob(buf);
+        buf = NULL;
+        (*env)->DeleteLocalRef(env, out);
+        return NULL;
+    }
+
+    /* Free native memory (Java string already released) */
+    cjyaml_free_blob(buf);
+    buf = NULL;
+
+    return out;
+}
+
+
+/* Helper: wrap a parsed blob as a DirectByteBuffer (frees the blob on failure) */
+static jobject blob_to_direct_bytebuffer(JNIEnv *env, void *buf, const size_t size) {
+    if (buf == NULL) return NULL;
+    if (size > (size_t)LLONG_MAX) {
+        cjyaml_free_blob(buf);
+        return NULL;
+    }
+    return create_direct_bytebuffer_or_free(env, buf, (jlong)size);
+}
+
+/*
+ * JNI function: NativeLib_parseDirectBytes
+ *
+ * Parses YAML bytes held in a direct ByteBuffer, range [offset, offset + length).
+ * The native address of the buffer is passed straight to parse(): no copy and no
+ * UTF-16 String round trip. Returns the blob as a new DirectByteBuffer, or NULL on failure.
+ */
+JNIEXPORT jobject JNICALL
+Java_com_github_scalerock_cjyaml_CJYaml_00024NativeBlob_NativeLib_1parseDirectBytes(JNIEnv *env, const jclass cls, const jlong context, jobject src, const jint offset, const jint length, const jlong maxBytes) {
+    (void)cls;
+    if (src == NULL || offset < 0 || length <= 0) return NULL;
+
+    const unsigned char *addr = (*env)->GetDirectBufferAddress(env, src);
+    const jlong capacity = (*env)->GetDirectBufferCapacity(env, src);
+    if (addr == NULL || capacity < 0) return NULL;
+    if ((jlong)offset + (jlong)length > capacity) return NULL;
+
+    size_t parsed_size = 0;
+    unsigned char *buf = NULL;
+    const cjyaml_parse_options options = jni_parse_options(maxBytes, JNI_FALSE);
+    const int status = cjyaml_context_parse_buffer(jni_context(context), addr + offset, (size_t)length, &options, &buf, &parsed_size);
+    if (!buf) throw_parse_status(env, status);
+    return blob_to_direct_bytebuffer(env, buf, parsed_size);
+}
+
+/*
+ * JNI function: NativeLib_parseByteArray
+ *
+ * Parses YAML bytes held in a Java byte[], range [offset, offset + length).
+ * The range is copied out with GetByteArrayRegion and parsed from the native copy: a parse can
+ * take long on a large input, and holding a GetPrimitiveArrayCritical region that long would
+ * stall the garbage collector (the copy is cheap next to the parse). Returns the blob as a new
+ * DirectByteBuffer, or NULL on failure.
+ */
+JNIEXPORT jobject JNICALL
+Java_com_github_scalerock_cjyaml_CJYaml_00024NativeBlob_NativeLib_1parseByteArray(JNIEnv *env, const jclass cls, const jlong context, const jbyteArray src, const jint offset, const jint length, const jlong maxBytes) {
+    (void)cls;
+    if (src == NULL || offset < 0 || length <= 0) return NULL;
+    if ((jlong)offset + (jlong)length > (jlong)(*env)->GetArrayLength(env, src)) return NULL;
+
+    jbyte *bytes = malloc((size_t)length);
+    if (bytes == NULL) {
+        throw_parse_status(env, CJYAML_ENOMEM);
+        return NULL;
+    }
+    (*env)->GetByteArrayRegion(env, src, offset, length, bytes);
+    if ((*env)->ExceptionCheck(env)) {
+        free(bytes);
+        return NULL;
+    }
+
+    size_t parsed_size = 0;
+    unsigned char *buf = NULL;
+    const cjyaml_parse_options options = jni_parse_options(maxBytes, JNI_FALSE);
+    const int status = cjyaml_context_parse_buffer(jni_context(context), bytes, (size_t)length, &options, &buf, &parsed_size);
+    free(bytes);
+
+    if (!buf) throw_parse_status(env, status);
+    return blob_to_direct_bytebuffer(env, buf, parsed_size);
+}
+
+
+// walk sink for the JNI wrappers: (event, node) pairs in a growable buffer
+static int event_vec_push(void *user, const int event, const uint32_t node_index, const uint32_t depth) {
+    (void)depth;
+    IndexVec *v = user;
+    if (v->count + 2 > v->cap) {
+        const size_t cap = v->cap ? v->cap * 2 : 256;
+        uint32_t *data = realloc(v->data, cap * sizeof(uint32_t));
+        if (data == NULL) return CJYAML_ENOMEM;
+        v->data = data;
+        v->cap = cap;
+    }
+    v->data[v->count++] = (uint32_t)event;
+    v->data[v->count++] = node_index;
+    return CJYAML_OK;
+}
+
+static const char *walk_status_message(const int rc) {
+    switch (rc) {
+        case CJYAML_EDEPTH:  return "max depth exceeded";
+        case CJYAML_EBUDGET: return "node expansion budget exceeded (alias bomb?)";
+        case CJYAML_ECYCLE:  return "cyclic node graph";
+        case CJYAML_ENOMEM:  return "out of native memory";
+        default:             return "invalid blob or node index";
+    }
+}
+
+/*
+ Walk [blob, blob + size) and return the events as a Java int[] of (event, node) pairs.
+ On failure an IllegalStateException is thrown and NULL returned. The walk itself makes no JNI calls,
+ so blob may point into a critical region that the caller releases afterwards.
+*/
+static jintArray walk_to_int_array(JNIEnv *env, const void *blob, const size_t size, const jint root,
+                                   const jint maxDepth, const jlong maxNodes, const jbyteArray pinned, void *pinned_bytes) {
+    const cjyaml_walk_limits limits = { maxDepth > 0 ? (uint32_t)maxDepth : 0, maxNodes > 0 ? (uint64_t)maxNodes : 0 };
+    IndexVec events = { NULL, 0, 0 };
+    const int rc = cjyaml_walk(blob, size, root < 0 ? CJYAML_WALK_DOCUMENT : (uint32_t)root, &limits, event_vec_push, &events);
+    if (pinned) (*env)->ReleasePrimitiveArrayCritical(env, pinned, pinned_bytes, JNI_ABORT);
+
+    jintArray out = NULL;
+    if (rc != CJYAML_OK) {
+        const jclass exClass = (*env)->FindClass(env, "java/lang/IllegalStateException");
+        if (exClass) (*env)->ThrowNew(env, exClass, walk_status_message(rc));
+    } else if (events.count <= INT32_MAX) {
+        out = (*env)->NewIntArray(env, (jsize)events.count);
+        if (out) (*env)->SetIntArrayRegion(env, out, 0, (jsize)events.count, (const jint *)events.data);
+    }
+    free(events.data);
+    return out;
+}
+
+/*
+ * JNI function: NativeLib_walkDirect / NativeLib_walkArray
+ *
+ * Traverse the subtree of `root` (negative: the document root) of a blob held in a direct ByteBuffer
+ * or a byte[] with cjyaml_walk and return its events for the Java materializer.
+ * maxDepth / maxNodes <= 0 select the native defaults.
+ */
+JNIEXPORT jintArray JNICALL
+Java_com_github_scalerock_cjyaml_CJYaml_00024NativeBlob_NativeLib_1walkDirect(JNIEnv *env, const jclass cls, jobject blob, const jint root, const jint maxDepth, const jlong maxNodes) {
+    (void)cls;
+    if (blob == NULL) return NULL;
+    const unsigned char *addr = (*env)->GetDirectBufferAddress(env, blob);
+    const jlong capacity = (*env)->GetDirectBufferCapacity(env, blob);
+    if (addr == NULL || capacity < 0) return NULL;
+    return walk_to_int_array(env, addr, (size_t)capacity, root, maxDepth, maxNodes, NULL, NULL);
+}
+
+JNIEXPORT jintArray JNICALL
+Java_com_github_scalerock_cjyaml_CJYaml_00024NativeBlob_NativeLib_1walkArray(JNIEnv *env, const jclass cls, const jbyteArray blob, const jint root, const jint maxDepth, const jlong maxNodes) {
+    (void)cls;
+    if (blob == NULL) return NULL;
+    const jsize length = (*env)->GetArrayLength(env, blob);
+    unsigned char *bytes = (*env)->GetPrimitiveArrayCritical(env, blob, NULL);
+    if (bytes == NULL) return NULL;
+    return walk_to_int_array(env, bytes, (size_t)length, root, maxDepth, maxNodes, blob, bytes);
+}
+
+/*
+ * JNI function: NativeLib_verifyDirect
+ *
+ * Check a blob held in a direct ByteBuffer (typically a mapped blob file) before Java reads it:
+ * the checksum table when the blob has one (cjyaml_verify), then the structure (cjyaml_validate).
+ * Returns CJYAML_OK or the failing status; no exception is thrown.
+ */
+JNIEXPORT jint JNICALL
+Java_com_github_scalerock_cjyaml_CJYaml_00024NativeBlob_NativeLib_1verifyDirect(JNIEnv *env, const jclass cls, jobject blob) {
+    (void)cls;
+    if (blob == NULL) return CJYAML_EINVAL;
+    const unsigned char *addr = (*env)->GetDirectBufferAddress(env, blob);
+    const jlong capacity = (*env)->GetDirectBufferCapacity(env, blob);
+    if (addr == NULL || capacity < 0) return CJYAML_EINVAL;
+
+    HeaderBlob h;
+    if ((uint64_t)capacity < HEADER_BLOB_SIZE) return CJYAML_EINVAL;
+    memcpy(&h, addr, HEADER_BLOB_SIZE);
+    if (h.magic != CJYAML_MAGIC) return CJYAML_EINVAL;
+    if (h.flags & CJYAML_FLAG_CHECKSUM) {
+        const int rc = cjyaml_verify(addr, (size_t)capacity, NULL);
+        if (rc != CJYAML_OK) return rc;
+    }
+    return cjyaml_validate(addr, (size_t)capacity);
+}
+
+/*
+ * JNI function: NativeLib_compileToFile
+ *
+ * Parses `path` and writes the blob to `blobPath` (see cjyaml_compile_file).
+ * Java maps the result with FileChannel.map, so the blob never passes through the Java heap
+ * and several JVMs mapping the same file share its page-cache pages.
+ *
+ * Returns the blob size in bytes, or -1 on failure (with a pending exception when memory ran out).
+ */
+JNIEXPORT jlong JNICALL
+Java_com_github_scalerock_cjyaml_CJYaml_00024NativeBlob_NativeLib_1compileToFile(JNIEnv *env, const jclass cls, const jstring path, const jstring blobPath, const jlong maxBytes, const jboolean includes) {
+    (void)cls;
+    if (path == NULL || blobPath == NULL) return -1;
+
+    const char *cpath = (*env)->GetStringUTFChars(env, path, NULL);
+    if (cpath == NULL) return -1;
+    const char *cblob = (*env)->GetStringUTFChars(env, blobPath, NULL);
+    if (cblob == NULL) {
+        (*env)->ReleaseStringUTFChars(env, path, cpath);
+        return -1;
+    }
+
+    size_t blob_size = 0;
+    cjyaml_parse_options options = jni_parse_options(maxBytes, includes);
+    options.flags |= CJYAML_PARSE_CHECKSUM; // blob files carry a checksum table so openBlob can verify them
+    const int rc = cjyaml_compile_file_opts(cpath, cblob, &options, &blob_size);
+
+    (*env)->ReleaseStringUTFChars(env, blobPath, cblob);
+    (*env)->ReleaseStringUTFChars(env, path, cpath);
+
+    if (rc != CJYAML_OK) throw_parse_status(env, rc);
+    if (rc != CJYAML_OK || blob_size > (size_t)LLONG_MAX) return -1;
+    return (jlong)blob_size;
+}
+
+
+/*
+ * freeBlob
+ *
+ * JNI wrapper that releases the native memory of a blob handed to Java as a DirectByteBuffer.
+ *
+ * Java never frees the buffer object itself; it records the blob base address (see blobAddress)
+ * and registers it with a java.lang.ref.Cleaner, so the blob is released either by an explicit
+ * close() or once the DirectByteBuffer becomes unreachable - whichever comes first.
+ *
+ * The function validates the address by reading the first HEADER_BLOB_SIZE bytes
+ * and checking whether the magic number matches the expected CJYAML blob header.
+ * If the magic number does not match, the memory is not freed, and a Java
+ * IllegalArgumentException is thrown instead.
+ *
+ * This prevents accidental free() calls on invalid or non-owned memory.
+ */
+
+/*
+ * Reads a 32-bit unsigned integer from a byte buffer in little-endian order.
+ * This helper is used to interpret the 'magic' field in the CJYAML blob header.
+ *
+ * Parameters:
+ *   p - pointer to the first byte of the 4-byte field
+ *
+ * Returns:
+ *   The decoded 32-bit unsigned integer in host byte order.
+ */
+static uint32_t read_u32_le_from_bytes(const void *p) {
+    const uint8_t *b = (const uint8_t *)p;
+    return (uint32_t)b[0]
+         | ((uint32_t)b[1] << 8)
+         | ((uint32_t)b[2] << 16)
+         | ((uint32_t)b[3] << 24);
+}
+
+/*
+ * JNI function: NativeLib_blobAddress
+ *
+ * Returns the native base address of a DirectByteBuffer created by one of the parse wrappers,
+ * or 0 if the buffer is NULL or not direct. The Java side keeps this address in its Cleaner
+ * state so the release action does not have to reference the buffer object.
+ */
+JNIEXPORT jlong JNICALL
+Java_com_github_scalerock_cjyaml_CJYaml_00024NativeBlob_NativeLib_1blobAddress(JNIEnv *env, const jclass cls, jobject buffer) {
+    (void)cls;
+    if (buffer == NULL) return 0;
+    return (jlong)(intptr_t)(*env)->GetDirectBufferAddress(env, buffer);
+}
+
+/*
+ * JNI function: NativeLib_freeBlob
+ *
+ * Safely frees a native buffer previously allocated by the CJYAML builder and
+ * wrapped into a DirectByteBuffer on the Java side.
+ *
+ * The function performs the following steps:
+ *   1. Takes the native base address recorded by NativeLib_blobAddress.
+ *   2. Reads the first HEADER_BLOB_SIZE bytes of the buffer.
+ *   3. Extracts the 'magic' field from the header and validates it against CJYAML_MAGIC.
+ *   4. If validation succeeds, the memory is freed using cjyaml_free_blob().
+ *   5. If validation fails, a Java IllegalArgumentException is thrown and the
+ *      buffer is left untouched.
+ *
+ * Notes:
+ *   - This function assumes that the address points to the beginning of the blob.
+ *     Passing an offset address will fail validation (by design).
+ *   - The function is no-op if the address is 0.
+ *   - Java guarantees it is called at most once per blob (Cleaner.Cleanable.clean()).
+ */
+JNIEXPORT void JNICALL
+Java_com_github_scalerock_cjyaml_CJYaml_00024NativeBlob_NativeLib_1freeBlob(JNIEnv *env, const jclass cls, const jlong address) {
+    (void)cls;
+
+    void *addr = (void *)(intptr_t)address;
+    if (addr == NULL) return;
+
+    /* Read the first HEADER_BLOB_SIZE bytes to validate the blob header */
+    uint8_t hdr_bytes[HEADER_BLOB_SIZE];
+    memcpy(hdr_bytes, addr, HEADER_BLOB_SIZE);
+
+    /* Extract and validate the magic number (little-endian) */
+    const uint32_t magic = read_u32_le_from_bytes(hdr_bytes);
+
+    if (magic != CJYAML_MAGIC) {
+        const jclass exClass = (*env)->FindClass(env, "java/lang/IllegalArgumentException");
+        if (exClass) {
+            (*env)->ThrowNew(env, exClass, "Buffer magic mismatch: not a CJYAML blob (or not base pointer).");
+        }
+        return;
+    }
+
+    /* Magic number matches – safe to free the memory */
+    cjyaml_free_blob(addr);
+    addr = NULL;
+}
+
+
+
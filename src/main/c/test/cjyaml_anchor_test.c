@@ -0,0 +1,60 @@
+/*
+ Anchor test: "key: &x" in front of a block sequence anchors the sequence, and a "*x" among its own items stays
+ unresolved (the anchor is bound only once the sequence exists), so no blob contains itself. cjyaml_validate
+ rejects blobs whose collections reach themselves, checked on blobs patched into a cycle.
+
+   cjyaml_anchor_test
+*/
+#include "cjyaml_test.h"
+
+static void test_sequence_anchor(void) {
+    static const char text[] = "a: &x\n  - *x\n  - 1\nb: *x\nc: &y\nd: *y\ne: &z\n- *z\nf: *z\n";
+    unsigned char *blob = NULL;
+    size_t size = 0;
+    CHECK(parse_text(text, 0, &blob, &size) == CJYAML_OK, "parse");
+    if (!blob) return;
+    CHECK(cjyaml_validate(blob, size) == CJYAML_OK, "cjyaml_validate");
+    cjyaml_blob b;
+    CHECK(cjyaml_blob_open(&b, blob, size, 0) == CJYAML_OK, "blob does not validate");
+    CHECK(text_is(&b, "a.0", "*x"), "alias inside its own anchored sequence resolved");
+    CHECK(int_at(&b, "a.1") == 1, "a.1");
+    CHECK(text_is(&b, "b.0", "*x") && int_at(&b, "b.1") == 1, "alias after the sequence must reach it");
+    cjyaml_cursor c;
+    CHECK(lookup(&b, "d", &c) && (b.nodes[c.node].style_flags & SCALAR_NULL), "anchored empty value");
+    CHECK(text_is(&b, "e.0", "*z") && text_is(&b, "f.0", "*z"), "flush-left items after an anchor");
+    cjyaml_free_blob(blob);
+}
+
+// point the first child of the collection under "a" back at the collection and check validation fails
+static void test_patched_cycle(const char *text) {
+    unsigned char *blob = NULL;
+    size_t size = 0;
+    CHECK(parse_text(text, 0, &blob, &size) == CJYAML_OK, "%s", text);
+    if (!blob) return;
+    cjyaml_blob b;
+    cjyaml_cursor c;
+    if (cjyaml_blob_open(&b, blob, size, 0) != CJYAML_OK || !lookup(&b, "a", &c)) {
+        CHECK(0, "%s: no collection under a", text);
+        cjyaml_free_blob(blob);
+        return;
+    }
+    const NodeEntry *n = cjyaml_blob_node(&b, c.node);
+    if (n->node_type == SEQUENCE) {
+        memcpy(blob + (b.index - b.base) + (size_t)n->a * sizeof(uint32_t), &c.node, sizeof(uint32_t));
+    } else {
+        PairEntry *p = (PairEntry *)(blob + ((const unsigned char *)cjyaml_blob_pair(&b, n, 0) - b.base));
+        p->value_node_index = c.node;
+    }
+    CHECK(cjyaml_validate(blob, size) == CJYAML_ECYCLE, "%s: collection containing itself validates", text);
+    CHECK(cjyaml_blob_open(&b, blob, size, 0) == CJYAML_EINVAL, "%s: cyclic blob opens", text);
+    cjyaml_free_blob(blob);
+}
+
+int main(void) {
+    test_sequence_anchor();
+    test_patched_cycle("a:\n  - 1\n  - 2\n");
+    test_patched_cycle("a: {k: 1}\n");
+    test_patched_cycle("a: [[1], 2]\n");
+    if (failures) fprintf(stderr, "%d check(s) failed\n", failures);
+    return failures ? 1 : 0;
+}
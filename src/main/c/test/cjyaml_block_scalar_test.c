@@ -0,0 +1,80 @@
+/*
+ Block scalar test: golden values for | and > under each chomping indicator (strip '-', clip, keep '+'), the
+ explicit indentation digit (counted from the parent's indentation, in either order with the chomping
+ indicator), leading and trailing empty lines, white space past the indentation, and the folding of text lines,
+ more-indented lines and empty lines between them.
+
+   cjyaml_block_scalar_test
+*/
+#include "cjyaml_test.h"
+
+#define BYTES(s) s, sizeof(s) - 1
+
+static const struct { const char *yaml; const char *expected; size_t len; } cases[] = {
+    // chomping: the final line break and trailing empty lines
+    { "k: |\n  a\n  b\n\n\nz: 1\n", BYTES("a\nb\n") },
+    { "k: |-\n  a\n  b\n\n\nz: 1\n", BYTES("a\nb") },
+    { "k: |+\n  a\n  b\n\n\nz: 1\n", BYTES("a\nb\n\n\n") },
+    { "k: >\n  a\n  b\n\n", BYTES("a b\n") },
+    { "k: >-\n  a\n  b\n\n", BYTES("a b") },
+    { "k: >+\n  a\n  b\n\n", BYTES("a b\n\n") },
+    { "k: |\n  a", BYTES("a") },                      // the document ends without a break: none to keep
+    { "k: |+\n  a", BYTES("a") },
+    { "k: |-\n  a", BYTES("a") },
+    { "k: >\n  a\n  b", BYTES("a b") },
+    { "k: |\n  a\n  ", BYTES("a\n") },
+    { "k: |+\n  a\n\n  ", BYTES("a\n\n") },
+    { "k: |+\n\n  ", BYTES("\n") },
+    { "k: |\n\nz: 1\n", BYTES("") },                  // no content
+    { "k: |-\n\nz: 1\n", BYTES("") },
+    { "k: |+\n\nz: 1\n", BYTES("\n") },
+    { "k: |+\n  a\n \n\n", BYTES("a\n\n\n") },        // empty lines may hold fewer spaces
+    { "k: |\r\n  a\r\n  b\r\n\r\n", BYTES("a\nb\n") },
+    { "k: | # comment\n  a\n", BYTES("a\n") },
+    // indentation: detected from the first content line, or the digit added to the parent's indentation
+    { "k: |\n\n  a\n", BYTES("\na\n") },
+    { "k: |\n    a\n    b\nz: 1\n", BYTES("a\nb\n") }, // a less indented line ends the scalar
+    { "k: |2\n   a\n  b\n", BYTES(" a\nb\n") },
+    { "k: |1\n\n  a\n", BYTES("\n a\n") },
+    { "k: |-2\n    a\n", BYTES("  a") },
+    { "k: |2-\n    a\n", BYTES("  a") },
+    { "k: >+1\n  a\n\n", BYTES(" a\n\n") },
+    { "m:\n  k: |1\n    a\n", BYTES(" a\n") },        // relative to the parent at 2, not to column 0
+    { "m:\n  k: |2\n      a\n    b\n", BYTES("  a\nb\n") },
+    // white space past the indentation is content, not an empty line
+    { "k: |\n  a\n    \n  b\n", BYTES("a\n  \nb\n") },
+    { "k: |\n  a\n    \n", BYTES("a\n  \n") },
+    { "k: |\n  a\n  \t\n  b\n", BYTES("a\n\t\nb\n") },
+    // folding: a single break between text lines is a space, each empty line a line feed
+    { "k: >\n  a\n  b\n\n  c\n", BYTES("a b\nc\n") },
+    { "k: >\n  a\n\n\n  b\n", BYTES("a\n\nb\n") },
+    { "k: >\n\n  a\n  b\n", BYTES("\na b\n") },
+    { "k: >\n  a b  \n  c\n", BYTES("a b   c\n") },     // trailing spaces are content
+    // ... but breaks next to more-indented lines are kept, with the empty lines around them
+    { "k: >\n  a\n    b\n  c\n", BYTES("a\n  b\nc\n") },
+    { "k: >\n  a\n  b\n    c\n  d\n\n  e\n", BYTES("a b\n  c\nd\ne\n") },
+    { "k: >\n  a\n\n    b\n\n  c\n", BYTES("a\n\n  b\n\nc\n") },
+    { "k: >\n  a\n    b\n    c\n  d\n", BYTES("a\n  b\n  c\nd\n") },
+    { "k: >\n  a\n  \tb\n  c\n", BYTES("a\n\tb\nc\n") },  // a tab after the indentation counts as more-indented
+    { "k: >\n  a\n    \n  b\n", BYTES("a\n  \nb\n") },
+    { "k: >-\n    a\n    b\nz: 1\n", BYTES("a b") },
+    // literal: no folding at all
+    { "k: |\n  a\n  b\n\n  c\n", BYTES("a\nb\n\nc\n") },
+    { "k: |\n  a\n    b\n  c\n", BYTES("a\n  b\nc\n") },
+};
+
+int main(void) {
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        unsigned char *blob = NULL;
+        size_t size = 0;
+        CHECK(parse_text(cases[i].yaml, 0, &blob, &size) == CJYAML_OK, "case %zu", i);
+        if (!blob) continue;
+        cjyaml_blob b;
+        CHECK(cjyaml_blob_open(&b, blob, size, 0) == CJYAML_OK && text_is_n(&b, "k", cases[i].expected, cases[i].len),
+              "case %zu", i);
+        if (strstr(cases[i].yaml, "\nz: 1\n")) CHECK(int_at(&b, "z") == 1, "case %zu: key after the scalar", i);
+        cjyaml_free_blob(blob);
+    }
+    if (failures) fprintf(stderr, "%d check(s) failed\n", failures);
+    return failures ? 1 : 0;
+}
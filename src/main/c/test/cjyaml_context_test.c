@@ -0,0 +1,134 @@
+/*
+ Context test: the memory a reused cjyaml_context retains counts towards max_bytes, so a warmed context never
+ charges more than the budget, yet it parses every document a parse without it fits into the budget, to the same
+ blob.
+
+   cjyaml_context_test
+*/
+#include "cjyaml_test.h"
+
+// "k0: v0\n" .. : many distinct keys and values
+static char *key_document(const int keys, const char *value_prefix, size_t *len) {
+    char *text = malloc((size_t)keys * 64);
+    if (!text) exit(2);
+    size_t w = 0;
+    for (int i = 0; i < keys; ++i) w += (size_t)sprintf(text + w, "k%d: %s%d\n", i, value_prefix, i);
+    *len = w;
+    return text;
+}
+
+static int parse_fresh(const char *text, const size_t len, const size_t max_bytes, unsigned char **blob,
+                       size_t *size, size_t *bytes) {
+    cjyaml_parse_stats stats = { 0, 0 };
+    cjyaml_parse_options opts = { 0 };
+    opts.max_bytes = max_bytes;
+    opts.stats = &stats;
+    const int rc = cjyaml_parse_buffer_opts(text, len, &opts, blob, size);
+    if (bytes) *bytes = stats.bytes;
+    return rc;
+}
+
+static int parse_in(cjyaml_context *ctx, const char *text, const size_t len, const size_t max_bytes,
+                    unsigned char **blob, size_t *size, size_t *bytes) {
+    cjyaml_parse_stats stats = { 0, 0 };
+    cjyaml_parse_options opts = { 0 };
+    opts.max_bytes = max_bytes;
+    opts.stats = &stats;
+    const int rc = cjyaml_context_parse_buffer(ctx, text, len, &opts, blob, size);
+    if (bytes) *bytes = stats.bytes;
+    return rc;
+}
+
+// a document that does not fit the budget fresh does not fit it on a context warmed by the same document
+static void test_warm_context_budget(void) {
+    size_t len;
+    char *text = key_document(50000, "value-", &len);
+    const size_t budget = 64 * 1024;
+    unsigned char *blob = NULL;
+    size_t size = 0;
+    CHECK(parse_fresh(text, len, budget, &blob, &size, NULL) == CJYAML_ELIMIT, "fresh parse under %zu", budget);
+    cjyaml_free_blob(blob);
+
+    cjyaml_context *ctx = cjyaml_context_new();
+    size_t warm_bytes = 0;
+    blob = NULL;
+    CHECK(parse_in(ctx, text, len, 0, &blob, &size, &warm_bytes) == CJYAML_OK, "unlimited context parse");
+    cjyaml_free_blob(blob);
+    CHECK(warm_bytes > budget, "50000 keys in %zu bytes", warm_bytes);
+
+    size_t bytes = 0;
+    blob = NULL;
+    CHECK(parse_in(ctx, text, len, budget, &blob, &size, &bytes) == CJYAML_ELIMIT,
+          "warmed context parsed past max_bytes %zu", budget);
+    CHECK(bytes <= budget, "%zu bytes charged over a budget of %zu", bytes, budget);
+    cjyaml_free_blob(blob);
+
+    // a small document still parses under the budget: the context lets its retained memory go
+    static const char small[] = "a: 1\nb: [x, y]\n";
+    blob = NULL;
+    CHECK(parse_in(ctx, small, sizeof(small) - 1, 4096, &blob, &size, &bytes) == CJYAML_OK, "small document");
+    CHECK(bytes <= 4096, "%zu bytes charged over a budget of 4096", bytes);
+    cjyaml_free_blob(blob);
+
+    // an unlimited parse on the context reports the retained memory as well
+    size_t small_bytes = 0;
+    blob = NULL;
+    CHECK(parse_fresh(small, sizeof(small) - 1, 0, &blob, &size, &small_bytes) == CJYAML_OK, "small document");
+    cjyaml_free_blob(blob);
+    blob = NULL;
+    CHECK(parse_in(ctx, text, len, 0, &blob, &size, NULL) == CJYAML_OK, "unlimited context parse");
+    cjyaml_free_blob(blob);
+    blob = NULL;
+    CHECK(parse_in(ctx, small, sizeof(small) - 1, 0, &blob, &size, &bytes) == CJYAML_OK, "small document");
+    CHECK(bytes > budget && bytes > small_bytes, "%zu bytes reported on a context warmed by 50000 keys", bytes);
+    cjyaml_free_blob(blob);
+
+    cjyaml_context_free(ctx);
+    free(text);
+}
+
+/*
+ Budgets around what a document needs fresh, on a context first warmed by a document with a different shape (long
+ values, fewer keys): the context parse must succeed whenever the fresh one does, give the same blob, and never
+ charge more than the budget.
+*/
+static void test_budget_matches_fresh(void) {
+    size_t warm_len, len;
+    char *warm = key_document(2000, "a-much-longer-value-that-fills-the-string-arena-", &warm_len);
+    char *text = key_document(4000, "v", &len);
+    unsigned char *ref = NULL;
+    size_t ref_size = 0, need = 0;
+    CHECK(parse_fresh(text, len, 0, &ref, &ref_size, &need) == CJYAML_OK, "fresh parse");
+
+    cjyaml_context *ctx = cjyaml_context_new();
+    for (size_t max_bytes = need - need / 4; max_bytes < need + need / 4; max_bytes += need / 64) {
+        unsigned char *blob = NULL;
+        size_t size = 0;
+        CHECK(parse_in(ctx, warm, warm_len, 0, &blob, &size, NULL) == CJYAML_OK, "warming parse");
+        cjyaml_free_blob(blob);
+
+        const int fresh = parse_fresh(text, len, max_bytes, &blob, &size, NULL);
+        cjyaml_free_blob(blob);
+        blob = NULL;
+        size_t bytes = 0;
+        const int rc = parse_in(ctx, text, len, max_bytes, &blob, &size, &bytes);
+        CHECK(rc == CJYAML_OK || (rc == CJYAML_ELIMIT && fresh == CJYAML_ELIMIT),
+              "max_bytes %zu of %zu: context %d, fresh %d", max_bytes, need, rc, fresh);
+        CHECK(bytes <= max_bytes, "max_bytes %zu: %zu bytes charged", max_bytes, bytes);
+        if (rc == CJYAML_OK) {
+            CHECK(size == ref_size && memcmp(blob, ref, size) == 0, "max_bytes %zu: blob differs", max_bytes);
+        }
+        cjyaml_free_blob(blob);
+    }
+    cjyaml_context_free(ctx);
+    cjyaml_free_blob(ref);
+    free(warm);
+    free(text);
+}
+
+int main(void) {
+    test_warm_context_budget();
+    test_budget_matches_fresh();
+    if (failures) fprintf(stderr, "%d check(s) failed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,152 @@
+/*
+ Flow collection test: nested [ ] and { }, the nesting limit (CJYAML_MAX_FLOW_DEPTH + 1 levels parse, one more
+ makes the value a plain scalar), and the rollback of malformed flow values: the value becomes the plain text as
+ written, the nodes emitted for it are dropped, anchors defined inside it are forgotten, anchors it redefined
+ name their earlier node again and tags it introduced leave the tag table.
+
+   cjyaml_flow_test
+*/
+#include "cjyaml_test.h"
+
+// flow levels that still parse: the outermost collection is depth 0, CJYAML_MAX_FLOW_DEPTH the deepest
+#define FLOW_LEVELS 257
+
+static int open_text(const char *text, unsigned char **blob, cjyaml_blob *b) {
+    size_t size = 0;
+    *blob = NULL;
+    CHECK(parse_text(text, 0, blob, &size) == CJYAML_OK, "%s", text);
+    if (!*blob) return 0;
+    if (cjyaml_blob_open(b, *blob, size, 0) != CJYAML_OK) {
+        CHECK(0, "%s: blob does not validate", text);
+        cjyaml_free_blob(*blob);
+        return 0;
+    }
+    return 1;
+}
+
+static uint64_t node_count(const char *text) {
+    unsigned char *blob;
+    cjyaml_blob b;
+    if (!open_text(text, &blob, &b)) return 0;
+    const uint64_t n = b.node_count;
+    cjyaml_free_blob(blob);
+    return n;
+}
+
+static void test_nesting(void) {
+    unsigned char *blob;
+    cjyaml_blob b;
+    if (!open_text("k: [1, [2, {a: 3, b: [4, 5]}], {c: {d: e}}, [], {}]\n"
+                   "m: {s: [x, 'y', \"a,b\"], n: {o: {p: q}}, e: [], f: {}}\n", &blob, &b)) return;
+    cjyaml_cursor c;
+    CHECK(int_at(&b, "k.0") == 1 && int_at(&b, "k.1.0") == 2, "k");
+    CHECK(int_at(&b, "k.1.1.a") == 3 && int_at(&b, "k.1.1.b.1") == 5, "mapping inside a sequence");
+    CHECK(text_is(&b, "k.2.c.d", "e"), "k.2.c.d");
+    CHECK(lookup(&b, "k.3", &c) && cjyaml_cursor_type(&c) == SEQUENCE && cjyaml_cursor_count(&c) == 0, "[]");
+    CHECK(lookup(&b, "k.4", &c) && cjyaml_cursor_type(&c) == MAPPING && cjyaml_cursor_count(&c) == 0, "{}");
+    CHECK(text_is(&b, "m.s.0", "x") && text_is(&b, "m.s.1", "y") && text_is(&b, "m.s.2", "a,b"), "m.s");
+    CHECK(text_is(&b, "m.n.o.p", "q"), "m.n.o.p");
+    CHECK(lookup(&b, "m.f", &c) && cjyaml_cursor_type(&c) == MAPPING && cjyaml_cursor_count(&c) == 0, "m.f");
+    cjyaml_free_blob(blob);
+}
+
+// "k: " + levels alternating [ and {a: ... } + closing brackets
+static char *nested_text(const int levels) {
+    char *text = malloc((size_t)levels * 6 + 16);
+    if (!text) exit(2);
+    size_t w = (size_t)sprintf(text, "k: ");
+    for (int i = 0; i < levels; ++i) w += (size_t)sprintf(text + w, i % 2 ? "{a: " : "[");
+    for (int i = levels - 1; i >= 0; --i) text[w++] = i % 2 ? '}' : ']';
+    strcpy(text + w, "\nz: 1\n");
+    return text;
+}
+
+static void test_depth_limit(void) {
+    for (int levels = FLOW_LEVELS - 1; levels <= FLOW_LEVELS + 1; ++levels) {
+        char *text = nested_text(levels);
+        unsigned char *blob;
+        cjyaml_blob b;
+        if (open_text(text, &blob, &b)) {
+            cjyaml_cursor c;
+            CHECK(lookup(&b, "k", &c), "k");
+            int depth = 0; // collections on the chain of first children
+            for (cjyaml_cursor it; cjyaml_cursor_type(&c) != SCALAR; c = it) {
+                ++depth;
+                if (!cjyaml_cursor_first_child(&c, &it)) break;
+            }
+            if (levels <= FLOW_LEVELS) {
+                CHECK(depth == levels, "%d levels: %d nested collections reached", levels, depth);
+            } else {
+                CHECK(depth == 0 && text_is_n(&b, "k", text + 3, strlen(text + 3) - strlen("\nz: 1\n")),
+                      "%d levels: the value must be the plain text", levels);
+                CHECK(b.node_count == node_count("k: x\nz: 1\n"), "%d levels: %llu nodes left after the rollback",
+                      levels, (unsigned long long)b.node_count);
+            }
+            CHECK(int_at(&b, "z") == 1, "%d levels: key after the value", levels);
+            cjyaml_free_blob(blob);
+        }
+        free(text);
+    }
+}
+
+static void test_rollback(void) {
+    static const char *const values[] = {
+        "[1, 2",            // unterminated
+        "[1, [2, 3]",
+        "{a: 1} trailing",  // text after the collection
+        "[a, {b: c]",       // mismatched brackets
+        "[a, b]]",
+        "[\"open, b]",      // unterminated quote inside
+        "{a: [1, {b: 2}}",
+    };
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+        char text[128];
+        snprintf(text, sizeof(text), "k: %s\nz: [1, {y: 2}]\n", values[i]);
+        unsigned char *blob;
+        cjyaml_blob b;
+        if (!open_text(text, &blob, &b)) continue;
+        CHECK(text_is(&b, "k", values[i]), "%s: the value must be the plain text", values[i]);
+        CHECK(int_at(&b, "z.1.y") == 2, "%s: flow value after the rollback", values[i]);
+        CHECK(b.node_count == node_count("k: x\nz: [1, {y: 2}]\n"), "%s: %llu nodes left after the rollback",
+              values[i], (unsigned long long)b.node_count);
+        cjyaml_free_blob(blob);
+    }
+}
+
+// an anchor inside a rolled-back value names nothing: aliases to it stay plain, earlier bindings come back
+static void test_anchor_rollback(void) {
+    unsigned char *blob;
+    cjyaml_blob b;
+    if (!open_text("k: [&x 1, 2\nj: *x\na: &y [5]\nm: {q: &y 6} junk\nn: *y\np: [&w 7, *w]\n", &blob, &b)) return;
+    CHECK(text_is(&b, "k", "[&x 1, 2"), "k");
+    CHECK(text_is(&b, "j", "*x"), "alias to an anchor of a rolled-back value resolved");
+    CHECK(text_is(&b, "m", "{q: &y 6} junk"), "m");
+    CHECK(int_at(&b, "n.0") == 5, "a rolled-back value must give a redefined anchor its earlier node back");
+    CHECK(int_at(&b, "p.0") == 7 && int_at(&b, "p.1") == 7, "anchor and alias inside one flow value");
+    cjyaml_free_blob(blob);
+}
+
+// tags interned by a rolled-back value are dropped with it; tags it only reused stay, and later tags follow on
+static void test_tag_rollback(void) {
+    unsigned char *blob;
+    cjyaml_blob b;
+    if (!open_text("a: !u 0\nk: [!t 1, !u 2\nz: !v [3]\n", &blob, &b)) return;
+    uint16_t t = 0, u = 0, v = 0;
+    size_t count = 0;
+    CHECK(cjyaml_find_tag(b.base, b.size, "!t", 2, &t) != 0 && t == 0, "tag of a rolled-back value kept as %u", t);
+    CHECK(cjyaml_find_tag(b.base, b.size, "!u", 2, &u) == 0 && u == 1, "!u: tag_index %u", u);
+    CHECK(cjyaml_tag_nodes(b.base, b.size, u, NULL, 0, &count) == 0 && count == 1, "!u: %zu nodes", count);
+    CHECK(cjyaml_find_tag(b.base, b.size, "!v", 2, &v) == 0 && v == 2, "!v: tag_index %u", v);
+    CHECK(cjyaml_tag_nodes(b.base, b.size, v, NULL, 0, &count) == 0 && count == 1, "!v: %zu nodes", count);
+    cjyaml_free_blob(blob);
+}
+
+int main(void) {
+    test_nesting();
+    test_depth_limit();
+    test_rollback();
+    test_anchor_rollback();
+    test_tag_rollback();
+    if (failures) fprintf(stderr, "%d check(s) failed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,369 @@
+/*
+ !include test: writes a tree of YAML files under <dir> and parses it with 1 to 16 include workers. Checks that
+ nested includes resolve relative to the including file, that missing files, cycles and paths leaving the
+ including file's directory stay unresolved, that every worker count produces the same blob, that parses running
+ out of max_bytes fail cleanly and that includes are off without CJYAML_PARSE_INCLUDES. Build with
+ CJYAML_SANITIZE to run it under ASan/UBSan or TSan.
+
+   cjyaml_include_test <dir>
+*/
+#include "cjyaml_test.h"
+
+#include <stdarg.h>
+
+#if defined(_WIN32)
+    #include <direct.h>
+    #define make_dir(path) _mkdir(path)
+    #define change_dir(path) _chdir(path)
+#else
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define make_dir(path) mkdir((path), 0755)
+    #define change_dir(path) chdir(path)
+#endif
+
+#if defined(_WIN32)
+    #include <windows.h>
+    #define atomic_inc(p) InterlockedIncrement64(p)
+    #define atomic_dec(p) InterlockedDecrement64(p)
+#else
+    #define atomic_inc(p) __atomic_add_fetch((p), 1, __ATOMIC_RELAXED)
+    #define atomic_dec(p) __atomic_sub_fetch((p), 1, __ATOMIC_RELAXED)
+#endif
+
+#define INCLUDE_FILES 40
+
+static const char *root_dir;
+
+static void write_file(const char *name, const char *fmt, ...) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s", root_dir, name);
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        fprintf(stderr, "cannot write %s\n", path);
+        exit(2);
+    }
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(f, fmt, ap);
+    va_end(ap);
+    fclose(f);
+}
+
+static void sub_dir(const char *name) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s", root_dir, name);
+    make_dir(path);
+}
+
+/*
+ root.yaml includes inc/f0..f39.yaml under the keys f0..f39 (the parser reads block mappings flat, so nesting
+ comes from the includes). Every fN includes sub/leaf.yaml relative to inc/; odd ones also include sub/mid.yaml,
+ which includes leaf.yaml relative to inc/sub/; every fifth one includes a missing file. cycle_a.yaml and
+ cycle_b.yaml include each other.
+*/
+static void write_fixture(void) {
+    make_dir(root_dir);
+    sub_dir("inc");
+    sub_dir("inc/sub");
+    write_file("inc/sub/leaf.yaml", "leaf: true\nvalue: 42\n");
+    write_file("inc/sub/mid.yaml", "mid: yes\ninner: !include leaf.yaml\n");
+    write_file("inc/cycle_a.yaml", "a: !include cycle_b.yaml\n");
+    write_file("inc/cycle_b.yaml", "b: !include cycle_a.yaml\n");
+    write_file("secret.yaml", "secret: 1\n");
+    write_file("inc/escape.yaml", "up: !include ../secret.yaml\nabs: !include %s/secret.yaml\n"
+               "sub: !include sub/../../secret.yaml\n", root_dir);
+    for (int i = 0; i < INCLUDE_FILES; ++i) {
+        char name[64];
+        snprintf(name, sizeof(name), "inc/f%d.yaml", i);
+        write_file(name, "id: %d\nname: file-%d\nleaf: !include sub/leaf.yaml\n%s%s", i, i,
+                   i % 2 ? "deeper: !include sub/mid.yaml\n" : "",
+                   i % 5 == 0 ? "broken: !include sub/absent.yaml\n" : "");
+    }
+    char root[8192];
+    size_t w = 0;
+    for (int i = 0; i < INCLUDE_FILES; ++i) {
+        w += (size_t)snprintf(root + w, sizeof(root) - w, "f%d: !include inc/f%d.yaml\n", i, i);
+    }
+    snprintf(root + w, sizeof(root) - w, "missing: !include inc/nope.yaml\ncycle: !include inc/cycle_a.yaml\n"
+             "escape: !include inc/escape.yaml\n");
+    write_file("root.yaml", "%s", root);
+}
+
+static void check_document(const unsigned char *data, const size_t size) {
+    cjyaml_blob b;
+    CHECK(cjyaml_blob_open(&b, data, size, 0) == CJYAML_OK, "blob does not validate");
+    for (int i = 0; i < INCLUDE_FILES; ++i) {
+        char path[64];
+        snprintf(path, sizeof(path), "f%d.id", i);
+        CHECK(int_at(&b, path) == i, "%s", path);
+        snprintf(path, sizeof(path), "f%d.leaf.value", i);
+        CHECK(int_at(&b, path) == 42, "%s", path);
+        if (i % 2) {
+            snprintf(path, sizeof(path), "f%d.deeper.inner.value", i);
+            CHECK(int_at(&b, path) == 42, "%s: nested include not resolved against inc/sub/", path);
+        }
+        if (i % 5 == 0) {
+            snprintf(path, sizeof(path), "f%d.broken", i);
+            CHECK(text_is(&b, path, "sub/absent.yaml"), "%s: missing file must stay the tagged path", path);
+        }
+    }
+    CHECK(text_is(&b, "missing", "inc/nope.yaml"), "missing include");
+    CHECK(text_is(&b, "cycle.a.b", "cycle_a.yaml"), "include cycle must stop at the repeated file");
+    CHECK(text_is(&b, "escape.up", "../secret.yaml"), "include left the including file's directory");
+    CHECK(text_is(&b, "escape.sub", "sub/../../secret.yaml"), "include left the including file's directory");
+    CHECK(int_at(&b, "escape.abs.secret") == -1, "absolute include resolved");
+}
+
+static unsigned char *parse_with_threads(const char *path, const uint32_t threads, size_t *size) {
+    cjyaml_parse_options opts = { 0 };
+    opts.flags = CJYAML_PARSE_INCLUDES;
+    opts.include_threads = threads;
+    unsigned char *blob = NULL;
+    const int rc = cjyaml_parse_file_opts(path, &opts, &blob, size);
+    CHECK(rc == CJYAML_OK, "parse with %u workers: %d", threads, rc);
+    return blob;
+}
+
+static void test_worker_counts(const char *root) {
+    size_t ref_size = 0;
+    unsigned char *ref = parse_with_threads(root, 1, &ref_size);
+    if (!ref) return;
+    check_document(ref, ref_size);
+
+    static const uint32_t counts[] = { 2, 3, 8, 16 };
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i) {
+        size_t size = 0;
+        unsigned char *blob = parse_with_threads(root, counts[i], &size);
+        if (!blob) continue;
+        CHECK(size == ref_size && memcmp(blob, ref, size) == 0, "%u workers: blob differs from the serial parse",
+              counts[i]);
+        cjyaml_free_blob(blob);
+    }
+    cjyaml_free_blob(ref);
+}
+
+// bytes the root document needs without its includes (parsed from memory, the includes do not resolve)
+static size_t root_bytes(const char *root) {
+    FILE *f = fopen(root, "rb");
+    if (!f) return 0;
+    char text[8192];
+    const size_t len = fread(text, 1, sizeof(text), f);
+    fclose(f);
+    cjyaml_parse_stats stats = { 0, 0 };
+    cjyaml_parse_options opts = { 0 };
+    opts.flags = CJYAML_PARSE_INCLUDES;
+    opts.stats = &stats;
+    unsigned char *blob = NULL;
+    size_t size = 0;
+    cjyaml_parse_buffer_opts(text, len, &opts, &blob, &size);
+    cjyaml_free_blob(blob);
+    return (size_t)stats.bytes;
+}
+
+/*
+ Memory budgets that run out while the root document queues its includes and around the point where it starts
+ them: every parse must fail cleanly with CJYAML_ELIMIT (LeakSanitizer reports what an unwind dropped) or produce
+ the unlimited blob.
+*/
+static void test_budget(const char *root, const uint32_t threads) {
+    cjyaml_parse_stats stats = { 0, 0 };
+    cjyaml_parse_options opts = { 0 };
+    opts.flags = CJYAML_PARSE_INCLUDES;
+    opts.stats = &stats;
+    opts.include_threads = threads;
+    size_t ref_size = 0;
+    unsigned char *ref = NULL;
+    CHECK(cjyaml_parse_file_opts(root, &opts, &ref, &ref_size) == CJYAML_OK, "unlimited parse");
+    if (!ref) return;
+
+    const size_t own = root_bytes(root);
+    for (size_t max_bytes = own > 2048 ? own - 2048 : 1; max_bytes < own + 2048; max_bytes += 8) {
+        opts.max_bytes = max_bytes;
+        unsigned char *blob = NULL;
+        size_t size = 0;
+        const int rc = cjyaml_parse_file_opts(root, &opts, &blob, &size);
+        CHECK(rc == CJYAML_OK || rc == CJYAML_ELIMIT, "%u workers, max_bytes %zu: %d", threads, max_bytes, rc);
+        if (rc == CJYAML_OK) {
+            CHECK(size == ref_size && memcmp(blob, ref, size) == 0, "%u workers, max_bytes %zu: blob differs",
+                  threads, max_bytes);
+        }
+        cjyaml_free_blob(blob);
+    }
+    cjyaml_free_blob(ref);
+}
+
+static int parse_counting(const char *path, const uint32_t threads, const size_t max_bytes, size_t *bytes) {
+    cjyaml_parse_stats stats = { 0, 0 };
+    cjyaml_parse_options opts = { 0 };
+    opts.flags = CJYAML_PARSE_INCLUDES;
+    opts.stats = &stats;
+    opts.include_threads = threads;
+    opts.max_bytes = max_bytes;
+    unsigned char *blob = NULL;
+    size_t size = 0;
+    const int rc = cjyaml_parse_file_opts(path, &opts, &blob, &size);
+    cjyaml_free_blob(blob);
+    *bytes = stats.bytes;
+    return rc;
+}
+
+// max_bytes is one budget for the whole parse: the included files are charged to it, whichever worker parses them
+static void test_shared_budget(const char *root) {
+    size_t total = 0;
+    CHECK(parse_counting(root, 1, 0, &total) == CJYAML_OK, "unlimited parse");
+    size_t included = 0;
+    for (int i = 0; i < INCLUDE_FILES; ++i) {
+        char path[1024];
+        size_t bytes = 0;
+        snprintf(path, sizeof(path), "%s/inc/f%d.yaml", root_dir, i);
+        CHECK(parse_counting(path, 1, 0, &bytes) == CJYAML_OK, "%s", path);
+        included += bytes;
+    }
+    CHECK(total >= included, "%zu bytes reported, the included files alone take %zu", total, included);
+
+    static const uint32_t counts[] = { 2, 8, 16 };
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i) {
+        size_t bytes = 0;
+        CHECK(parse_counting(root, counts[i], 0, &bytes) == CJYAML_OK, "%u workers", counts[i]);
+        CHECK(bytes == total, "%u workers: %zu bytes, %zu serially", counts[i], bytes, total);
+        // every file fits half the budget on its own, all of them together do not
+        CHECK(parse_counting(root, counts[i], included / 2, &bytes) == CJYAML_ELIMIT, "%u workers: budget %zu",
+              counts[i], included / 2);
+        CHECK(bytes <= included / 2, "%u workers: %zu bytes charged over a budget of %zu", counts[i], bytes,
+              included / 2);
+    }
+}
+
+// malloc with counters; called from the include workers as well, hence the atomics
+typedef struct {
+    volatile int64_t calls; // malloc and realloc calls
+    volatile int64_t live;  // blocks not freed yet
+} AllocCounts;
+
+static void *counting_malloc(void *user, const size_t size) {
+    AllocCounts *c = user;
+    void *p = malloc(size);
+    if (p) {
+        atomic_inc(&c->calls);
+        atomic_inc(&c->live);
+    }
+    return p;
+}
+
+static void *counting_realloc(void *user, void *ptr, const size_t old_size, const size_t new_size) {
+    AllocCounts *c = user;
+    (void)old_size;
+    void *p = realloc(ptr, new_size);
+    if (p) {
+        atomic_inc(&c->calls);
+        if (!ptr) atomic_inc(&c->live);
+    }
+    return p;
+}
+
+static void counting_free(void *user, void *ptr) {
+    AllocCounts *c = user;
+    if (ptr) atomic_dec(&c->live);
+    free(ptr);
+}
+
+// the parse allocator serves the included files as well, and every block goes back to it (also on failure)
+static void test_allocator(const char *root, const uint32_t threads) {
+    AllocCounts counts = { 0, 0 };
+    const cjyaml_allocator alloc = { counting_malloc, counting_realloc, counting_free, &counts };
+    cjyaml_parse_stats stats = { 0, 0 };
+    cjyaml_parse_options opts = { 0 };
+    opts.flags = CJYAML_PARSE_INCLUDES;
+    opts.stats = &stats;
+    opts.allocator = &alloc;
+    opts.include_threads = threads;
+
+    unsigned char *blob = NULL;
+    size_t size = 0;
+    CHECK(cjyaml_parse_file_opts(root, &opts, &blob, &size) == CJYAML_OK, "%u workers: parse", threads);
+    CHECK(counts.calls >= (int64_t)stats.allocations, "%u workers: %lld allocator calls for %zu allocations",
+          threads, (long long)counts.calls, stats.allocations);
+    if (blob) check_document(blob, size);
+    cjyaml_free_blob(blob);
+    CHECK(counts.live == 0, "%u workers: %lld blocks not returned", threads, (long long)counts.live);
+
+    opts.max_bytes = root_bytes(root) + 512; // runs out in the includes
+    blob = NULL;
+    CHECK(cjyaml_parse_file_opts(root, &opts, &blob, &size) == CJYAML_ELIMIT, "%u workers: budget", threads);
+    cjyaml_free_blob(blob);
+    CHECK(counts.live == 0, "%u workers: %lld blocks not returned after ELIMIT", threads, (long long)counts.live);
+}
+
+// includes are opt-in, and a buffer parse resolves them in the current directory without leaving it
+static void test_include_flag(const char *root) {
+    unsigned char *blob = NULL;
+    size_t size = 0;
+    CHECK(cjyaml_parse_file_opts(root, NULL, &blob, &size) == CJYAML_OK, "parse without options");
+    if (blob) {
+        cjyaml_blob b;
+        CHECK(cjyaml_blob_open(&b, blob, size, 0) == CJYAML_OK, "blob does not validate");
+        CHECK(text_is(&b, "f0", "inc/f0.yaml") && text_is(&b, "missing", "inc/nope.yaml"),
+              "includes resolved without CJYAML_PARSE_INCLUDES");
+        cjyaml_free_blob(blob);
+    }
+
+    char text[1024];
+    snprintf(text, sizeof(text), "k: !include %s/secret.yaml\n", root_dir);
+    for (int with_flag = 0; with_flag < 2; ++with_flag) {
+        blob = NULL;
+        CHECK(parse_text(text, with_flag ? CJYAML_PARSE_INCLUDES : 0, &blob, &size) == CJYAML_OK, "%s", text);
+        if (!blob) continue;
+        cjyaml_blob b;
+        CHECK(cjyaml_blob_open(&b, blob, size, 0) == CJYAML_OK && int_at(&b, "k.secret") == -1,
+              "absolute include resolved in a buffer parse (flag %d)", with_flag);
+        cjyaml_free_blob(blob);
+    }
+
+    if (change_dir(root_dir) != 0) {
+        CHECK(0, "cannot enter %s", root_dir);
+        return;
+    }
+    static const struct { const char *text; int resolved; } cases[] = {
+        { "k: !include secret.yaml\n", 1 },
+        { "k: !include ./inc/../secret.yaml\n", 1 },
+        { "k: !include inc/../../secret.yaml\n", 0 },
+        { "k: !include ..\n", 0 },
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        for (int with_flag = 0; with_flag < 2; ++with_flag) {
+            blob = NULL;
+            CHECK(parse_text(cases[i].text, with_flag ? CJYAML_PARSE_INCLUDES : 0, &blob, &size) == CJYAML_OK, "%s",
+                  cases[i].text);
+            if (!blob) continue;
+            cjyaml_blob b;
+            CHECK(cjyaml_blob_open(&b, blob, size, 0) == CJYAML_OK, "blob does not validate");
+            const int expected = with_flag && cases[i].resolved;
+            CHECK((int_at(&b, "k.secret") == 1) == expected, "%s (flag %d): expected %s", cases[i].text, with_flag,
+                  expected ? "resolved" : "unresolved");
+            cjyaml_free_blob(blob);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <dir>\n", argv[0]);
+        return 2;
+    }
+    root_dir = argv[1];
+    write_fixture();
+
+    char root[1024];
+    snprintf(root, sizeof(root), "%s/root.yaml", root_dir);
+    test_worker_counts(root);
+    test_budget(root, 1);
+    test_budget(root, 8); // worker 0 runs out starting its jobs while the other workers parse theirs
+    test_shared_budget(root);
+    test_allocator(root, 1);
+    test_allocator(root, 8);
+    test_include_flag(root); // changes the working directory, runs last
+
+    if (failures) fprintf(stderr, "%d check(s) failed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,146 @@
+/*
+ Quoted scalar test: double-quote escapes (\x, \u with surrogate pairs, \U, the named ones), invalid escapes and
+ lone surrogates (the value stays the plain text as written), line folding, '' in single quotes, closing quotes
+ and escapes at every offset around the 16-byte blocks of the quote scan, and deduplication of decoded text.
+ Built twice: against cjyaml_static (SSE2 scan where available) and cjyaml_static_nosimd (scalar scan).
+
+   cjyaml_quoted_test
+*/
+#include "cjyaml_test.h"
+
+#define BYTES(s) s, sizeof(s) - 1
+
+static void check_value(const char *yaml_value, const char *expected, const size_t expected_len) {
+    char text[512];
+    snprintf(text, sizeof(text), "k: %s\n", yaml_value);
+    unsigned char *blob = NULL;
+    size_t size = 0;
+    CHECK(parse_text(text, 0, &blob, &size) == CJYAML_OK, "%s", yaml_value);
+    if (!blob) return;
+    cjyaml_blob b;
+    CHECK(cjyaml_blob_open(&b, blob, size, 0) == CJYAML_OK, "%s: blob does not validate", yaml_value);
+    CHECK(text_is_n(&b, "k", expected, expected_len), "%s", yaml_value);
+    cjyaml_free_blob(blob);
+}
+
+static void test_escapes(void) {
+    static const struct { const char *yaml; const char *expected; size_t len; } cases[] = {
+        { "\"\\x41\\x7e\\x7E\"", BYTES("A~~") },
+        { "\"\\u00e9\\u20AC\"", BYTES("\xC3\xA9\xE2\x82\xAC") },
+        { "\"\\U0001F600\"", BYTES("\xF0\x9F\x98\x80") },
+        { "\"\\ud83d\\ude00\"", BYTES("\xF0\x9F\x98\x80") },          // surrogate pair
+        { "\"a\\uD83D\\uDE00b\"", BYTES("a\xF0\x9F\x98\x80" "b") },
+        { "\"\\0\\a\\b\\t\\n\\v\\f\\r\\e\\ \\\"\\/\\\\\"", BYTES("\0\a\b\t\n\v\f\r\x1b \"/\\") },
+        { "\"\\N\\_\\L\\P\"", BYTES("\xC2\x85\xC2\xA0\xE2\x80\xA8\xE2\x80\xA9") },
+        { "\"tab\\\tx\"", BYTES("tab\tx") },                           // backslash + literal tab
+        // invalid escapes: the value is the plain text as written
+        { "\"\\ud83d\"", BYTES("\"\\ud83d\"") },                       // lone high surrogate
+        { "\"\\ude00\"", BYTES("\"\\ude00\"") },                       // lone low surrogate
+        { "\"\\ud83dx\"", BYTES("\"\\ud83dx\"") },
+        { "\"\\ud83d\\u0041\"", BYTES("\"\\ud83d\\u0041\"") },         // high surrogate + non-surrogate
+        { "\"\\U00110000\"", BYTES("\"\\U00110000\"") },               // beyond U+10FFFF
+        { "\"\\x4\"", BYTES("\"\\x4\"") },
+        { "\"\\xZZ\"", BYTES("\"\\xZZ\"") },
+        { "\"\\q\"", BYTES("\"\\q\"") },
+        // single quotes: '' is a quote, backslashes are literal
+        { "'it''s'", BYTES("it's") },
+        { "''''", BYTES("'") },
+        { "''", BYTES("") },
+        { "'a\\nb'", BYTES("a\\nb") },
+        { "\"\"", BYTES("") },
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        check_value(cases[i].yaml, cases[i].expected, cases[i].len);
+    }
+}
+
+static void test_folding(void) {
+    static const struct { const char *yaml; const char *expected; size_t len; } cases[] = {
+        { "\"a\n  b\"", BYTES("a b") },             // one break: a space
+        { "\"a\n\n  b\"", BYTES("a\nb") },          // n empty lines: n line feeds
+        { "\"a\n\n\n b\"", BYTES("a\n\nb") },
+        { "\"a  \t\n  b\"", BYTES("a b") },         // trailing whitespace is trimmed
+        { "\"a\\t\n b\"", BYTES("a\t b") },         // ... but not an escaped one
+        { "\"a \\\n   b\"", BYTES("a b") },         // escaped break: joined, indentation dropped
+        { "\"a\\\n b\"", BYTES("ab") },
+        { "\"a\r\n  b\"", BYTES("a b") },
+        { "'a\n\n  b'", BYTES("a\nb") },
+        { "'a''\n b'", BYTES("a' b") },
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        check_value(cases[i].yaml, cases[i].expected, cases[i].len);
+    }
+}
+
+/*
+ A run of n plain characters, then the event the quote scan stops at (closing quote, escape, '' or line break),
+ for every n across three 16-byte blocks; the document either ends right after the closing quote (the scan's
+ tail) or continues.
+*/
+static void test_block_boundaries(void) {
+    static const char *const suffixes[] = { "", "\n", "\nz: 1\n" };
+    static const struct { char quote; const char *event; const char *decoded; } events[] = {
+        { '"', "", "" },
+        { '\'', "", "" },
+        { '"', "\\tb", "\tb" },
+        { '"', "\\u00e9", "\xC3\xA9" },
+        { '"', "\\\"", "\"" },
+        { '\'', "''b", "'b" },
+        { '"', "\n  b", " b" },
+        { '\'', "\n\n  b", "\nb" },
+    };
+    char run[64], text[160], expected[80];
+    for (size_t n = 0; n < 48; ++n) {
+        for (size_t i = 0; i < n; ++i) run[i] = (char)('a' + i % 26);
+        run[n] = '\0';
+        for (size_t e = 0; e < sizeof(events) / sizeof(events[0]); ++e) {
+            snprintf(expected, sizeof(expected), "%s%s", run, events[e].decoded);
+            for (size_t s = 0; s < sizeof(suffixes) / sizeof(suffixes[0]); ++s) {
+                snprintf(text, sizeof(text), "k: %c%s%s%c%s", events[e].quote, run, events[e].event, events[e].quote,
+                         suffixes[s]);
+                unsigned char *blob = NULL;
+                size_t size = 0;
+                CHECK(parse_text(text, 0, &blob, &size) == CJYAML_OK, "%s", text);
+                if (!blob) continue;
+                cjyaml_blob b;
+                CHECK(cjyaml_blob_open(&b, blob, size, 0) == CJYAML_OK && text_is(&b, "k", expected),
+                      "run of %zu, event %zu, suffix %zu", n, e, s);
+                if (s == 2) CHECK(int_at(&b, "z") == 1, "run of %zu, event %zu: value after the scalar", n, e);
+                cjyaml_free_blob(blob);
+            }
+        }
+    }
+}
+
+// text of the scalar at key, for comparing arena offsets
+static const char *text_at(const cjyaml_blob *b, const char *key) {
+    cjyaml_cursor c;
+    size_t len;
+    return lookup(b, key, &c) ? cjyaml_cursor_value(&c, &len) : NULL;
+}
+
+// decoded text is interned like any other: equal strings share one arena entry
+static void test_dedup(void) {
+    static const char text[] = "a: \"x\\x41y\"\nb: xAy\nc: 'xAy'\nd: \"\\u00e9t\\u00e9\"\ne: \xC3\xA9t\xC3\xA9\n"
+                               "f: \"it's\"\ng: 'it''s'\n";
+    unsigned char *blob = NULL;
+    size_t size = 0;
+    CHECK(parse_text(text, 0, &blob, &size) == CJYAML_OK, "parse");
+    if (!blob) return;
+    cjyaml_blob b;
+    CHECK(cjyaml_blob_open(&b, blob, size, 0) == CJYAML_OK, "blob does not validate");
+    CHECK(text_is(&b, "a", "xAy") && text_is(&b, "d", "\xC3\xA9t\xC3\xA9") && text_is(&b, "g", "it's"), "values");
+    CHECK(text_at(&b, "a") == text_at(&b, "b") && text_at(&b, "a") == text_at(&b, "c"), "xAy stored more than once");
+    CHECK(text_at(&b, "d") == text_at(&b, "e"), "decoded \\u text stored twice");
+    CHECK(text_at(&b, "f") == text_at(&b, "g"), "decoded '' text stored twice");
+    cjyaml_free_blob(blob);
+}
+
+int main(void) {
+    test_escapes();
+    test_folding();
+    test_block_boundaries();
+    test_dedup();
+    if (failures) fprintf(stderr, "%d check(s) failed\n", failures);
+    return failures ? 1 : 0;
+}
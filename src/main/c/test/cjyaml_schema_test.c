@@ -0,0 +1,147 @@
+/*
+ Core schema test: how plain scalars resolve and what value they decode to. Covers int64 boundaries (one past
+ them stays a string), 0o / 0x, .inf / .nan spellings, floats on the Clinger fast path and on the strtod
+ fallback (long mantissas, exponents out of range), and the fallback again under a comma-decimal LC_NUMERIC,
+ which must not change the result. The locale part is skipped when no such locale is installed; one can be
+ named on the command line.
+
+   cjyaml_schema_test [comma-decimal locale]
+*/
+#include "cjyaml_test.h"
+
+#include <locale.h>
+#include <math.h>
+
+typedef struct {
+    const char *text;
+    uint8_t flags;  // expected style_flags
+    int64_t i;      // value of SCALAR_INT / SCALAR_BOOL
+    double f;       // value of SCALAR_FLOAT (and of SCALAR_INT through cjyaml_get_f64)
+} SchemaCase;
+
+static const SchemaCase ints[] = {
+    { "0", SCALAR_INT, 0, 0 },
+    { "-0", SCALAR_INT, 0, 0 },
+    { "+12", SCALAR_INT, 12, 12 },
+    { "017", SCALAR_INT, 17, 17 },                                  // decimal, not octal
+    { "9223372036854775807", SCALAR_INT, INT64_MAX, 9223372036854775807.0 },
+    { "-9223372036854775808", SCALAR_INT, INT64_MIN, -9223372036854775808.0 },
+    { "9007199254740993", SCALAR_INT, 9007199254740993LL, 9007199254740992.0 },
+    { "0o17", SCALAR_INT, 15, 15 },
+    { "0o777777777777777777777", SCALAR_INT, INT64_MAX, 9223372036854775807.0 },
+    { "0x1F", SCALAR_INT, 31, 31 },
+    { "0xff", SCALAR_INT, 255, 255 },
+    { "0x7FFFFFFFFFFFFFFF", SCALAR_INT, INT64_MAX, 9223372036854775807.0 },
+    { "true", SCALAR_BOOL, 1, 0 },
+    { "True", SCALAR_BOOL, 1, 0 },
+    { "FALSE", SCALAR_BOOL, 0, 0 },
+};
+
+static const SchemaCase floats[] = {
+    { "1.5", SCALAR_FLOAT, 0, 1.5 },
+    { "-.5", SCALAR_FLOAT, 0, -0.5 },
+    { "1.", SCALAR_FLOAT, 0, 1.0 },
+    { "1e3", SCALAR_FLOAT, 0, 1e3 },
+    { "2.5E-3", SCALAR_FLOAT, 0, 2.5e-3 },
+    { "0.1", SCALAR_FLOAT, 0, 0.1 },
+    { "9007199254740993.5", SCALAR_FLOAT, 0, 9007199254740993.5 },  // mantissa over 2^53: strtod fallback
+    { "0.12345678901234567891", SCALAR_FLOAT, 0, 0.12345678901234567891 },
+    { "123456789012345678901234567890.5", SCALAR_FLOAT, 0, 123456789012345678901234567890.5 },
+    { "1e23", SCALAR_FLOAT, 0, 1e23 },                               // exponent past the exact powers of ten
+    { "1e400", SCALAR_FLOAT, 0, HUGE_VAL },
+    { "-1e400", SCALAR_FLOAT, 0, -HUGE_VAL },
+    { "1e-400", SCALAR_FLOAT, 0, 0.0 },
+    { ".inf", SCALAR_FLOAT, 0, HUGE_VAL },
+    { ".Inf", SCALAR_FLOAT, 0, HUGE_VAL },
+    { "+.INF", SCALAR_FLOAT, 0, HUGE_VAL },
+    { "-.inf", SCALAR_FLOAT, 0, -HUGE_VAL },
+    { ".nan", SCALAR_FLOAT, 0, NAN },
+    { ".NaN", SCALAR_FLOAT, 0, NAN },
+    { ".NAN", SCALAR_FLOAT, 0, NAN },
+};
+
+// plain scalars that look numeric but stay strings
+static const char *const strings[] = {
+    "9223372036854775808",      // INT64_MAX + 1
+    "-9223372036854775809",     // INT64_MIN - 1
+    "99999999999999999999",
+    "0o1000000000000000000000", // 2^63
+    "0x8000000000000000",
+    "0xFFFFFFFFFFFFFFFF",
+    "0o8", "0O17", "0X1F", "0x", "0o", "-0x1", "1_000", "12e", "1e+", ".", "+",
+    ".iNf", "-.nan", "+.nan", ".infinity", "tRue", "yes",
+};
+
+// parse "k: text", check the subtype of k and the decoded value
+static void check_case(const SchemaCase *c) {
+    char text[128];
+    snprintf(text, sizeof(text), "k: %s\n", c->text);
+    unsigned char *blob = NULL;
+    size_t size = 0;
+    CHECK(parse_text(text, 0, &blob, &size) == CJYAML_OK, "%s", c->text);
+    if (!blob) return;
+    cjyaml_blob b;
+    cjyaml_cursor cur;
+    if (cjyaml_blob_open(&b, blob, size, 0) != CJYAML_OK || !lookup(&b, "k", &cur)) {
+        CHECK(0, "%s: no value", c->text);
+        cjyaml_free_blob(blob);
+        return;
+    }
+    const uint8_t flags = b.nodes[cur.node].style_flags;
+    CHECK(flags == c->flags, "%s: style_flags %#x, expected %#x", c->text, flags, c->flags);
+    int64_t i = 0;
+    double f = 0;
+    const int ri = cjyaml_get_i64(b.base, b.size, cur.node, &i);
+    const int rf = cjyaml_get_f64(b.base, b.size, cur.node, &f);
+    if (c->flags == SCALAR_INT || c->flags == SCALAR_BOOL) {
+        CHECK(ri == CJYAML_OK && i == c->i, "%s: %lld, expected %lld", c->text, (long long)i, (long long)c->i);
+    } else {
+        CHECK(ri != CJYAML_OK, "%s: cjyaml_get_i64 accepted a non-integer", c->text);
+    }
+    if (c->flags == SCALAR_INT || c->flags == SCALAR_FLOAT) {
+        CHECK(rf == CJYAML_OK && (isnan(c->f) ? isnan(f) : f == c->f), "%s: %.17g, expected %.17g", c->text, f, c->f);
+    } else {
+        CHECK(rf != CJYAML_OK, "%s: cjyaml_get_f64 accepted a non-number", c->text);
+    }
+    cjyaml_free_blob(blob);
+}
+
+static void test_table(void) {
+    for (size_t i = 0; i < sizeof(ints) / sizeof(ints[0]); ++i) check_case(&ints[i]);
+    for (size_t i = 0; i < sizeof(floats) / sizeof(floats[0]); ++i) check_case(&floats[i]);
+    for (size_t i = 0; i < sizeof(strings) / sizeof(strings[0]); ++i) {
+        const SchemaCase c = { strings[i], SCALAR_STRING, 0, 0 };
+        check_case(&c);
+    }
+}
+
+// set LC_ALL to a locale whose decimal point is ','; 0 if none is installed
+static int set_comma_locale(const char *requested) {
+    static const char *const names[] = {
+        "de_DE.UTF-8", "de_DE.utf8", "fr_FR.UTF-8", "fr_FR.utf8", "ru_RU.UTF-8", "nl_NL.UTF-8", "de_DE", "fr_FR",
+        "German_Germany.1252",
+    };
+    for (size_t i = requested ? 0 : 1; i <= sizeof(names) / sizeof(names[0]); ++i) {
+        const char *name = i == 0 ? requested : names[i - 1];
+        if (setlocale(LC_ALL, name) && strcmp(localeconv()->decimal_point, ",") == 0) return 1;
+    }
+    setlocale(LC_ALL, "C");
+    return 0;
+}
+
+// the same floats with LC_NUMERIC using ',': the strtod fallback must still read '.'
+static void test_comma_locale(const char *requested) {
+    if (!set_comma_locale(requested)) {
+        fprintf(stderr, "no comma-decimal locale installed; locale checks skipped\n");
+        return;
+    }
+    for (size_t i = 0; i < sizeof(floats) / sizeof(floats[0]); ++i) check_case(&floats[i]);
+    setlocale(LC_ALL, "C");
+}
+
+int main(int argc, char **argv) {
+    test_table();
+    test_comma_locale(argc > 1 ? argv[1] : NULL);
+    if (failures) fprintf(stderr, "%d check(s) failed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,81 @@
+/*
+ Helpers shared by the native tests: a CHECK macro that counts failures instead of stopping, and lookups by
+ key path on a parsed blob.
+*/
+#ifndef CJYAML_TEST_H
+#define CJYAML_TEST_H
+
+#include "CJYaml.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                                              \
+    do {                                                              \
+        if (!(cond)) {                                                \
+            fprintf(stderr, "%s:%d: %s: ", __FILE__, __LINE__, #cond); \
+            fprintf(stderr, __VA_ARGS__);                             \
+            fputc('\n', stderr);                                      \
+            ++failures;                                               \
+        }                                                             \
+    } while (0)
+
+/*
+ Follow a dot-separated path from the root: a segment is a key in a mapping and an item number in a sequence
+ ("list.2.name"). 0 if a step is missing.
+*/
+static inline int lookup(const cjyaml_blob *b, const char *path, cjyaml_cursor *out) {
+    cjyaml_cursor c = cjyaml_cursor_root(b);
+    while (*path) {
+        const char *dot = strchr(path, '.');
+        const size_t len = dot ? (size_t)(dot - path) : strlen(path);
+        cjyaml_cursor it = c;
+        int ok;
+        if (cjyaml_cursor_type(&c) == SEQUENCE) {
+            ok = cjyaml_cursor_first_child(&c, &it);
+            for (unsigned long n = strtoul(path, NULL, 10); ok && n; --n) ok = cjyaml_cursor_next_sibling(&it);
+        } else {
+            for (ok = cjyaml_cursor_first_child(&c, &it); ok; ok = cjyaml_cursor_next_sibling(&it)) {
+                size_t klen;
+                const char *key = cjyaml_cursor_key(&it, &klen);
+                if (key && klen == len && memcmp(key, path, len) == 0) break;
+            }
+        }
+        if (!ok) return 0;
+        c = it;
+        path += len + (dot ? 1 : 0);
+    }
+    *out = c;
+    return 1;
+}
+
+// integer at path; -1 if it is missing or not an integer
+static inline int64_t int_at(const cjyaml_blob *b, const char *path) {
+    cjyaml_cursor c;
+    int64_t v = -1;
+    if (!lookup(b, path, &c) || cjyaml_get_i64(b->base, b->size, c.node, &v) != CJYAML_OK) return -1;
+    return v;
+}
+
+// scalar text at path equals expected (length-checked, so it may contain NUL bytes up to expected_len)
+static inline int text_is_n(const cjyaml_blob *b, const char *path, const char *expected, const size_t expected_len) {
+    cjyaml_cursor c;
+    size_t len;
+    const char *text = lookup(b, path, &c) ? cjyaml_cursor_value(&c, &len) : NULL;
+    return text && len == expected_len && memcmp(text, expected, len) == 0;
+}
+
+static inline int text_is(const cjyaml_blob *b, const char *path, const char *expected) {
+    return text_is_n(b, path, expected, strlen(expected));
+}
+
+static inline int parse_text(const char *text, const uint32_t flags, unsigned char **blob, size_t *size) {
+    cjyaml_parse_options opts = { 0 };
+    opts.flags = flags;
+    return cjyaml_parse_buffer_opts(text, strlen(text), &opts, blob, size);
+}
+
+#endif // CJYAML_TEST_H
@@ -0,0 +1,56 @@
+/*
+ C++ view test: key lookups through '<<' merge links. A mapping reached through several merge paths is searched
+ once per lookup, so 40 levels of "<<: [*prev, *prev]" (2^40 paths) answer a present or missing key at once.
+
+   cjyaml_view_test
+*/
+#include "CJYaml.hpp"
+
+#include <cstdio>
+#include <string>
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                                              \
+    do {                                                              \
+        if (!(cond)) {                                                \
+            std::fprintf(stderr, "%s:%d: %s: ", __FILE__, __LINE__, #cond); \
+            std::fprintf(stderr, __VA_ARGS__);                        \
+            std::fputc('\n', stderr);                                 \
+            ++failures;                                               \
+        }                                                             \
+    } while (0)
+
+static constexpr int merge_levels = 40;
+
+static void test_doubled_merge() {
+    // m0 holds the keys; mN merges m(N-1) twice and adds own_N, overriding "shadowed" at every level
+    std::string text = "m0: &m0 {base: 7, shadowed: 0}\n";
+    for (int i = 1; i <= merge_levels; ++i) {
+        const std::string n = std::to_string(i), prev = std::to_string(i - 1);
+        text += "m" + n + ": &m" + n + " {<<: [*m" + prev + ", *m" + prev + "], own_" + n + ": " + n +
+                ", shadowed: " + n + "}\n";
+    }
+    unsigned char *blob = nullptr;
+    std::size_t size = 0;
+    CHECK(cjyaml_parse_buffer_opts(text.data(), text.size(), nullptr, &blob, &size) == CJYAML_OK, "parse");
+    if (!blob) return;
+    {
+        cjyaml::View doc(blob, size);
+        const std::string name = "m" + std::to_string(merge_levels);
+        const cjyaml::Node top = doc[std::string_view(name)];
+        CHECK(top.is_map(), "m%d is not a mapping", merge_levels);
+        CHECK(top["base"].value_or<int>(-1) == 7, "key of the deepest parent");
+        CHECK(top["own_1"].value_or<int>(-1) == 1, "key of a parent");
+        CHECK(top["shadowed"].value_or<int>(-1) == merge_levels, "own pair must override the parents");
+        CHECK(!top["missing"], "missing key found");
+        CHECK(doc["m1"]["shadowed"].value_or<int>(-1) == 1, "m1.shadowed");
+    }
+    cjyaml_free_blob(blob);
+}
+
+int main() {
+    test_doubled_merge();
+    if (failures) std::fprintf(stderr, "%d check(s) failed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -6,10 +6,15 @@ import org.jetbrains.annotations.Nullable;
 import java.io.File;
 import java.io.IOException;
 import java.io.InputStream;
+import java.lang.ref.Cleaner;
 import java.nio.ByteBuffer;
 import java.nio.ByteOrder;
+import java.nio.MappedByteBuffer;
+import java.nio.channels.FileChannel;
 import java.nio.file.Files;
+import java.nio.file.Path;
 import java.nio.file.StandardCopyOption;
+import java.nio.file.StandardOpenOption;
 import java.util.HashMap;
 import java.util.Map;
 import java.util.Objects;
@@ -22,27 +27,59 @@ import java.util.Objects;
  *     Map<String, Long> header = parser.getHeaderMap();
  *     ...
  * } // native resources freed automatically
+ * Native blobs are also registered with a {@link Cleaner}, so a forgotten close()
+ * releases them once they become unreachable instead of leaking.
+ * An instance is a reusable parser: its native parse context (builder tables, string arena and hash
+ * table) is kept between parse calls and reset rather than freed, so re-parsing many small documents
+ * allocates almost nothing after the first. Instances are not thread safe; keep one per thread.
  */
 public class CJYaml implements AutoCloseable {
 
     // single native library load guard
     private static volatile boolean nativeLoaded = false;
 
+    // releases native blobs whose owner was never closed (shared by all bindings)
+    static final Cleaner CLEANER = Cleaner.create();
+
     // Instance which holds native buffers and JNI wrappers
     private NativeBlob nativeBlob = null;
 
-    // last parsed data (either direct ByteBuffer or byte[])
+    // blob magic ('Y','A','M','L' little-endian), matches CJYAML_MAGIC
+    private static final long MAGIC = 0x59414D4CL;
+    // CJYAML_ECHECKSUM: blob contents do not match its checksum table
+    private static final int STATUS_CHECKSUM = -9;
+
+    // last parsed data (direct ByteBuffer, MappedByteBuffer or byte[])
     private ByteBuffer blobByteBuffer = null;
     private byte[] blobBytes = null;
 
     // parsed header (lazy)
     private Header header = null;
+    // section bounds of the current blob (lazy, see sections())
+    private Sections sections = null;
+    // the blob came from the native parser or passed openBlob(path, true): its references need no range checks
+    private boolean trusted = false;
+
+    // traversal limits handed to the native walker (<= 0: native defaults)
+    private int maxDepth = 0;
+    private long maxNodes = 0;
+
+    // native memory budget of one parse in bytes (<= 0: unlimited)
+    private long maxBytes = 0;
+
+    // resolve !include in file parses (never in parseBytes)
+    private boolean includes = false;
+
+    // reusable native parse context (builder tables, string arena, parser scratch), created by the first parse
+    private long context = 0;
+    private Cleaner.Cleanable contextCleanable = null;
 
     /**
      * Ensure native library is loaded once per JVM.
      * Throws UnsatisfiedLinkError on failure.
+     * Package-private so the FFM binding can share the same loaded library.
      */
-    private static synchronized void ensureNativeLoaded() {
+    static synchronized void ensureNativeLoaded() {
         if (nativeLoaded) return;
 
         String osName = System.getProperty("os.name").toLowerCase();
@@ -75,9 +112,33 @@ public class CJYaml implements AutoCloseable {
         ensureNativeLoaded();
     }
 
+    /**
+     * Cap the native memory one parse may allocate (node/pair/index/value/tag tables, strings and parser scratch).
+     * The budget covers the whole parse, including the files it reads through !include.
+     * Input that needs more fails fast with an IllegalStateException instead of growing the process;
+     * a native allocation failure is reported as OutOfMemoryError. Neither terminates the JVM.
+     *
+     * @param maxBytes budget in bytes, <= 0 for unlimited (the default)
+     */
+    public void setMaxBytes(long maxBytes) {
+        this.maxBytes = maxBytes;
+    }
+
+    /**
+     * Resolve {@code !include path} nodes in {@link #parseFile(String)} and {@link #parseFileMapped(String)}.
+     * Off by default: the nodes stay the tagged path string. Only relative paths that stay inside the directory of
+     * the including file are read; {@link #parseBytes(byte[])} never reads included files.
+     *
+     * @param includes true to splice included files into the document
+     */
+    public void setIncludes(boolean includes) {
+        this.includes = includes;
+    }
+
     /**
      * Parse file and return DirectByteBuffer from native code (default).
-     * You must close this CJYaml instance (or use try-with-resources) to free native memory.
+     * Close this CJYaml instance (or use try-with-resources) to free native memory promptly;
+     * otherwise it is freed by a Cleaner once the buffer becomes unreachable.
      *
      * @param path path to file
      */
@@ -87,8 +148,9 @@ public class CJYaml implements AutoCloseable {
 
     /**
      * Parse file, optionally requesting ByteBuffer or byte[] result.
-     * If DirectByteBuffer==true: native DirectByteBuffer is returned and must be freed by native free.
-     * If DirectByteBuffer==false: native returns a byte[] (no native free required).
+     * If DirectByteBuffer==true: native DirectByteBuffer is returned; it is freed by close() or by the Cleaner.
+     * If DirectByteBuffer==false: native returns a byte[] copy (no native memory held). Only useful where
+     * direct memory is restricted - it is not needed for leak safety.
      *
      * @param path            file path
      * @param directByteBuffer whether to ask native side for DirectByteBuffer
@@ -96,19 +158,176 @@ public class CJYaml implements AutoCloseable {
     public void parseFile(String path, boolean directByteBuffer) {
         Objects.requireNonNull(path, "path must not be null");
 
-        close(); // release previous resources if any
+        releaseBlob(); // release the previous blob if any
 
         nativeBlob = new NativeBlob();
 
         if (directByteBuffer) {
-            blobByteBuffer = nativeBlob.parseToDirectByteBuffer(path);
+            blobByteBuffer = nativeBlob.parseToDirectByteBuffer(context(), path, maxBytes, includes);
             blobBytes = null;
         } else {
-            blobBytes = nativeBlob.parseToByteArray(path);
+            blobBytes = nativeBlob.parseToByteArray(context(), path, maxBytes, includes);
             blobByteBuffer = null;
         }
 
         header = null; // reset parsed header
+        trusted = true;
+    }
+
+    /**
+     * Parse YAML that is already in memory (e.g. fetched from an artifact store).
+     * Direct buffers are handed to native code by address; heap buffers are read through their
+     * backing array. The bytes between position and limit are parsed; the position is not changed.
+     * The result is a native DirectByteBuffer, released like the one from {@link #parseFile(String)}.
+     *
+     * @param yaml UTF-8 encoded YAML
+     */
+    public void parseBytes(ByteBuffer yaml) {
+        Objects.requireNonNull(yaml, "yaml must not be null");
+        if (yaml.isDirect()) {
+            parseBytes(nb -> nb.parseDirectBytes(context(), yaml, yaml.position(), yaml.remaining(), maxBytes));
+        } else if (yaml.hasArray()) {
+            parseBytes(yaml.array(), yaml.arrayOffset() + yaml.position(), yaml.remaining());
+        } else {
+            // read-only heap buffer: no accessible array, copy once
+            byte[] tmp = new byte[yaml.remaining()];
+            yaml.duplicate().get(tmp);
+            parseBytes(tmp);
+        }
+    }
+
+    /**
+     * Parse YAML bytes held in a Java array; native code copies them once (no UTF-16 String conversion).
+     *
+     * @param yaml UTF-8 encoded YAML
+     */
+    public void parseBytes(byte[] yaml) {
+        Objects.requireNonNull(yaml, "yaml must not be null");
+        parseBytes(yaml, 0, yaml.length);
+    }
+
+    /**
+     * Parse YAML bytes held in a Java array range.
+     *
+     * @param yaml   UTF-8 encoded YAML
+     * @param offset first byte
+     * @param length number of bytes
+     */
+    public void parseBytes(byte[] yaml, int offset, int length) {
+        Objects.requireNonNull(yaml, "yaml must not be null");
+        Objects.checkFromIndexSize(offset, length, yaml.length);
+        parseBytes(nb -> nb.parseByteArray(context(), yaml, offset, length, maxBytes));
+    }
+
+    private void parseBytes(java.util.function.Function<NativeBlob, ByteBuffer> parser) {
+        releaseBlob(); // release the previous blob if any
+
+        nativeBlob = new NativeBlob();
+        blobByteBuffer = parser.apply(nativeBlob);
+        blobBytes = null;
+        if (blobByteBuffer == null) {
+            releaseBlob();
+            throw new IllegalArgumentException("Failed to parse YAML bytes");
+        }
+        header = null;
+        trusted = true;
+    }
+
+    /**
+     * Parse file into a temporary blob file and memory-map it (zero-copy mode).
+     * The blob never passes through the Java heap; the temporary file is deleted as soon as it is mapped
+     * (or on JVM exit where the platform keeps mapped files locked).
+     *
+     * @param path file path
+     * @throws IOException if the blob file cannot be created or mapped
+     */
+    public void parseFileMapped(String path) throws IOException {
+        Objects.requireNonNull(path, "path must not be null");
+        Path blobFile = Files.createTempFile("cjyaml", ".blob");
+        try {
+            parseFileMapped(path, blobFile);
+        } finally {
+            try {
+                Files.deleteIfExists(blobFile); // the mapping stays valid after unlink on POSIX
+            } catch (IOException e) {
+                blobFile.toFile().deleteOnExit();
+            }
+        }
+    }
+
+    /**
+     * Parse file into a persistent blob file at blobPath and memory-map it.
+     * Other processes (or JVMs) can later map the same file with {@link #openBlob(Path)}
+     * and share its page-cache pages instead of parsing again.
+     *
+     * @param path     file path
+     * @param blobPath destination of the compiled blob (replaced atomically)
+     * @throws IOException if the file cannot be parsed or mapped
+     */
+    public void parseFileMapped(String path, Path blobPath) throws IOException {
+        Objects.requireNonNull(path, "path must not be null");
+        Objects.requireNonNull(blobPath, "blobPath must not be null");
+
+        releaseBlob(); // release the previous blob if any
+
+        long size = NativeBlob.compileToFile(path, blobPath.toAbsolutePath().toString(), maxBytes, includes);
+        if (size < 0) {
+            throw new IOException("Failed to parse " + path + " into " + blobPath);
+        }
+        openBlob(blobPath);
+        trusted = true; // written by the native parser just now
+    }
+
+    /**
+     * Memory-map an already compiled blob file (read-only, no copy).
+     *
+     * @param blobPath compiled blob file
+     * @throws IOException if the file cannot be mapped or is not a CJYaml blob
+     */
+    public void openBlob(Path blobPath) throws IOException {
+        openBlob(blobPath, false);
+    }
+
+    /**
+     * Memory-map an already compiled blob file and optionally check it before use.
+     * With verify, the section checksums written by {@link #parseFileMapped(String, Path)} are recomputed
+     * (one pass over the file) and every node, pair, index and string reference is bounds-checked once,
+     * so a truncated, corrupted or foreign blob is rejected here instead of failing on a later read.
+     *
+     * @param blobPath compiled blob file
+     * @param verify   check checksums (when present) and structure
+     * @throws IOException if the file cannot be mapped, is not a CJYaml blob or fails verification
+     */
+    public void openBlob(Path blobPath, boolean verify) throws IOException {
+        Objects.requireNonNull(blobPath, "blobPath must not be null");
+
+        releaseBlob(); // release the previous blob if any
+
+        MappedByteBuffer mapped;
+        try (FileChannel ch = FileChannel.open(blobPath, StandardOpenOption.READ)) {
+            long size = ch.size();
+            if (size > Integer.MAX_VALUE) {
+                throw new IOException("Blob larger than 2 GB cannot be mapped as a ByteBuffer: " + blobPath);
+            }
+            mapped = ch.map(FileChannel.MapMode.READ_ONLY, 0, size);
+        }
+        if (mapped.capacity() < Header.HEADER_SIZE
+                || Integer.toUnsignedLong(mapped.order(ByteOrder.LITTLE_ENDIAN).getInt(0)) != MAGIC) {
+            throw new IOException("Not a CJYaml blob: " + blobPath);
+        }
+        if (verify) {
+            int status = NativeBlob.verifyDirect(mapped);
+            if (status == STATUS_CHECKSUM) {
+                throw new IOException("Blob checksum mismatch: " + blobPath);
+            } else if (status != 0) {
+                throw new IOException("Malformed CJYaml blob: " + blobPath);
+            }
+        }
+
+        blobByteBuffer = mapped; // unmapped by the GC; nothing to free natively
+        blobBytes = null;
+        header = null;
+        trusted = verify;
     }
 
     /**
@@ -154,6 +373,12 @@ public class CJYaml implements AutoCloseable {
         h.string_table_offset = buf.getLong();
         h.string_table_size = buf.getLong();
 
+        h.value_table_offset = buf.getLong();
+        h.value_count = buf.getLong();
+
+        h.tag_table_offset = buf.getLong();
+        h.tag_count = buf.getLong();
+
         header = h;
         return header;
     }
@@ -169,11 +394,35 @@ public class CJYaml implements AutoCloseable {
         return h.toMap();
     }
 
+    // native context of this instance, created on first use
+    private long context() {
+        if (context == 0) {
+            long handle = NativeBlob.contextNew();
+            contextCleanable = CLEANER.register(this, new NativeBlob.ContextReleaser(handle)); // must not capture 'this'
+            context = handle;
+        }
+        return context;
+    }
+
     /**
-     * Free native resources (if any). Safe to call multiple times.
+     * Free native resources (if any): the parsed blob and the parse context kept for reuse.
+     * The instance can still be used afterwards; the next parse creates a new context. Safe to call multiple times.
      */
     @Override
     public void close() {
+        try {
+            releaseBlob();
+        } finally {
+            if (contextCleanable != null) {
+                contextCleanable.clean();
+                contextCleanable = null;
+            }
+            context = 0;
+        }
+    }
+
+    // free the parsed blob but keep the parse context for the next parse
+    private void releaseBlob() {
         // free native direct buffer inside nativeBlob (if present)
         if (nativeBlob != null) {
             try {
@@ -188,14 +437,16 @@ public class CJYaml implements AutoCloseable {
         blobByteBuffer = null;
         blobBytes = null;
         header = null;
+        sections = null;
+        trusted = false;
     }
 
     // -----------------------------
     // Header typed representation
     // -----------------------------
     public static final class Header {
-        // matches C packed HeaderBlob (90 bytes)
-        public static final int HEADER_SIZE = 90;
+        // matches C packed HeaderBlob (122 bytes)
+        public static final int HEADER_SIZE = 122;
 
         public long magic;               // uint32 -> stored in long
         public int version;              // uint16 -> stored in int
@@ -216,6 +467,12 @@ public class CJYaml implements AutoCloseable {
         public long string_table_offset;
         public long string_table_size;
 
+        public long value_table_offset;  // 0 if the blob has no typed scalars
+        public long value_count;         // node_count or 0
+
+        public long tag_table_offset;    // 0 if no node is tagged
+        public long tag_count;           // distinct tags
+
         public @NotNull Map<String, Long> toMap() {
             Map<String, Long> m = new HashMap<>();
             m.put("magic", magic);
@@ -237,6 +494,12 @@ public class CJYaml implements AutoCloseable {
             m.put("string_table_offset", string_table_offset);
             m.put("string_table_size", string_table_size);
 
+            m.put("value_table_offset", value_table_offset);
+            m.put("value_count", value_count);
+
+            m.put("tag_table_offset", tag_table_offset);
+            m.put("tag_count", tag_count);
+
             return m;
         }
     }
@@ -247,6 +510,18 @@ public class CJYaml implements AutoCloseable {
     private static final int NODE_ENTRY_SIZE = 20; // packed: 1 + 1 + 2 + 8 + 8
     private static final int PAIR_ENTRY_SIZE = 8;  // two uint32
     private static final int INDEX_ENTRY_SIZE = 4; // uint32
+    private static final int HASH_ENTRY_SIZE = 16; // uint64 hash + uint32 pair index + uint32 reserved
+    private static final int VALUE_ENTRY_SIZE = 8; // uint64
+    private static final int TAG_ENTRY_SIZE = 24;  // uint64 name offset + uint32 name length + uint32 node count + uint64 first node
+
+    // SCALAR subtype (style_flags bits 0-1)
+    private static final int SCALAR_TYPE_MASK = 0x3;
+    private static final int SCALAR_INT = 0x1;
+    private static final int SCALAR_FLOAT = 0x2;
+    private static final int SCALAR_BOOL = 0x3;
+    private static final int SCALAR_NULL = 0x8;   // style_flags bit 3
+    // MAPPING flag: first pair is a '<<' merge link to the parent mapping(s)
+    private static final int MAPPING_MERGE = 0x1;
 
     // small POJO for NodeEntry
     private static final class NodeEntry {
@@ -262,34 +537,82 @@ public class CJYaml implements AutoCloseable {
         long value_node_index; // uint32
     }
 
-    // get a duplicated LE-ordered buffer for absolute reads
-    private @NotNull ByteBuffer blobBuf() {
-        if (blobByteBuffer != null) {
-            return blobByteBuffer.duplicate().order(ByteOrder.LITTLE_ENDIAN);
-        } else if (blobBytes != null) {
-            return ByteBuffer.wrap(blobBytes).order(ByteOrder.LITTLE_ENDIAN);
-        } else {
-            throw new IllegalStateException("No blob loaded");
+    /*
+     * Section bounds of the loaded blob, read from the header once. Every reader shares one LE-ordered
+     * buffer (absolute reads only, so no per-read duplicate). For a trusted blob the native parser or
+     * cjyaml_validate already guaranteed that every node, pair, index, value and string reference stays
+     * inside its section, so the readers skip their range checks and only check indexes passed in by callers.
+     */
+    private static final class Sections {
+        final ByteBuffer buf;
+        final boolean trusted;
+        final long nodeBase, nodeCount;
+        final long pairBase, pairCount;
+        final long indexBase, indexCount;
+        final long valueBase, valueCount;
+        final long stringBase, stringSize;
+        final long tagBase, tagCount;
+
+        Sections(ByteBuffer buf, Header h, boolean trusted) {
+            this.buf = buf;
+            this.trusted = trusted;
+            nodeBase = h.node_table_offset;
+            nodeCount = h.node_count;
+            pairBase = h.pair_table_offset;
+            pairCount = h.pair_count;
+            indexBase = h.index_table_offset;
+            indexCount = h.index_count;
+            valueBase = h.value_table_offset;
+            valueCount = h.value_count;
+            stringBase = h.string_table_offset;
+            stringSize = h.string_table_size;
+            tagBase = h.tag_table_offset;
+            tagCount = h.tag_count;
+        }
+
+        // untrusted blobs: does [abs, abs + size) lie inside the buffer
+        boolean fits(long abs, long size) {
+            return trusted || (abs >= 0 && size >= 0 && abs + size <= buf.capacity());
+        }
+
+        // absolute position of tag entry t (0-based), or -1 if the entry does not lie inside the buffer
+        long tagEntry(long t) {
+            if (t < 0 || t >= tagCount) return -1;
+            if (!trusted && tagCount > buf.capacity() / TAG_ENTRY_SIZE) return -1;
+            long abs = tagBase + t * TAG_ENTRY_SIZE;
+            return fits(abs, TAG_ENTRY_SIZE) ? abs : -1;
         }
     }
 
-    // read a NodeEntry by index
-    @org.jetbrains.annotations.Nullable
-    private NodeEntry readNode(int nodeIndex) {
+    private @Nullable Sections sections() {
+        if (sections != null) return sections;
         Header h = getHeader();
         if (h == null) return null;
-        long nodeTableOffset = h.node_table_offset;
-        long nodeCount = h.node_count;
-        if (nodeIndex < 0 || ((long)nodeIndex) >= nodeCount) return null;
+        ByteBuffer buf = blobByteBuffer != null
+                ? blobByteBuffer.duplicate().order(ByteOrder.LITTLE_ENDIAN)
+                : ByteBuffer.wrap(blobBytes).order(ByteOrder.LITTLE_ENDIAN);
+        sections = new Sections(buf, h, trusted);
+        return sections;
+    }
 
-        long abs = nodeTableOffset + ((long)nodeIndex) * NODE_ENTRY_SIZE;
-        ByteBuffer buf = blobBuf();
+    // LE-ordered buffer for absolute reads
+    private @NotNull ByteBuffer blobBuf() {
+        Sections s = sections();
+        if (s == null) throw new IllegalStateException("No blob loaded");
+        return s.buf;
+    }
+
+    // read a NodeEntry by index
+    @org.jetbrains.annotations.Nullable
+    private NodeEntry readNode(int nodeIndex) {
+        Sections s = sections();
+        if (s == null || nodeIndex < 0 || ((long) nodeIndex) >= s.nodeCount) return null;
 
-        // bounds checks (simple)
-        if (abs < 0 || abs + NODE_ENTRY_SIZE > buf.capacity()) return null;
+        long abs = s.nodeBase + ((long) nodeIndex) * NODE_ENTRY_SIZE;
+        if (!s.fits(abs, NODE_ENTRY_SIZE)) return null;
 
+        ByteBuffer buf = s.buf;
         NodeEntry n = new NodeEntry();
-        // ByteBuffer absolute reads require int index; check capacity first
         int pos = (int) abs;
         n.node_type = Byte.toUnsignedInt(buf.get(pos));
         n.style_flags = Byte.toUnsignedInt(buf.get(pos + 1));
@@ -301,55 +624,246 @@ public class CJYaml implements AutoCloseable {
 
     // read PairEntry by index
     private @Nullable PairEntry readPair(int pairIndex) {
-        Header h = getHeader();
-        if (h == null) return null;
-        long pairTableOffset = h.pair_table_offset;
-        long pairCount = h.pair_count;
-        if (pairIndex < 0 || ((long)pairIndex) >= pairCount) return null;
+        Sections s = sections();
+        if (s == null || pairIndex < 0 || ((long) pairIndex) >= s.pairCount) return null;
 
-        long abs = pairTableOffset + ((long)pairIndex) * PAIR_ENTRY_SIZE;
-        ByteBuffer buf = blobBuf();
-        if (abs < 0 || abs + PAIR_ENTRY_SIZE > buf.capacity()) return null;
+        long abs = s.pairBase + ((long) pairIndex) * PAIR_ENTRY_SIZE;
+        if (!s.fits(abs, PAIR_ENTRY_SIZE)) return null;
 
         PairEntry p = new PairEntry();
         int pos = (int) abs;
         // pair entries are two uint32 little-endian
-        p.key_node_index = Integer.toUnsignedLong(buf.getInt(pos));
-        p.value_node_index = Integer.toUnsignedLong(buf.getInt(pos + 4));
+        p.key_node_index = Integer.toUnsignedLong(s.buf.getInt(pos));
+        p.value_node_index = Integer.toUnsignedLong(s.buf.getInt(pos + 4));
         return p;
     }
 
     // read an uint32 index from index table at element idxPos
-    private long readIndexTableEntry(long indexTableBase, int idxPos) {
-        long abs = indexTableBase + ((long)idxPos) * INDEX_ENTRY_SIZE;
-        ByteBuffer buf = blobBuf();
-        if (abs < 0 || abs + INDEX_ENTRY_SIZE > buf.capacity()) throw new IndexOutOfBoundsException("index table out of range");
-        return Integer.toUnsignedLong(buf.getInt((int) abs));
+    private long readIndexTableEntry(int idxPos) {
+        Sections s = sections();
+        if (s == null) throw new IllegalStateException("No blob loaded");
+        long abs = s.indexBase + ((long) idxPos) * INDEX_ENTRY_SIZE;
+        if (!s.fits(abs, INDEX_ENTRY_SIZE)) throw new IndexOutOfBoundsException("index table out of range");
+        return Integer.toUnsignedLong(s.buf.getInt((int) abs));
     }
 
 
     // read UTF-8 string from string_table: offset = offset into string table, len = length in bytes
     private @Nullable String readString(long strOffset, long len) {
+        Sections s = sections();
+        if (s == null) return null;
+        if (!s.trusted && (strOffset < 0 || len < 0 || strOffset + len > s.stringSize)) return null;
+
+        long abs = s.stringBase + strOffset;
+        if (!s.fits(abs, len)) return null;
+
+        int pos = (int) abs;
+        ByteBuffer buf = s.buf;
+        if (buf.hasArray()) {
+            return new String(buf.array(), buf.arrayOffset() + pos, (int) len, java.nio.charset.StandardCharsets.UTF_8);
+        }
+        byte[] tmp = new byte[(int) len];
+        buf.duplicate().position(pos).get(tmp); // no absolute bulk get before Java 13
+        return new String(tmp, java.nio.charset.StandardCharsets.UTF_8);
+    }
+
+    // read the value-table slot of a node (decoded at build time by the native parser)
+    private long readValue(int nodeIndex) {
+        Sections s = sections();
+        if (s == null || s.valueCount == 0 || nodeIndex < 0 || nodeIndex >= s.valueCount) {
+            throw new IllegalStateException("blob has no value for node " + nodeIndex);
+        }
+        long abs = s.valueBase + ((long) nodeIndex) * VALUE_ENTRY_SIZE;
+        if (!s.fits(abs, VALUE_ENTRY_SIZE)) throw new IndexOutOfBoundsException("value table out of range");
+        return s.buf.getLong((int) abs);
+    }
+
+    /**
+     * Return the index of the document's root node (the node referenced by DOCUMENT), or -1 if no blob is loaded.
+     */
+    public int getRootNodeIndex() {
         Header h = getHeader();
-        if (h == null) return null;
-        long base = h.string_table_offset;
-        long stSize = h.string_table_size;
-        if (strOffset < 0 || len < 0 || strOffset + len > stSize) return null;
+        if (h == null) return -1;
+        // the DOCUMENT node is written last; search backwards
+        for (int i = (int) h.node_count - 1; i >= 0; --i) {
+            NodeEntry ne = readNode(i);
+            if (ne != null && ne.node_type == 4) return (int) ne.a;
+        }
+        return 0;
+    }
+
+    /**
+     * Find the value node of key in a MAPPING node using the blob's hash index.
+     *
+     * @param mappingNodeIndex index of a MAPPING node (e.g. {@link #getRootNodeIndex()})
+     * @param key              key to look up
+     * @return value node index, or -1 if the key is not present
+     */
+    public int findChild(int mappingNodeIndex, @NotNull String key) {
+        Objects.requireNonNull(key, "key must not be null");
+        byte[] keyBytes = key.getBytes(java.nio.charset.StandardCharsets.UTF_8);
+        return findChild(resolveAlias(mappingNodeIndex), key, fnv1a64(keyBytes), 0, new java.util.BitSet());
+    }
 
+    // own pairs first (hash index), then fall through to the merged parent mapping(s). A mapping reached again
+    // through another merge link (<<: [*a, *a], or diamonds) has already been searched without a match, so each
+    // one is visited at most once per lookup instead of once per path to it.
+    private int findChild(int mappingNodeIndex, String key, long hash, int depth, java.util.BitSet visited) {
+        if (depth > 64) throw new IllegalStateException("merge chain too deep");
+        if (mappingNodeIndex < 0 || visited.get(mappingNodeIndex)) return -1;
+        visited.set(mappingNodeIndex);
+        NodeEntry map = readNode(mappingNodeIndex);
+        if (map == null || map.node_type != 2) return -1;
+        boolean merged = (map.style_flags & MAPPING_MERGE) != 0 && map.b > 0;
+        long ownFirst = merged ? map.a + 1 : map.a;
+        Header h = getHeader();
         ByteBuffer buf = blobBuf();
-        long abs = base + strOffset;
-        if (abs < 0 || abs + len > buf.capacity()) return null;
 
-        byte[] tmp = new byte[(int) len];
+        // lower bound over entries sorted by (unsigned key_hash, pair_index)
+        long lo = 0, hi = h.hash_index_size;
+        while (lo < hi) {
+            long mid = (lo + hi) >>> 1;
+            long midHash = buf.getLong((int) (h.hash_index_offset + mid * HASH_ENTRY_SIZE));
+            if (Long.compareUnsigned(midHash, hash) < 0) lo = mid + 1; else hi = mid;
+        }
+        for (long e = lo; e < h.hash_index_size; ++e) {
+            int pos = (int) (h.hash_index_offset + e * HASH_ENTRY_SIZE);
+            if (buf.getLong(pos) != hash) break;
+            long pairIndex = Integer.toUnsignedLong(buf.getInt(pos + 8));
+            if (pairIndex < ownFirst || pairIndex >= map.a + map.b) continue;
+            PairEntry p = readPair((int) pairIndex);
+            if (p == null) continue;
+            NodeEntry k = readNode((int) p.key_node_index);
+            if (k != null && k.node_type == 0 && key.equals(readString(k.a, k.b))) {
+                return (int) p.value_node_index;
+            }
+        }
+        if (!merged) return -1;
+
+        PairEntry link = readPair((int) map.a);
+        if (link == null) return -1;
+        int parent = resolveAlias((int) link.value_node_index);
+        NodeEntry pn = readNode(parent);
+        if (pn != null && pn.node_type == 1) { // sequence of parents: earlier ones win
+            for (int i = 0; i < (int) pn.b; ++i) {
+                int item = resolveAlias((int) readIndexTableEntry((int) (pn.a + i)));
+                int found = findChild(item, key, hash, depth + 1, visited);
+                if (found >= 0) return found;
+            }
+            return -1;
+        }
+        return findChild(parent, key, hash, depth + 1, visited);
+    }
+
+    /**
+     * Return an integer (or boolean as 0/1) scalar decoded at parse time - no string parsing.
+     *
+     * @param nodeIndex scalar node index
+     * @throws IllegalArgumentException if the node is not an int/bool scalar
+     */
+    public long getLong(int nodeIndex) {
+        nodeIndex = resolveAlias(nodeIndex);
+        NodeEntry n = readNode(nodeIndex);
+        int subtype = n == null ? -1 : n.style_flags & SCALAR_TYPE_MASK;
+        if (n == null || n.node_type != 0 || (subtype != SCALAR_INT && subtype != SCALAR_BOOL)) {
+            throw new IllegalArgumentException("node " + nodeIndex + " is not an integer scalar");
+        }
+        return readValue(nodeIndex);
+    }
+
+    /**
+     * Return a float (or integer) scalar decoded at parse time - no Double.parseDouble.
+     *
+     * @param nodeIndex scalar node index
+     * @throws IllegalArgumentException if the node is not a float/int scalar
+     */
+    public double getDouble(int nodeIndex) {
+        nodeIndex = resolveAlias(nodeIndex);
+        NodeEntry n = readNode(nodeIndex);
+        int subtype = n == null ? -1 : n.style_flags & SCALAR_TYPE_MASK;
+        if (n == null || n.node_type != 0) {
+            throw new IllegalArgumentException("node " + nodeIndex + " is not a numeric scalar");
+        }
+        if (subtype == SCALAR_FLOAT) return Double.longBitsToDouble(readValue(nodeIndex));
+        if (subtype == SCALAR_INT) return (double) readValue(nodeIndex);
+        throw new IllegalArgumentException("node " + nodeIndex + " is not a numeric scalar");
+    }
+
+    /**
+     * Return the explicit tag of a node as written in the YAML (e.g. "!secret", "!!str"), or null if it has none.
+     *
+     * @param nodeIndex node index
+     */
+    public @Nullable String getTag(int nodeIndex) {
+        NodeEntry n = readNode(nodeIndex);
+        Sections s = sections();
+        if (n == null || n.tag_index == 0 || s == null) return null;
+        long abs = s.tagEntry(n.tag_index - 1L);
+        if (abs < 0) return null;
         int pos = (int) abs;
-        buf.position(pos);
-        buf.get(tmp);
-        return new String(tmp, java.nio.charset.StandardCharsets.UTF_8);
+        return readString(s.buf.getLong(pos), Integer.toUnsignedLong(s.buf.getInt(pos + 8)));
+    }
+
+    /**
+     * Return the indexes of all nodes carrying a tag, in document order, read in one pass from the blob's tag
+     * table (e.g. to resolve every "!secret" value).
+     *
+     * @param tag tag as written in the YAML, e.g. "!secret"
+     * @return node indexes; empty if no node has the tag
+     */
+    public int @NotNull [] findNodesByTag(@NotNull String tag) {
+        Objects.requireNonNull(tag, "tag must not be null");
+        Sections s = sections();
+        if (s == null || s.tagCount == 0) return new int[0];
+        ByteBuffer buf = s.buf;
+        for (long t = 0; t < s.tagCount; ++t) {
+            long abs = s.tagEntry(t);
+            if (abs < 0) return new int[0];
+            int pos = (int) abs;
+            if (!tag.equals(readString(buf.getLong(pos), Integer.toUnsignedLong(buf.getInt(pos + 8))))) continue;
+            // untrusted blobs: the node list (after the entries, `first` indexes into it) must lie inside the buffer
+            long count = Integer.toUnsignedLong(buf.getInt(pos + 12));
+            long first = buf.getLong(pos + 16);
+            if (!s.trusted && (first < 0 || first > buf.capacity() / INDEX_ENTRY_SIZE)) return new int[0];
+            long list = s.tagBase + s.tagCount * TAG_ENTRY_SIZE + first * INDEX_ENTRY_SIZE;
+            if (count > Integer.MAX_VALUE || !s.fits(list, count * INDEX_ENTRY_SIZE)) return new int[0];
+            int[] nodes = new int[(int) count];
+            for (int i = 0; i < count; ++i) {
+                nodes[i] = buf.getInt((int) (list + (long) i * INDEX_ENTRY_SIZE));
+            }
+            return nodes;
+        }
+        return new int[0];
+    }
+
+    /**
+     * Follow ALIAS nodes (*name) to the anchored node. Other nodes are returned unchanged.
+     *
+     * @param nodeIndex node index
+     * @return index of the first non-alias node
+     */
+    public int resolveAlias(int nodeIndex) {
+        for (int hops = 0; hops <= 64; ++hops) {
+            NodeEntry n = readNode(nodeIndex);
+            if (n == null || n.node_type != 3) return nodeIndex;
+            nodeIndex = (int) n.a;
+        }
+        throw new IllegalStateException("alias chain too long at node " + nodeIndex);
+    }
+
+    // FNV-1a 64-bit, same function the native builder uses for the hash index
+    private static long fnv1a64(byte[] data) {
+        long h = 0xcbf29ce484222325L;
+        for (byte b : data) {
+            h ^= (b & 0xff);
+            h *= 0x100000001b3L;
+        }
+        return h;
     }
 
     /**
      * Parse the document root and return a Java object representation:
-     * - SCALAR -> String
+     * - SCALAR -> String (null for core-schema nulls: null, ~, empty)
      * - SEQUENCE -> java.util.List<Object>
      * - MAPPING -> java.util.Map<String,Object>  (keys are scalar strings)
      * - DOCUMENT -> returns root node's value
@@ -358,107 +872,261 @@ public class CJYaml implements AutoCloseable {
         Header h = getHeader();
         if (h == null) return null;
 
-        // find DOCUMENT node in node table (node_type == 4), take its 'a' as root node index
-        for (int i = 0; i < (int) h.node_count; ++i) {
-            NodeEntry ne = readNode(i);
-            if (ne != null && ne.node_type == 4) { // DOCUMENT
-                int rootIndex = (int) ne.a; // a = root_node_index
-                return parseNode(rootIndex, 0);
-            }
-        }
-        // fallback: assume node 0 is root
-        return parseNode(0, 0);
+        // DOCUMENT node's 'a' is the root node index (node 0 if there is none)
+        return parseNode(getRootNodeIndex());
     }
 
-    // recursive parse node -> Object
-    private @Nullable Object parseNode(int nodeIndex, int depth) {
-        // avoid infinite recursion
-        if (depth > 1024) throw new IllegalStateException("max depth exceeded");
-
-        NodeEntry n = readNode(nodeIndex);
-        if (n == null) return null;
-        switch (n.node_type) {
-            case 0: // SCALAR
-                // a = offset into string table, b = length
+    /**
+     * Convert a single node (and its children) to Java objects, with the same mapping as {@link #parseRoot()}.
+     *
+     * @param nodeIndex node index, e.g. from {@link #findChild(int, String)} or {@link #findNodesByTag(String)}
+     * @throws IllegalStateException if the walk exceeds the traversal limits (see {@link #setTraversalLimits(int, long)})
+     */
+    public @Nullable Object parseNode(int nodeIndex) {
+        if (getHeader() == null) return null;
+        return materialize(walk(nodeIndex), new NodeSource() {
+            @Override
+            public @Nullable Object scalar(int node) {
+                NodeEntry n = readNode(node);
+                // core-schema null (null, ~, empty) -> Java null
+                if (n == null || (n.style_flags & SCALAR_NULL) != 0) return null;
                 return readString(n.a, n.b);
-            case 1: { // SEQUENCE
-                // a = first_index_into_index_table, b = element_count
-                Header h = getHeader();
-                int count = (int) n.b;
-                long baseIdx = h.index_table_offset;
-                java.util.List<Object> list = new java.util.ArrayList<>(Math.max(0, count));
-                for (int i = 0; i < count; ++i) {
-                    int elemNodeIdx = (int) readIndexTableEntry(baseIdx, (int) (n.a + i));
-                    list.add(parseNode(elemNodeIdx, depth + 1));
-                }
-                return list;
             }
-            case 2: { // MAPPING
-                // a = first_pair_index_in_pair_table, b = pair_count
-                int pairCount = (int) n.b;
-                java.util.Map<String, Object> map = new java.util.LinkedHashMap<>();
-                for (int i = 0; i < pairCount; ++i) {
-                    PairEntry p = readPair((int) (n.a + i));
-                    if (p == null) continue;
-                    // keys are nodes; expect scalar
-                    Object keyObj = parseNode((int) p.key_node_index, depth + 1);
-                    String key = (keyObj instanceof String) ? (String) keyObj : String.valueOf(keyObj);
-                    Object val = parseNode((int) p.value_node_index, depth + 1);
-                    map.put(key, val);
-                }
-                return map;
+
+            @Override
+            public boolean isMergeMapping(int node) {
+                NodeEntry n = readNode(node);
+                return n != null && (n.style_flags & MAPPING_MERGE) != 0;
             }
-            case 3: { // ALIAS
-                int target = (int) n.a;
-                return parseNode(target, depth + 1);
+        });
+    }
+
+    /**
+     * Limit the native traversal used by {@link #parseRoot()} and {@link #parseNode(int)}.
+     * Aliased subtrees are expanded at every use, so maxNodes (nodes visited, re-expansions included)
+     * is what stops alias bombs; maxDepth bounds nesting. Values <= 0 select the native defaults
+     * (depth 1024, node_count + 1M nodes).
+     */
+    public void setTraversalLimits(int maxDepth, long maxNodes) {
+        this.maxDepth = maxDepth;
+        this.maxNodes = maxNodes;
+    }
+
+    // native depth-first walk of the subtree: (event, node) pairs
+    private int @NotNull [] walk(int nodeIndex) {
+        int[] events = blobByteBuffer != null
+                ? NativeBlob.walkDirect(blobByteBuffer, nodeIndex, maxDepth, maxNodes)
+                : NativeBlob.walkArray(blobBytes, nodeIndex, maxDepth, maxNodes);
+        if (events == null) throw new IllegalStateException("Failed to traverse node " + nodeIndex);
+        return events;
+    }
+
+    // events of cjyaml_walk (CJYAML_WALK_*)
+    static final int WALK_SCALAR = 0;
+    static final int WALK_SEQUENCE = 1;
+    static final int WALK_MAPPING = 2;
+    static final int WALK_END = 3;
+
+    /** Node reads needed to turn walk events into Java objects; implemented by both bindings. */
+    interface NodeSource {
+        @Nullable Object scalar(int nodeIndex);
+
+        boolean isMergeMapping(int nodeIndex);
+    }
+
+    // an open SEQUENCE or MAPPING while materializing
+    private static final class Frame {
+        final java.util.List<Object> list;
+        final java.util.Map<String, Object> map;
+        boolean mergePending;  // next value is the '<<' link of a MAPPING_MERGE mapping
+        String key;
+        boolean haveKey;
+
+        Frame(java.util.List<Object> list, java.util.Map<String, Object> map, boolean merge) {
+            this.list = list;
+            this.map = map;
+            this.mergePending = merge;
+        }
+
+        void add(@Nullable Object value) {
+            if (list != null) {
+                list.add(value);
+            } else if (!haveKey) {
+                key = (value instanceof String) ? (String) value : String.valueOf(value);
+                haveKey = true;
+            } else {
+                // merge link: the parent mapping(s) first, own pairs override them
+                if (mergePending) mergeInto(map, value);
+                else map.put(key, value);
+                mergePending = false;
+                haveKey = false;
             }
-            case 4: { // DOCUMENT
-                int root = (int) n.a;
-                return parseNode(root, depth + 1);
+        }
+    }
+
+    /**
+     * Build Java objects from the events of a native walk without recursion
+     * (depth and alias expansion were already bounded by the walker).
+     */
+    static @Nullable Object materialize(int @NotNull [] events, @NotNull NodeSource source) {
+        java.util.ArrayDeque<Frame> stack = new java.util.ArrayDeque<>();
+        Object result = null;
+        for (int i = 0; i + 1 < events.length; i += 2) {
+            int node = events[i + 1];
+            Object value;
+            switch (events[i]) {
+                case WALK_SCALAR:
+                    value = source.scalar(node);
+                    break;
+                case WALK_SEQUENCE:
+                    stack.push(new Frame(new java.util.ArrayList<>(), null, false));
+                    continue;
+                case WALK_MAPPING:
+                    stack.push(new Frame(null, new java.util.LinkedHashMap<>(), source.isMergeMapping(node)));
+                    continue;
+                case WALK_END: {
+                    Frame f = stack.pop();
+                    value = f.list != null ? f.list : f.map;
+                    break;
+                }
+                default:
+                    throw new IllegalStateException("unknown walk event " + events[i]);
             }
-            default:
-                return null;
+            if (stack.isEmpty()) result = value;
+            else stack.peek().add(value);
         }
+        return result;
     }
 
 
+    /**
+     * Apply a '<<' merge value to a mapping under construction: a Map is copied in, a List of Maps is
+     * applied last-to-first so that earlier parents win. The caller puts the mapping's own pairs
+     * afterwards, so they override the merged ones.
+     */
+    @SuppressWarnings("unchecked")
+    static void mergeInto(java.util.Map<String, Object> map, @Nullable Object parent) {
+        if (parent instanceof java.util.Map) {
+            map.putAll((java.util.Map<String, Object>) parent);
+        } else if (parent instanceof java.util.List) {
+            java.util.List<Object> parents = (java.util.List<Object>) parent;
+            for (int i = parents.size() - 1; i >= 0; --i) {
+                if (parents.get(i) instanceof java.util.Map) map.putAll((java.util.Map<String, Object>) parents.get(i));
+            }
+        }
+    }
+
     // -----------------------------
     // Native wrapper (static nested)
     // -----------------------------
     private static final class NativeBlob implements AutoCloseable {
         // Only one buffer is tracked per NativeBlob instance (the DirectByteBuffer returned from native).
         private ByteBuffer directBuffer = null;
+        // Cleaner registration for directBuffer: runs on close() or once the buffer becomes unreachable
+        private Cleaner.Cleanable cleanable = null;
 
         private NativeBlob() {
             // constructor left intentionally lightweight; native lib already loaded in outer class
         }
 
         // JNI declarations - private native methods implemented in your native lib.
-        private native ByteBuffer NativeLib_parseToDirectByteBuffer(String path);
-        private native byte[] NativeLib_parseToByteArray(String path);
-        private native void NativeLib_freeBlob(ByteBuffer buffer);
+        // maxBytes: native memory budget of the parse, <= 0 unlimited; includes: resolve !include (file parses only)
+        // context: handle from NativeLib_contextNew reused across parses (0: fresh builder per parse)
+        private static native long NativeLib_contextNew();
+        private static native void NativeLib_contextFree(long context);
+        private static native ByteBuffer NativeLib_parseToDirectByteBuffer(long context, String path, long maxBytes, boolean includes);
+        private static native byte[] NativeLib_parseToByteArray(long context, String path, long maxBytes, boolean includes);
+        private static native long NativeLib_compileToFile(String path, String blobPath, long maxBytes, boolean includes);
+        private static native ByteBuffer NativeLib_parseDirectBytes(long context, ByteBuffer src, int offset, int length, long maxBytes);
+        private static native ByteBuffer NativeLib_parseByteArray(long context, byte[] src, int offset, int length, long maxBytes);
+        private static native long NativeLib_blobAddress(ByteBuffer buffer);
+        private static native void NativeLib_freeBlob(long address);
+        private static native int[] NativeLib_walkDirect(ByteBuffer blob, int root, int maxDepth, long maxNodes);
+        private static native int[] NativeLib_walkArray(byte[] blob, int root, int maxDepth, long maxNodes);
+        private static native int NativeLib_verifyDirect(ByteBuffer blob);
+
+        static long contextNew() {
+            return NativeLib_contextNew();
+        }
 
-        ByteBuffer parseToDirectByteBuffer(String path) {
+        ByteBuffer parseToDirectByteBuffer(long context, String path, long maxBytes, boolean includes) {
             Objects.requireNonNull(path);
-            ByteBuffer b = NativeLib_parseToDirectByteBuffer(path);
+            return track(NativeLib_parseToDirectByteBuffer(context, path, maxBytes, includes));
+        }
+
+        ByteBuffer parseDirectBytes(long context, ByteBuffer src, int offset, int length, long maxBytes) {
+            return track(NativeLib_parseDirectBytes(context, src, offset, length, maxBytes));
+        }
+
+        ByteBuffer parseByteArray(long context, byte[] src, int offset, int length, long maxBytes) {
+            return track(NativeLib_parseByteArray(context, src, offset, length, maxBytes));
+        }
+
+        private ByteBuffer track(ByteBuffer b) {
             if (b != null) {
-                // store the exact object returned by JNI so close() can free it
+                // keep the exact object returned by JNI reachable and register its base address for release
                 this.directBuffer = b;
+                this.cleanable = CLEANER.register(b, new BlobReleaser(NativeLib_blobAddress(b)));
             }
             return b;
         }
 
-        byte[] parseToByteArray(String path) {
+        byte[] parseToByteArray(long context, String path, long maxBytes, boolean includes) {
             Objects.requireNonNull(path);
-            return NativeLib_parseToByteArray(path);
+            return NativeLib_parseToByteArray(context, path, maxBytes, includes);
+        }
+
+        static long compileToFile(String path, String blobPath, long maxBytes, boolean includes) {
+            return NativeLib_compileToFile(path, blobPath, maxBytes, includes);
+        }
+
+        static int[] walkDirect(ByteBuffer blob, int root, int maxDepth, long maxNodes) {
+            return NativeLib_walkDirect(blob, root, maxDepth, maxNodes);
+        }
+
+        static int[] walkArray(byte[] blob, int root, int maxDepth, long maxNodes) {
+            return NativeLib_walkArray(blob, root, maxDepth, maxNodes);
+        }
+
+        static int verifyDirect(ByteBuffer blob) {
+            return NativeLib_verifyDirect(blob);
         }
 
         @Override
         public void close() {
-            if (directBuffer != null) {
-                // call native free on the original DirectByteBuffer object
-                NativeLib_freeBlob(directBuffer);
-                directBuffer = null;
+            if (cleanable != null) {
+                // Cleanable.clean() runs the release at most once, even if the Cleaner already did
+                cleanable.clean();
+                cleanable = null;
+            }
+            directBuffer = null;
+        }
+
+        // Cleaner state: must not reference the buffer or the NativeBlob, only the raw address
+        private static final class BlobReleaser implements Runnable {
+            private final long address;
+
+            BlobReleaser(long address) {
+                this.address = address;
+            }
+
+            @Override
+            public void run() {
+                NativeLib_freeBlob(address);
+            }
+        }
+
+        // Cleaner state for the parse context: only the raw handle
+        static final class ContextReleaser implements Runnable {
+            private final long context;
+
+            ContextReleaser(long context) {
+                this.context = context;
+            }
+
+            @Override
+            public void run() {
+                NativeLib_contextFree(context);
             }
         }
     }
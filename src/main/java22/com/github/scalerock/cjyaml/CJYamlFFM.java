@@ -0,0 +1,426 @@
+package com.github.scalerock.cjyaml;
+
+import org.jetbrains.annotations.NotNull;
+import org.jetbrains.annotations.Nullable;
+
+import java.lang.foreign.Arena;
+import java.lang.foreign.FunctionDescriptor;
+import java.lang.foreign.Linker;
+import java.lang.foreign.MemoryLayout;
+import java.lang.foreign.MemorySegment;
+import java.lang.foreign.SymbolLookup;
+import java.lang.foreign.ValueLayout;
+import java.lang.invoke.MethodHandle;
+import java.lang.ref.Cleaner;
+import java.nio.ByteOrder;
+import java.nio.charset.StandardCharsets;
+import java.util.ArrayList;
+import java.util.LinkedHashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.Objects;
+
+/**
+ * FFM (java.lang.foreign) binding for CJYaml, available on JDK 22+.
+ * The native blob is exposed as a {@link MemorySegment} addressed with 64-bit offsets,
+ * so blobs larger than 2 GB can be read, and the C API is called through downcall handles
+ * instead of JNI. The JNI based {@link CJYaml} remains the binding for JDK 11.
+ * Usage:
+ * try (CJYamlFFM parser = new CJYamlFFM()) {
+ *     parser.parseFile(path);
+ *     Object root = parser.parseRoot();
+ * } // native blob freed automatically
+ * A forgotten close() is covered by a Cleaner, which frees the blob once the instance is unreachable.
+ * Like {@link CJYaml}, an instance reuses one native parse context across parseFile calls (one instance per thread).
+ * Requires --enable-native-access=ALL-UNNAMED (or the module name) to avoid restricted-method warnings.
+ */
+public final class CJYamlFFM implements AutoCloseable {
+
+    // sizes from C structs
+    private static final long NODE_ENTRY_SIZE = 20; // packed: 1 + 1 + 2 + 8 + 8
+    private static final long PAIR_ENTRY_SIZE = 8;  // two uint32
+    private static final long INDEX_ENTRY_SIZE = 4; // uint32
+    private static final int SCALAR_NULL = 0x8;     // style_flags bit 3
+    private static final int MAPPING_MERGE = 0x1;   // MAPPING style_flags: first pair is a '<<' merge link
+    private static final int PARSE_INCLUDES = 0x4;  // cjyaml_parse_options.flags: CJYAML_PARSE_INCLUDES
+    // status codes returned by the native calls (CJYAML_E* in CJYaml.h)
+    private static final int STATUS_EDEPTH = -2;    // nesting deeper than max_depth
+    private static final int STATUS_EBUDGET = -3;   // expansion budget (max_nodes) exhausted
+    private static final int STATUS_ECYCLE = -4;    // a collection contains itself
+    private static final int STATUS_ERANGE = -5;    // output buffer too small, required size still reported
+    private static final int STATUS_ENOMEM = -6;    // native allocation failed
+    private static final int STATUS_ELIMIT = -7;    // parse needed more than max_bytes
+
+    private static final ValueLayout.OfByte U8 = ValueLayout.JAVA_BYTE;
+    private static final ValueLayout.OfShort U16 = ValueLayout.JAVA_SHORT_UNALIGNED.withOrder(ByteOrder.LITTLE_ENDIAN);
+    private static final ValueLayout.OfInt U32 = ValueLayout.JAVA_INT_UNALIGNED.withOrder(ByteOrder.LITTLE_ENDIAN);
+    private static final ValueLayout.OfLong U64 = ValueLayout.JAVA_LONG_UNALIGNED.withOrder(ByteOrder.LITTLE_ENDIAN);
+    // struct cjyaml_walk_limits { uint32_t max_depth; uint64_t max_nodes; } (natural alignment)
+    private static final MemoryLayout WALK_LIMITS = MemoryLayout.structLayout(
+            ValueLayout.JAVA_INT.withName("max_depth"),
+            MemoryLayout.paddingLayout(4),
+            ValueLayout.JAVA_LONG.withName("max_nodes"));
+    // struct cjyaml_parse_options { size_t max_bytes; uint32_t flags; cjyaml_parse_stats *stats;
+    //                               const cjyaml_allocator *allocator; uint32_t include_threads; }
+    private static final MemoryLayout PARSE_OPTIONS = MemoryLayout.structLayout(
+            ValueLayout.JAVA_LONG.withName("max_bytes"),
+            ValueLayout.JAVA_INT.withName("flags"),
+            MemoryLayout.paddingLayout(4),
+            ValueLayout.ADDRESS.withName("stats"),
+            ValueLayout.ADDRESS.withName("allocator"),
+            ValueLayout.JAVA_INT.withName("include_threads"),
+            MemoryLayout.paddingLayout(4));
+
+    // arena owning the native blob; closing it calls cjyaml_free_blob
+    private Arena arena = null;
+    // closes the arena on close() or once this instance becomes unreachable
+    private Cleaner.Cleanable cleanable = null;
+    private MemorySegment blob = null;
+    private CJYaml.Header header = null;
+    // node and string table slices of the blob, cut once from the header; the blob comes from the native parser,
+    // so node and string references stay inside them and reads need no range checks beyond the segment's own
+    private MemorySegment nodeTable = null;
+    private MemorySegment stringTable = null;
+    // traversal limits for cjyaml_walk_events (<= 0: native defaults)
+    private int maxDepth = 0;
+    private long maxNodes = 0;
+    // native memory budget of one parse (<= 0: unlimited)
+    private long maxBytes = 0;
+    // resolve !include (CJYAML_PARSE_INCLUDES)
+    private boolean includes = false;
+    // reusable cjyaml_context, created by the first parse and freed by close() (or the Cleaner)
+    private MemorySegment context = null;
+    private Cleaner.Cleanable contextCleanable = null;
+
+    public CJYamlFFM() {
+        Native.init();
+    }
+
+    /**
+     * Same budget as {@link CJYaml#setMaxBytes(long)}.
+     */
+    public void setMaxBytes(long maxBytes) {
+        this.maxBytes = maxBytes;
+    }
+
+    /**
+     * Same as {@link CJYaml#setIncludes(boolean)}: off by default.
+     */
+    public void setIncludes(boolean includes) {
+        this.includes = includes;
+    }
+
+    /**
+     * Parse a YAML file into a native blob mapped as a MemorySegment.
+     * Previously parsed data is released first.
+     *
+     * @param path path to file
+     */
+    public void parseFile(String path) {
+        Objects.requireNonNull(path, "path must not be null");
+        releaseBlob();
+        MemorySegment ctx = context();
+
+        Arena owner = Arena.ofShared();
+        try (Arena tmp = Arena.ofConfined()) {
+            MemorySegment cpath = tmp.allocateFrom(path);
+            MemorySegment options = tmp.allocate(PARSE_OPTIONS); // zeroed: default flags, no stats, malloc
+            options.set(ValueLayout.JAVA_LONG, 0, Math.max(0, maxBytes));
+            options.set(ValueLayout.JAVA_INT, 8, includes ? PARSE_INCLUDES : 0);
+            MemorySegment outBlob = tmp.allocate(ValueLayout.ADDRESS);
+            MemorySegment outSize = tmp.allocate(Native.SIZE_T);
+            int status = (int) Native.PARSE_FILE.invokeExact(ctx, cpath, options, outBlob, outSize);
+            MemorySegment raw = outBlob.get(ValueLayout.ADDRESS, 0);
+            if (status != 0 || raw.equals(MemorySegment.NULL)) {
+                if (status == STATUS_ENOMEM) throw new OutOfMemoryError("native allocation failed while parsing " + path);
+                if (status == STATUS_ELIMIT) throw new IllegalStateException("YAML exceeds the parser memory budget (maxBytes): " + path);
+                throw new IllegalStateException("Failed to parse: " + path);
+            }
+            long size = outSize.get(ValueLayout.JAVA_LONG, 0);
+            blob = raw.reinterpret(size, owner, CJYamlFFM::freeBlob);
+            arena = owner;
+            cleanable = CJYaml.CLEANER.register(this, owner::close); // must not capture 'this'
+        } catch (RuntimeException | Error e) {
+            if (arena == null) owner.close();
+            throw e;
+        } catch (Throwable t) {
+            if (arena == null) owner.close();
+            throw new IllegalStateException("Native call failed", t);
+        }
+        header = null;
+        nodeTable = null;
+        stringTable = null;
+    }
+
+    /**
+     * @return read-only view of the parsed blob, or null if nothing is loaded
+     */
+    public @Nullable MemorySegment segment() {
+        return blob == null ? null : blob.asReadOnly();
+    }
+
+    /**
+     * Return typed Header object parsed from the blob.
+     * If no data parsed returns null.
+     *
+     * @return Header or null
+     */
+    public @Nullable CJYaml.Header getHeader() {
+        if (header != null) return header;
+        if (blob == null || blob.byteSize() < CJYaml.Header.HEADER_SIZE) return null;
+
+        CJYaml.Header h = new CJYaml.Header();
+        h.magic = Integer.toUnsignedLong(blob.get(U32, 0));
+        h.version = Short.toUnsignedInt(blob.get(U16, 4));
+        h.flags = Integer.toUnsignedLong(blob.get(U32, 6));
+
+        h.node_table_offset = blob.get(U64, 10);
+        h.node_count = blob.get(U64, 18);
+
+        h.pair_table_offset = blob.get(U64, 26);
+        h.pair_count = blob.get(U64, 34);
+
+        h.index_table_offset = blob.get(U64, 42);
+        h.index_count = blob.get(U64, 50);
+
+        h.hash_index_offset = blob.get(U64, 58);
+        h.hash_index_size = blob.get(U64, 66);
+
+        h.string_table_offset = blob.get(U64, 74);
+        h.string_table_size = blob.get(U64, 82);
+
+        h.value_table_offset = blob.get(U64, 90);
+        h.value_count = blob.get(U64, 98);
+
+        h.tag_table_offset = blob.get(U64, 106);
+        h.tag_count = blob.get(U64, 114);
+
+        header = h;
+        return header;
+    }
+
+    /**
+     * Parse the document root and return a Java object representation,
+     * with the same mapping as {@link CJYaml#parseRoot()}.
+     */
+    public @Nullable Object parseRoot() {
+        CJYaml.Header h = getHeader();
+        if (h == null) return null;
+
+        for (long i = h.node_count - 1; i >= 0; --i) { // the DOCUMENT node is written last
+            if (nodeType(i) == 4) { // DOCUMENT
+                return parseNode(nodeA(i));
+            }
+        }
+        return parseNode(0);
+    }
+
+    /**
+     * Same limits as {@link CJYaml#setTraversalLimits(int, long)}.
+     */
+    public void setTraversalLimits(int maxDepth, long maxNodes) {
+        this.maxDepth = maxDepth;
+        this.maxNodes = maxNodes;
+    }
+
+    // node table slice; an index outside it fails the segment's bounds check (IndexOutOfBoundsException)
+    private @NotNull MemorySegment nodes() {
+        if (nodeTable == null) {
+            CJYaml.Header h = getHeader();
+            if (h == null) throw new IllegalStateException("No blob loaded");
+            nodeTable = blob.asSlice(h.node_table_offset, h.node_count * NODE_ENTRY_SIZE);
+            stringTable = blob.asSlice(h.string_table_offset, h.string_table_size);
+        }
+        return nodeTable;
+    }
+
+    private int nodeType(long nodeIndex) {
+        return Byte.toUnsignedInt(nodes().get(U8, nodeIndex * NODE_ENTRY_SIZE));
+    }
+
+    private int nodeFlags(long nodeIndex) {
+        return Byte.toUnsignedInt(nodes().get(U8, nodeIndex * NODE_ENTRY_SIZE + 1));
+    }
+
+    private long nodeA(long nodeIndex) {
+        return nodes().get(U64, nodeIndex * NODE_ENTRY_SIZE + 4);
+    }
+
+    private long nodeB(long nodeIndex) {
+        return nodes().get(U64, nodeIndex * NODE_ENTRY_SIZE + 12);
+    }
+
+    private @NotNull String readString(long strOffset, long len) {
+        nodes(); // cuts stringTable too
+        byte[] tmp = stringTable.asSlice(strOffset, len).toArray(U8);
+        return new String(tmp, StandardCharsets.UTF_8);
+    }
+
+    /**
+     * Convert a single node (and its children) to Java objects, walked natively by cjyaml_walk_events
+     * with the configured traversal limits.
+     */
+    public @Nullable Object parseNode(long nodeIndex) {
+        if (getHeader() == null) return null;
+        return CJYaml.materialize(walk(nodeIndex), new CJYaml.NodeSource() {
+            @Override
+            public @Nullable Object scalar(int node) {
+                long n = Integer.toUnsignedLong(node);
+                if ((nodeFlags(n) & SCALAR_NULL) != 0) return null;
+                return readString(nodeA(n), nodeB(n));
+            }
+
+            @Override
+            public boolean isMergeMapping(int node) {
+                return (nodeFlags(Integer.toUnsignedLong(node)) & MAPPING_MERGE) != 0;
+            }
+        });
+    }
+
+    // (event, node) pairs of the subtree; sized by a first guess and retried once with the reported count
+    private int @NotNull [] walk(long nodeIndex) {
+        long cap = Math.max(16, getHeader().node_count * 2);
+        try (Arena tmp = Arena.ofConfined()) {
+            MemorySegment limits = tmp.allocate(WALK_LIMITS);
+            limits.set(ValueLayout.JAVA_INT, 0, Math.max(0, maxDepth));
+            limits.set(ValueLayout.JAVA_LONG, 8, Math.max(0, maxNodes));
+            MemorySegment outCount = tmp.allocate(Native.SIZE_T);
+            for (int attempt = 0; attempt < 2; ++attempt) {
+                MemorySegment out = tmp.allocate(ValueLayout.JAVA_INT, cap * 2);
+                int rc = (int) Native.WALK_EVENTS.invokeExact(blob, blob.byteSize(), (int) nodeIndex, limits, out, cap, outCount);
+                long count = outCount.get(ValueLayout.JAVA_LONG, 0);
+                if (rc == 0) return out.asSlice(0, count * 2 * Integer.BYTES).toArray(ValueLayout.JAVA_INT);
+                if (rc != STATUS_ERANGE || count > Integer.MAX_VALUE / 2) throw new IllegalStateException(walkError(rc));
+                cap = count; // required size
+            }
+        } catch (RuntimeException | Error e) {
+            throw e;
+        } catch (Throwable t) {
+            throw new IllegalStateException("Native call failed", t);
+        }
+        throw new IllegalStateException("cjyaml_walk_events: event count changed between calls");
+    }
+
+    private static String walkError(int rc) {
+        switch (rc) {
+            case STATUS_EDEPTH: return "max depth exceeded";
+            case STATUS_EBUDGET: return "node expansion budget exceeded (alias bomb?)";
+            case STATUS_ECYCLE: return "cyclic node graph";
+            default: return "invalid blob or node index";
+        }
+    }
+
+    /**
+     * Free the native blob and the parse context kept for reuse (if any). Safe to call multiple times.
+     */
+    @Override
+    public void close() {
+        try {
+            releaseBlob();
+        } finally {
+            if (contextCleanable != null) {
+                contextCleanable.clean();
+                contextCleanable = null;
+            }
+            context = null;
+        }
+    }
+
+    // the parse context of this instance, created on first use
+    private MemorySegment context() {
+        if (context == null) {
+            MemorySegment handle;
+            try {
+                handle = (MemorySegment) Native.CONTEXT_NEW.invokeExact();
+            } catch (Throwable t) {
+                throw new IllegalStateException("cjyaml_context_new failed", t);
+            }
+            if (handle.equals(MemorySegment.NULL)) throw new OutOfMemoryError("cjyaml_context_new failed");
+            contextCleanable = CJYaml.CLEANER.register(this, () -> freeContext(handle)); // must not capture 'this'
+            context = handle;
+        }
+        return context;
+    }
+
+    private static void freeContext(MemorySegment handle) {
+        try {
+            Native.CONTEXT_FREE.invokeExact(handle);
+        } catch (Throwable t) {
+            throw new IllegalStateException("cjyaml_context_free failed", t);
+        }
+    }
+
+    // free the parsed blob, keep the context
+    private void releaseBlob() {
+        if (cleanable != null) {
+            try {
+                cleanable.clean(); // closes the arena -> cjyaml_free_blob via the segment cleanup action
+            } finally {
+                cleanable = null;
+                arena = null;
+            }
+        }
+        blob = null;
+        header = null;
+        nodeTable = null;
+        stringTable = null;
+    }
+
+    private static void freeBlob(MemorySegment segment) {
+        try {
+            Native.FREE_BLOB.invokeExact(segment);
+        } catch (Throwable t) {
+            throw new IllegalStateException("cjyaml_free_blob failed", t);
+        }
+    }
+
+    // -----------------------------
+    // Downcall handles (resolved once per JVM)
+    // -----------------------------
+    private static final class Native {
+        static final ValueLayout SIZE_T;
+        // int cjyaml_context_parse_file(cjyaml_context *ctx, const char *path, const cjyaml_parse_options *options,
+        //                               unsigned char **out_blob, size_t *out_size)
+        static final MethodHandle PARSE_FILE;
+        static final MethodHandle CONTEXT_NEW;  // cjyaml_context *cjyaml_context_new(void)
+        static final MethodHandle CONTEXT_FREE; // void cjyaml_context_free(cjyaml_context *ctx)
+        static final MethodHandle FREE_BLOB;   // void cjyaml_free_blob(void *blob)
+        // int cjyaml_walk_events(const void *blob, size_t blob_size, uint32_t root, const cjyaml_walk_limits *limits,
+        //                        uint32_t *out, size_t cap, size_t *out_count)
+        static final MethodHandle WALK_EVENTS;
+
+        static {
+            CJYaml.ensureNativeLoaded(); // System.load() makes the symbols visible to loaderLookup()
+
+            Linker linker = Linker.nativeLinker();
+            MemoryLayout sizeT = linker.canonicalLayouts().get("size_t");
+            if (sizeT.byteSize() != Long.BYTES) {
+                throw new UnsupportedOperationException("CJYamlFFM requires a 64-bit size_t");
+            }
+            SIZE_T = (ValueLayout) sizeT;
+
+            SymbolLookup lookup = SymbolLookup.loaderLookup();
+            PARSE_FILE = linker.downcallHandle(
+                    lookup.find("cjyaml_context_parse_file").orElseThrow(),
+                    FunctionDescriptor.of(ValueLayout.JAVA_INT, ValueLayout.ADDRESS, ValueLayout.ADDRESS, ValueLayout.ADDRESS,
+                            ValueLayout.ADDRESS, ValueLayout.ADDRESS));
+            CONTEXT_NEW = linker.downcallHandle(
+                    lookup.find("cjyaml_context_new").orElseThrow(),
+                    FunctionDescriptor.of(ValueLayout.ADDRESS));
+            CONTEXT_FREE = linker.downcallHandle(
+                    lookup.find("cjyaml_context_free").orElseThrow(),
+                    FunctionDescriptor.ofVoid(ValueLayout.ADDRESS));
+            FREE_BLOB = linker.downcallHandle(
+                    lookup.find("cjyaml_free_blob").orElseThrow(),
+                    FunctionDescriptor.ofVoid(ValueLayout.ADDRESS));
+            WALK_EVENTS = linker.downcallHandle(
+                    lookup.find("cjyaml_walk_events").orElseThrow(),
+                    FunctionDescriptor.of(ValueLayout.JAVA_INT, ValueLayout.ADDRESS, ValueLayout.JAVA_LONG, ValueLayout.JAVA_INT,
+                            ValueLayout.ADDRESS, ValueLayout.ADDRESS, ValueLayout.JAVA_LONG, ValueLayout.ADDRESS));
+        }
+
+        static void init() {
+            // triggers class initialization
+        }
+    }
+}